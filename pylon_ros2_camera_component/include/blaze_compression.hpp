@@ -0,0 +1,174 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include "pylon_ros2_camera_interfaces/msg/compressed_blaze_data.hpp"
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Encoding and decoding of the compressed blaze data (CompressedBlazeData message).
+ * This part is built as a small library of its own, so that consumers can decode
+ * the data without depending on pylon.
+ */
+namespace blaze_compression
+{
+
+using CompressedBlazeData = pylon_ros2_camera_interfaces::msg::CompressedBlazeData;
+
+// quantized coordinate of an invalid point
+static const int16_t INVALID_COORDINATE = -32768;
+
+/**
+ * Quantizes a float coordinate (in m) of organized points to steps of quantization mm and
+ * writes the residuals of its prediction as 2 byte planes (2 * width * height bytes).
+ * @param coordinates pointer to the coordinate of the first point
+ * @param point_step distance between two points in bytes
+ * @param quantization quantization step in mm, > 0
+ */
+void encodeCoordinate(const uint8_t* coordinates, size_t point_step, size_t width, size_t height,
+                      float quantization, uint8_t* planes);
+
+/**
+ * Writes the residuals of the prediction of a float coordinate, lossless, as 4 byte planes (4 * width * height bytes).
+ */
+void encodeCoordinate(const uint8_t* coordinates, size_t point_step, size_t width, size_t height, uint8_t* planes);
+
+/**
+ * Writes the residuals of the prediction of 16 bit values (rows of step bytes) as 2 byte planes (2 * width * height bytes).
+ */
+void encodeValues(const uint8_t* values, size_t step, size_t width, size_t height, uint8_t* planes);
+
+/**
+ * Inverse of encodeCoordinate(), the coordinate is written in m (NaN for an invalid point).
+ * @param quantization quantization step in mm, 0 for the lossless float coordinates
+ */
+void decodeCoordinate(const uint8_t* planes, size_t width, size_t height, float quantization,
+                      uint8_t* coordinates, size_t point_step);
+
+/**
+ * Inverse of encodeValues()
+ * @param pixel_step distance between two values of a row in bytes
+ */
+void decodeValues(const uint8_t* planes, size_t width, size_t height, uint8_t* values, size_t step,
+                  size_t pixel_step = sizeof(uint16_t));
+
+/**
+ * Size in bytes of the byte planes of a channel
+ */
+size_t planesSize(const CompressedBlazeData& msg, const bool& is_coordinate);
+
+/**
+ * lz4 and zstd compression, the contexts are kept from call to call.
+ * An instance must not be used from several threads at the same time.
+ */
+class Codec
+{
+
+public:
+    Codec();
+
+    virtual ~Codec();
+
+    Codec(const Codec&) = delete;
+    Codec& operator=(const Codec&) = delete;
+
+    /**
+     * Compresses size bytes of src into dst, which is resized to the compressed size
+     * @param codec CompressedBlazeData::CODEC_LZ4 or CompressedBlazeData::CODEC_ZSTD
+     * @param level compression level for zstd, acceleration for lz4
+     */
+    bool compress(const uint8_t& codec, const int& level, const uint8_t* src, const size_t& size, std::vector<uint8_t>& dst);
+
+    /**
+     * Decompresses src into exactly size bytes of dst
+     */
+    bool decompress(const uint8_t& codec, const std::vector<uint8_t>& src, uint8_t* dst, const size_t& size);
+
+private:
+    ZSTD_CCtx_s* zstd_cctx_;
+    ZSTD_DCtx_s* zstd_dctx_;
+};
+
+/**
+ * Decoder of CompressedBlazeData messages. The channels are decoded directly into
+ * the buffers of the caller, only the decompressed byte planes of one channel are
+ * buffered, and this buffer keeps its capacity from message to message.
+ */
+class Decoder
+{
+
+public:
+    /**
+     * Decodes the point coordinates (float, in m) into organized points, e.g., the data of a point cloud
+     * @param points pointer to the x coordinate of the first point, y and z following it
+     * @param point_step distance between two points in bytes
+     */
+    bool decodePoints(const CompressedBlazeData& msg, uint8_t* points, const size_t& point_step);
+
+    /**
+     * Decodes the intensity (16 bit values) into rows of step bytes
+     * @param pixel_step distance between two values of a row in bytes
+     */
+    bool decodeIntensity(const CompressedBlazeData& msg, uint8_t* intensity, const size_t& step, const size_t& pixel_step = sizeof(uint16_t));
+
+    /**
+     * Decodes the confidence (16 bit values) into rows of step bytes
+     * @param pixel_step distance between two values of a row in bytes
+     */
+    bool decodeConfidence(const CompressedBlazeData& msg, uint8_t* confidence, const size_t& step, const size_t& pixel_step = sizeof(uint16_t));
+
+    /**
+     * Decodes the whole data set into an organized point cloud with the fields
+     * x, y, z (float32, in m), intensity and confidence (uint16)
+     */
+    bool decode(const CompressedBlazeData& msg, sensor_msgs::msg::PointCloud2& cloud);
+
+private:
+    bool decompressChannel(const CompressedBlazeData& msg, const std::vector<uint8_t>& channel, const bool& is_coordinate);
+
+    Codec codec_;
+
+    std::vector<uint8_t> planes_;
+};
+
+}  // namespace blaze_compression
+
+}  // namespace pylon_ros2_camera
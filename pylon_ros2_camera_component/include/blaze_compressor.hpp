@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <rclcpp/clock.hpp>
+#include <sensor_msgs/msg/image.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include "blaze_compression.hpp"
+#include "ordered_worker_pool.hpp"
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Compressed output of the blaze data. The channels of a frame (x, y, z, intensity, confidence)
+ * are only copied on the calling thread, then quantized, predicted and compressed in parallel
+ * by a pool of worker threads. The frames are published in order.
+ */
+class BlazeCompressor
+{
+
+public:
+    using PublishFunction = std::function<void(const blaze_compression::CompressedBlazeData&)>;
+
+    BlazeCompressor();
+
+    virtual ~BlazeCompressor();
+
+    /**
+     * Starts the worker threads
+     * @param codec "lz4" or "zstd"
+     * @param level compression level for zstd, acceleration for lz4
+     * @param quantization quantization step of the coordinates in mm, 0 for the lossless float coordinates
+     * @param threads number of worker threads
+     * @param thread_setup called first in each worker thread, e.g., to set its scheduling
+     * @param publish called with each compressed frame, in the order of the frames, from a worker thread
+     * @return false if the codec is unknown
+     */
+    bool start(const std::string& codec, const int& level, const float& quantization, const int& threads,
+               const std::function<void()>& thread_setup, const PublishFunction& publish);
+
+    /**
+     * Stops the worker threads, the frames being compressed are dropped
+     */
+    void stop();
+
+    bool isStarted() const;
+
+    /**
+     * Copies the channels of a frame and queues their compression, without waiting for it.
+     * The frame is dropped if all frame slots are in use, so that the acquisition is never blocked.
+     * @param cloud the point cloud (x, y, z fields in m)
+     * @param intensity_map the 16 bit intensity map
+     * @param confidence_map the 16 bit confidence map
+     * @return false if the frame is dropped
+     */
+    bool post(const sensor_msgs::msg::PointCloud2& cloud,
+              const sensor_msgs::msg::Image& intensity_map,
+              const sensor_msgs::msg::Image& confidence_map);
+
+private:
+    static const int NR_CHANNELS = 5;
+
+    struct Frame
+    {
+        blaze_compression::CompressedBlazeData msg;
+        // copies of the channels (float coordinates, 16 bit values) and their byte planes,
+        // the buffers keep their capacity from frame to frame
+        std::array<std::vector<uint8_t>, NR_CHANNELS> channels;
+        std::array<std::vector<uint8_t>, NR_CHANNELS> planes;
+    };
+
+    /**
+     * Quantizes, predicts and compresses a channel of the frame
+     */
+    bool compress(Frame& frame, const int& channel, blaze_compression::Codec& codec);
+
+    std::vector<uint8_t>& compressedChannel(Frame& frame, const int& index);
+
+    uint8_t codec_;
+    int level_;
+    float quantization_;
+    PublishFunction publish_;
+
+    // one part per channel, each worker has its own compression contexts
+    OrderedWorkerPool<Frame, blaze_compression::Codec> pool_;
+
+    rclcpp::Clock clock_;
+};
+
+}  // namespace pylon_ros2_camera
@@ -0,0 +1,194 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include <cv_bridge/cv_bridge.h>
+#include <opencv2/core/core.hpp>
+#include <rclcpp/type_adapter.hpp>
+#include <sensor_msgs/msg/image.hpp>
+#include <std_msgs/msg/header.hpp>
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * An image as cv::Mat, published by the camera node through an rclcpp type adapter (REP 2007)
+ * if intra_process_images is set. The subscribers of the same process (intra-process
+ * communication enabled) receive it without serialization nor conversion, the other ones
+ * receive a sensor_msgs/Image. A subscriber of the same process subscribes with this type:
+ *
+ *   create_subscription<pylon_ros2_camera::CvMatImage>("image_raw", 10,
+ *       [](std::unique_ptr<pylon_ros2_camera::CvMatImage> image) { ... image->image ... });
+ */
+struct CvMatImage
+{
+    std_msgs::msg::Header header;
+    // ROS image encoding, e.g., mono8 or bayer_rggb8
+    std::string encoding;
+    // the image, its data being owned by memory if set, by the cv::Mat itself otherwise
+    cv::Mat image;
+    // keeps the (pooled) frame memory the image points to while the image is used
+    std::shared_ptr<const void> memory;
+
+    // The images are published as std::unique_ptr and deleted by the subscribers: their
+    // memory is recycled, so that publishing an image does not allocate once the pool is filled.
+    static void* operator new(std::size_t size);
+    static void operator delete(void* ptr, std::size_t size);
+    // the class operator new hides the placement new, which is still used to construct images in place
+    static void* operator new(std::size_t, void* ptr) noexcept { return ptr; }
+    static void operator delete(void*, void*) noexcept {}
+};
+
+/**
+ * Memory of the deleted CvMatImage objects, reused by the next ones. Thread safe, the
+ * images are deleted by the subscriber threads.
+ */
+class CvMatImagePool
+{
+public:
+    static CvMatImagePool& instance()
+    {
+        // never destroyed, images may be deleted by the subscribers after the static objects
+        static CvMatImagePool* pool = new CvMatImagePool();
+        return *pool;
+    }
+
+    void* acquire()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (size_ > 0)
+            {
+                return blocks_[--size_];
+            }
+        }
+        return ::operator new(sizeof(CvMatImage));
+    }
+
+    void release(void* block)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (size_ < MAX_SIZE)
+            {
+                blocks_[size_++] = block;
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+private:
+    CvMatImagePool() : mutex_(), blocks_(), size_(0) {}
+
+    // as many images as the frame memory pool of the node can hand over
+    static constexpr std::size_t MAX_SIZE = 16;
+
+    std::mutex mutex_;
+    void* blocks_[MAX_SIZE];
+    std::size_t size_;
+};
+
+// the blocks of the pool are plain allocations of the size of the image: an image allocated by
+// rclcpp itself (e.g., a copy for a second subscriber) can be released into the pool as well
+inline void* CvMatImage::operator new(std::size_t size)
+{
+    return size == sizeof(CvMatImage) ? CvMatImagePool::instance().acquire() : ::operator new(size);
+}
+
+inline void CvMatImage::operator delete(void* ptr, std::size_t size)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    if (size == sizeof(CvMatImage))
+    {
+        CvMatImagePool::instance().release(ptr);
+    }
+    else
+    {
+        ::operator delete(ptr);
+    }
+}
+
+}  // namespace pylon_ros2_camera
+
+template<>
+struct rclcpp::TypeAdapter<pylon_ros2_camera::CvMatImage, sensor_msgs::msg::Image>
+{
+    using is_specialized = std::true_type;
+    using custom_type = pylon_ros2_camera::CvMatImage;
+    using ros_message_type = sensor_msgs::msg::Image;
+
+    static void convert_to_ros_message(const custom_type& source, ros_message_type& destination)
+    {
+        destination.header = source.header;
+        destination.height = source.image.rows;
+        destination.width = source.image.cols;
+        destination.encoding = source.encoding;
+        destination.is_bigendian = false;
+        destination.step = static_cast<uint32_t>(source.image.cols * source.image.elemSize());
+        destination.data.resize(static_cast<size_t>(destination.step) * destination.height);
+
+        if (source.image.isContinuous())
+        {
+            std::memcpy(destination.data.data(), source.image.data, destination.data.size());
+        }
+        else
+        {
+            for (int row = 0; row < source.image.rows; ++row)
+            {
+                std::memcpy(destination.data.data() + row * destination.step, source.image.ptr(row), destination.step);
+            }
+        }
+    }
+
+    static void convert_to_custom(const ros_message_type& source, custom_type& destination)
+    {
+        destination.header = source.header;
+        destination.encoding = source.encoding;
+        // the message may not outlive the call, its data is copied
+        const cv::Mat image(source.height, source.width, cv_bridge::getCvType(source.encoding),
+                            const_cast<uint8_t*>(source.data.data()), source.step);
+        image.copyTo(destination.image);
+        destination.memory.reset();
+    }
+};
+
+RCLCPP_USING_CUSTOM_TYPE_AS_ROS_MESSAGE_TYPE(pylon_ros2_camera::CvMatImage, sensor_msgs::msg::Image);
@@ -65,6 +65,12 @@ namespace encodingconversions
     bool is_12_bit_gen_api_enc(const std::string& gen_api_enc);
     bool is_12_bit_ros_enc(const std::string& ros_enc);
 
+    /**
+     * Returns the OpenCV conversion code of a Bayer encoding from the sensor_msgs/image_encodings.h
+     * list into BGR, or -1 if the encoding is not a Bayer one.
+     */
+    int bayer2OpenCVCode(const std::string& ros_enc);
+
 }  // namespace encodingconversions
 
 }  // namespace pylon_ros2_camera
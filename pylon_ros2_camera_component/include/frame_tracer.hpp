@@ -0,0 +1,156 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Stages of the frame path, in processing order
+ */
+enum TRACE_STAGE
+{
+    TS_TRIGGER_ISSUED = 0,
+    TS_RESULT_RETRIEVED = 1,
+    TS_CONVERSION_START = 2,
+    TS_CONVERSION_END = 3,
+    TS_RECTIFICATION_START = 4,
+    TS_RECTIFICATION_END = 5,
+    TS_PUBLISHED = 6,
+    TS_COUNT = 7,
+};
+
+/**
+ * Lightweight built-in tracer of the frame path. The timestamps of the stages
+ * reached by the frame in progress are collected and, once the frame is done,
+ * stored in a fixed size ring buffer tagged with the camera frame counter.
+ * Only the stages marked between begin() and commit(), by the thread which called
+ * begin(), are recorded: the grabs of other paths (e.g. the grab actions) are ignored.
+ * Nothing is allocated while tracing.
+ */
+class FrameTracer
+{
+
+public:
+    /**
+     * @param capacity number of frames kept in the ring buffer, 0 disables the tracing
+     */
+    explicit FrameTracer(const size_t& capacity = 0);
+
+    virtual ~FrameTracer();
+
+    /**
+     * Resizes the ring buffer and drops the recorded frames
+     * @param capacity number of frames kept in the ring buffer, 0 disables the tracing
+     */
+    void setCapacity(const size_t& capacity);
+
+    /**
+     * Returns true if frames are traced
+     */
+    bool isEnabled() const;
+
+    /**
+     * Starts a new frame on the calling thread, the stages of a frame not committed are dropped
+     */
+    void begin();
+
+    /**
+     * Records the current time for the given stage of the frame in progress,
+     * if called by the thread which started the frame
+     */
+    void mark(const TRACE_STAGE& stage);
+
+    /**
+     * Stores the frame in progress in the ring buffer and ends it
+     * @param frame_counter the camera frame counter of the frame
+     */
+    void commit(const int64_t& frame_counter);
+
+    /**
+     * Builds the per-stage latency histograms of the frames in the ring buffer.
+     * The latency of a stage is measured from the previous stage reached by the frame.
+     * @return the histograms as human readable text
+     */
+    std::string dumpHistograms();
+
+private:
+    struct FrameTrace
+    {
+        int64_t frame_counter;
+        // steady clock time in ns, 0 if the stage was not reached
+        std::array<int64_t, TS_COUNT> stamps;
+    };
+
+    /**
+     * The frame in progress, only accessed by the grabbing thread
+     */
+    FrameTrace current_;
+
+    /**
+     * True between begin() and commit()
+     */
+    std::atomic<bool> is_in_progress_;
+
+    /**
+     * The thread which started the frame in progress
+     */
+    std::atomic<std::thread::id> owner_;
+
+    /**
+     * Ring buffer of the traced frames
+     */
+    std::vector<FrameTrace> ring_;
+
+    /**
+     * Index of the next slot to write in the ring buffer
+     */
+    size_t next_;
+
+    /**
+     * Number of valid frames in the ring buffer
+     */
+    size_t size_;
+
+    /**
+     * Protects the ring buffer against a concurrent dump
+     */
+    std::mutex mutex_;
+};
+
+}  // namespace pylon_ros2_camera
@@ -0,0 +1,116 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <rclcpp/clock.hpp>
+#include <sensor_msgs/msg/compressed_image.hpp>
+#include <sensor_msgs/msg/image.hpp>
+
+#include "ordered_worker_pool.hpp"
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Compressed image output encoded by a pool of worker threads, JPEG with libjpeg-turbo or PNG.
+ * The acquisition thread only copies the image into a free frame slot, the frames are
+ * encoded in parallel, one frame per worker, and published in order with their timestamps.
+ * The format strings follow compressed_image_transport, so that its subscribers can decode them.
+ */
+class ImageEncoderPool
+{
+
+public:
+    using PublishFunction = std::function<void(const sensor_msgs::msg::CompressedImage&)>;
+
+    ImageEncoderPool();
+
+    virtual ~ImageEncoderPool();
+
+    /**
+     * Starts the worker threads
+     * @param format "jpeg" or "png"
+     * @param jpeg_quality JPEG quality (1 - 100)
+     * @param png_level PNG compression level (0 - 9), low levels are faster
+     * @param threads number of worker threads
+     * @param thread_setup called first in each worker thread, e.g., to set its scheduling
+     * @param publish called with each compressed image, in the order of the images, from a worker thread
+     * @return false if the format is unknown
+     */
+    bool start(const std::string& format, const int& jpeg_quality, const int& png_level, const int& threads,
+               const std::function<void()>& thread_setup, const PublishFunction& publish);
+
+    /**
+     * Stops the worker threads, the images being encoded are dropped
+     */
+    void stop();
+
+    bool isStarted() const;
+
+    /**
+     * Copies the image into a free frame slot and queues its encoding, without waiting for it.
+     * The image is dropped if all frame slots are in use, so that the acquisition is never blocked.
+     * @return false if the image is dropped
+     */
+    bool post(const sensor_msgs::msg::Image& image);
+
+private:
+    struct Frame
+    {
+        // the buffers keep their capacity from frame to frame
+        sensor_msgs::msg::Image image;
+        sensor_msgs::msg::CompressedImage msg;
+        cv::Mat converted;
+    };
+
+    struct Worker;
+
+    /**
+     * Encodes the image of the frame into its message
+     */
+    bool encode(Frame& frame, Worker& worker);
+
+    bool is_jpeg_;
+    int jpeg_quality_;
+    int png_level_;
+    PublishFunction publish_;
+
+    // one part per frame
+    OrderedWorkerPool<Frame, Worker> pool_;
+
+    rclcpp::Clock clock_;
+};
+
+}  // namespace pylon_ros2_camera
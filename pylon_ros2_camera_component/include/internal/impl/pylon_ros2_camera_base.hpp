@@ -28,7 +28,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -86,6 +90,9 @@ bool PylonROS2CameraImpl<CameraTraitT>::registerCameraConfiguration()
         cam_->RegisterConfiguration(new Pylon::CSoftwareTriggerConfiguration,
                                         Pylon::RegistrationMode_ReplaceAll,
                                         Pylon::Cleanup_Delete);
+        cam_->RegisterConfiguration(new PylonROS2DeviceRemovalHandler(is_device_removed_),
+                                        Pylon::RegistrationMode_Append,
+                                        Pylon::Cleanup_Delete);
         return true;
     }
     catch (const GenICam::GenericException &e)
@@ -113,7 +120,110 @@ bool PylonROS2CameraImpl<CameraTraitT>::openCamera()
 template <typename CameraTraitT>
 bool PylonROS2CameraImpl<CameraTraitT>::isCamRemoved()
 {
-    return cam_->IsCameraDeviceRemoved();
+    return is_device_removed_ || cam_->IsCameraDeviceRemoved();
+}
+
+template <typename CameraTraitT>
+void PylonROS2CameraImpl<CameraTraitT>::releaseDevice()
+{
+    try
+    {
+        // closes the device and releases the pylon device object
+        cam_->DestroyDevice();
+    }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BASE, "An exception occurred while releasing the camera device: " << e.GetDescription());
+    }
+}
+
+template <typename CameraTraitT>
+bool PylonROS2CameraImpl<CameraTraitT>::restartStream(const STREAM_RECOVERY_STEP& step)
+{
+    try
+    {
+        // closes the stream grabber and releases its buffers, the next StartGrabbing
+        // reopens it with newly registered buffers
+        cam_->StopGrabbing();
+
+        if (step >= SRS_REOPEN_DEVICE)
+        {
+            // the camera keeps its configuration as long as it is powered
+            cam_->Close();
+            cam_->Open();
+        }
+
+        grabbingStarting();
+    }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BASE, "An exception occurred while restarting the image stream: " << e.GetDescription());
+        return false;
+    }
+
+    return cam_->IsGrabbing();
+}
+
+template <typename CameraTraitT>
+bool PylonROS2CameraImpl<CameraTraitT>::setInternalThreadPriority(const int& priority)
+{
+    bool success = false;
+    try
+    {
+        cam_->InternalGrabEngineThreadPriorityOverride.SetValue(true);
+        cam_->InternalGrabEngineThreadPriority.SetValue(priority);
+        success = true;
+    }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_WARN_STREAM(LOGGER_BASE, "The grab engine thread priority could not be set: " << e.GetDescription());
+    }
+
+    try
+    {
+        // the receive thread is only available in the stream grabber node map of GigE devices
+        GenApi::INodeMap& stream_params = cam_->GetStreamGrabberNodeMap();
+        if (Pylon::CBooleanParameter(stream_params, "ReceiveThreadPriorityOverride").TrySetValue(true) &&
+            Pylon::CIntegerParameter(stream_params, "ReceiveThreadPriority").TrySetValue(priority))
+        {
+            success = true;
+        }
+    }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_WARN_STREAM(LOGGER_BASE, "The receive thread priority could not be set: " << e.GetDescription());
+    }
+
+    if (success)
+    {
+        RCLCPP_INFO_STREAM(LOGGER_BASE, "Pylon internal thread priority set to " << priority);
+    }
+
+    return success;
+}
+
+template <typename CameraTraitT>
+bool PylonROS2CameraImpl<CameraTraitT>::setHeartbeatTimeout(const int& timeout_ms)
+{
+    try
+    {
+        // the heartbeat is only available in the transport layer node map of GigE devices
+        if (Pylon::CIntegerParameter(cam_->GetTLNodeMap(), "HeartbeatTimeout").TrySetValue(timeout_ms))
+        {
+            RCLCPP_INFO_STREAM(LOGGER_BASE, "Heartbeat timeout set to " << timeout_ms << " ms");
+            return true;
+        }
+        else
+        {
+            RCLCPP_WARN_STREAM(LOGGER_BASE, "The heartbeat timeout is not available for this camera");
+            return false;
+        }
+    }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BASE, "An exception occurred while setting the heartbeat timeout: " << e.GetDescription());
+        return false;
+    }
 }
 
 template <typename CameraTraitT>
@@ -180,13 +290,108 @@ size_t PylonROS2CameraImpl<CameraTraitT>::currentBinningY()
 }
 
 template <typename CameraTraitT>
-std::string PylonROS2CameraImpl<CameraTraitT>::currentROSEncoding() const
+bool PylonROS2CameraImpl<CameraTraitT>::updateEncodingCache() const
 {
+    const int64_t pixel_format = cam_->PixelFormat.GetIntValue();
+    if (pixel_format == cached_pixel_format_)
+    {
+        return true;
+    }
+
     std::string gen_api_encoding(cam_->PixelFormat.ToString().c_str());
     std::string ros_encoding("");
-    
     if (!encodingconversions::genAPI2Ros(gen_api_encoding, ros_encoding))
     {
+        return false;
+    }
+
+    cached_pixel_format_ = pixel_format;
+    cached_ros_encoding_ = ros_encoding;
+    // In case of 12 bits we need to shift the image bits 4 positions to the left
+    is_12_bit_shift_needed_ = encodingconversions::is_12_bit_ros_enc(ros_encoding) &&
+                              (gen_api_encoding == "BayerRG12" || gen_api_encoding == "BayerBG12" || gen_api_encoding == "BayerGB12" || gen_api_encoding == "BayerGR12" || gen_api_encoding == "Mono12");
+    // the sensor correction only applies to the mono and bayer formats
+    is_single_channel_ = sensor_msgs::image_encodings::numChannels(ros_encoding) == 1;
+    is_bayer_ = sensor_msgs::image_encodings::isBayer(ros_encoding);
+    // the tone mapped 12 bit formats are published in the 8 bit encoding of the same format (e.g., Mono12 -> mono8)
+    cached_tone_mapped_encoding_ = "";
+    if (is_12_bit_shift_needed_)
+    {
+        encodingconversions::genAPI2Ros(gen_api_encoding.substr(0, gen_api_encoding.size() - 2) + "8", cached_tone_mapped_encoding_);
+    }
+    return true;
+}
+
+template <typename CameraTraitT>
+bool PylonROS2CameraImpl<CameraTraitT>::isToneMapped() const
+{
+    return tone_mapping_ && tone_mapping_->isEnabled() && updateEncodingCache() &&
+           is_12_bit_shift_needed_ && !cached_tone_mapped_encoding_.empty();
+}
+
+template <typename CameraTraitT>
+void PylonROS2CameraImpl<CameraTraitT>::copyFrame(const uint8_t* src, uint8_t* dst)
+{
+    const bool is_tone_mapped = isToneMapped();
+
+    // the correction maps follow the sensor geometry, they are selected again after a ROI or binning change
+    if (sensor_correction_ && sensor_correction_->isEnabled() && is_sensor_geometry_changed_)
+    {
+        const sensor_msgs::msg::RegionOfInterest roi = currentROI();
+        sensor_correction_->select(deviceSerialNumber(), roi.width, roi.height, roi.x_offset, roi.y_offset,
+                                   currentBinningX(), currentBinningY());
+        is_sensor_geometry_changed_ = false;
+    }
+
+    const int pixel_depth = imagePixelDepth();
+    const bool is_corrected = sensor_correction_ && sensor_correction_->isEnabled() && sensor_correction_->isActive() &&
+                              is_single_channel_ && (pixel_depth == 1 || pixel_depth == 2) &&
+                              sensor_correction_->pixels() * pixel_depth == img_size_byte_;
+
+    if (is_corrected && pixel_depth == 1)
+    {
+        sensor_correction_->apply(src, dst, is_bayer_);
+    }
+    else if (is_corrected && is_tone_mapped)
+    {
+        // the 12 bit formats are corrected in their range, then tone mapped to 8 bit
+        sensor_correction_->apply(reinterpret_cast<const uint16_t*>(src), dst, ToneMapping::TABLE_SIZE - 1,
+                                  tone_mapping_->table(), is_bayer_);
+    }
+    else if (is_corrected)
+    {
+        // the 12 bit formats are corrected in their range, then shifted to 16 bit
+        const int shift = is_12_bit_shift_needed_ ? 4 : 0;
+        sensor_correction_->apply(reinterpret_cast<const uint16_t*>(src), reinterpret_cast<uint16_t*>(dst),
+                                  0xFFFFu >> shift, shift, is_bayer_);
+    }
+    else if (is_tone_mapped)
+    {
+        tone_mapping_->apply(reinterpret_cast<const uint16_t*>(src), dst, img_size_byte_ / 2);
+    }
+    else if (is_12_bit_shift_needed_)
+    {
+        // In case of 12 bits we need to shift the image bits 4 positions to the left,
+        // this is done while copying into the image
+        const uint16_t *convert_bits = reinterpret_cast<const uint16_t*>(src);
+        uint16_t *shifted_bits = reinterpret_cast<uint16_t*>(dst);
+        for (size_t i = 0; i < img_size_byte_ / 2; i++)
+        {
+            shifted_bits[i] = convert_bits[i] << 4;
+        }
+    }
+    else
+    {
+        std::memcpy(dst, src, img_size_byte_);
+    }
+}
+
+template <typename CameraTraitT>
+std::string PylonROS2CameraImpl<CameraTraitT>::currentROSEncoding() const
+{
+    if (!updateEncodingCache())
+    {
+        std::string gen_api_encoding(cam_->PixelFormat.ToString().c_str());
         //std::stringstream ss;
         //ss << "No ROS equivalent to GenApi encoding '" << gen_api_encoding << "' found! This is bad because this case should never occur!";
         //throw std::runtime_error(ss.str());
@@ -196,9 +401,26 @@ std::string PylonROS2CameraImpl<CameraTraitT>::currentROSEncoding() const
         //cam_->StartGrabbing();
         grabbingStarting();
         //return "NO_ENCODING";
+        return "";
+    }
+
+    return cached_ros_encoding_;
+}
+
+template <typename CameraTraitT>
+std::string PylonROS2CameraImpl<CameraTraitT>::outputROSEncoding() const
+{
+    if (isToneMapped())
+    {
+        return cached_tone_mapped_encoding_;
     }
+    return currentROSEncoding();
+}
 
-    return ros_encoding;
+template <typename CameraTraitT>
+int PylonROS2CameraImpl<CameraTraitT>::outputPixelDepth() const
+{
+    return isToneMapped() ? 1 : imagePixelDepth();
 }
 
 template <typename CameraTraitT>
@@ -389,6 +611,7 @@ bool PylonROS2CameraImpl<CameraTraitT>::startGrabbing(const PylonROS2CameraParam
         img_rows_ = static_cast<size_t>(cam_->Height.GetValue());
         img_cols_ = static_cast<size_t>(cam_->Width.GetValue());
         img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
+        is_sensor_geometry_changed_ = true;
 
         //grab_timeout_ = exposureTime().GetMax() * 1.05;
         grab_timeout_ = parameters.grab_timeout_; // grab timeout = 500 ms
@@ -426,52 +649,71 @@ bool PylonROS2CameraImpl<CameraTrait>::grab(std::vector<uint8_t>& image, rclcpp:
     }
     const uint8_t *pImageBuffer = reinterpret_cast<uint8_t*>(ptr_grab_result->GetBuffer());
 
-    // ------------------------------------------------------------------------
-    // Bit shifting
-    // ------------------------------------------------------------------------
-    // In case of 12 bits we need to shift the image bits 4 positions to the left
-    std::string ros_enc = currentROSEncoding();
-    uint16_t * shift_array = new uint16_t[img_size_byte_ / 2]; // Dynamically allocated to avoid heap size error
-    std::string gen_api_encoding(cam_->PixelFormat.ToString().c_str());
-    if (encodingconversions::is_12_bit_ros_enc(ros_enc) && (gen_api_encoding == "BayerRG12" || gen_api_encoding == "BayerBG12" || gen_api_encoding == "BayerGB12" || gen_api_encoding == "BayerGR12" || gen_api_encoding == "Mono12") ){
-        const uint16_t *convert_bits = reinterpret_cast<uint16_t*>(ptr_grab_result->GetBuffer());
-        for (size_t i = 0; i < img_size_byte_ / 2; i++){
-            shift_array[i] = convert_bits[i] << 4;
-        }
-        image.assign((uint8_t *) shift_array, (uint8_t *) shift_array + img_size_byte_);
-    } else {
-        image.assign(pImageBuffer, pImageBuffer + img_size_byte_);
+    if (frame_tracer_)
+    {
+        frame_tracer_->mark(TS_CONVERSION_START);
     }
 
-    delete[] shift_array;
+    // the image keeps its capacity from frame to frame, it is only reallocated if the image size grows,
+    // the tone mapped 12 bit formats take one byte per pixel instead of two
+    image.resize(isToneMapped() ? img_size_byte_ / 2 : img_size_byte_);
+
+    // bit shifting and sensor correction, in the single copy out of the pylon buffer
+    copyFrame(pImageBuffer, image.data());
+
+    if (frame_tracer_)
+    {
+        frame_tracer_->mark(TS_CONVERSION_END);
+    }
 
-    bool use_chunk_timestamp = false;
-    if (this->getChunkModeActive() == 1) 
+    // the chunk timestamp is only readable if the chunk mode is active and the timestamp chunk
+    // is enabled, no need to query (and write) the chunk selector of the camera for each frame
+    try
     {
-        std::string success = this->setChunkSelector(29); // = ChunkSelector_Timestamp
-        if (success.find("done") != std::string::npos && this->getChunkEnable() == 1) 
+        if (ptr_grab_result->ChunkTimestamp.IsReadable())
         {
-            use_chunk_timestamp = true;
+            stamp = rclcpp::Time(static_cast<uint64_t>(ptr_grab_result->ChunkTimestamp.GetValue()));
         }
     }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_WARN_STREAM(LOGGER_BASE, "An exception while getting the chunk timestamp occurred: " << e.GetDescription());
+    }
 
-    if (use_chunk_timestamp)
+    // frames lost on the way to the host, e.g. because the grabbing thread has been
+    // preempted and the buffers overflowed, show up as gaps in the chunk frame counter,
+    // named ChunkFramecounter on the GigE ace, ChunkFrameID on the ace 2 / boost and
+    // ChunkCounterValue (counter of the frame starts) on the USB ace
+    try
     {
-        try
+        int64_t frame_counter = -1;
+        if (ptr_grab_result->ChunkFramecounter.IsReadable())
         {
-            if (!ptr_grab_result->ChunkTimestamp.IsReadable())
-            {
-                RCLCPP_WARN_STREAM(LOGGER_BASE, "Error while trying to get the chunk timestamp. The connected camera may not support this feature");
-            }
-            else
-            {
-                stamp = rclcpp::Time(static_cast<uint64_t>(ptr_grab_result->ChunkTimestamp.GetValue()));
-            }
+            frame_counter = ptr_grab_result->ChunkFramecounter.GetValue();
         }
-        catch (const GenICam::GenericException &e)
+        else if (ptr_grab_result->ChunkFrameID.IsReadable())
         {
-            RCLCPP_WARN_STREAM(LOGGER_BASE, "An exception while getting the chunk timestamp occurred: " << e.GetDescription());
+            frame_counter = ptr_grab_result->ChunkFrameID.GetValue();
         }
+        else if (ptr_grab_result->ChunkCounterValue.IsReadable())
+        {
+            frame_counter = ptr_grab_result->ChunkCounterValue.GetValue();
+        }
+
+        if (frame_counter >= 0)
+        {
+            if (last_chunk_frame_counter_ >= 0 && frame_counter > last_chunk_frame_counter_ + 1)
+            {
+                dropped_frames_ += frame_counter - last_chunk_frame_counter_ - 1;
+            }
+            // a smaller value (counter reset or wrap around) only restarts the counting
+            last_chunk_frame_counter_ = frame_counter;
+            last_frame_counter_ = frame_counter;
+        }
+    }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_WARN_STREAM(LOGGER_BASE, "An exception while getting the chunk frame counter occurred: " << e.GetDescription());
     }
     
     if (!is_ready_)
@@ -497,22 +739,8 @@ bool PylonROS2CameraImpl<CameraTrait>::grab(uint8_t* image)
         return false;
     }
 
-    // ------------------------------------------------------------------------
-    // Bit shifting
-    // ------------------------------------------------------------------------
-    // In case of 12 bits we need to shift the image bits 4 positions to the left
-    std::string ros_enc = currentROSEncoding();
-    uint16_t shift_array[img_size_byte_ / 2];
-
-    if (encodingconversions::is_12_bit_ros_enc(ros_enc)){
-        const uint16_t *convert_bits = reinterpret_cast<uint16_t*>(ptr_grab_result->GetBuffer());
-        for (size_t i = 0; i < img_size_byte_ / 2; i++){
-            shift_array[i] = convert_bits[i] << 4;
-        }
-        memcpy(image, (uint8_t *) shift_array, img_size_byte_);
-    } else {
-        memcpy(image, ptr_grab_result->GetBuffer(), img_size_byte_);
-    }
+    // bit shifting and sensor correction, in the single copy out of the pylon buffer
+    copyFrame(reinterpret_cast<const uint8_t*>(ptr_grab_result->GetBuffer()), image);
     
     return true;
 }
@@ -528,6 +756,32 @@ bool PylonROS2CameraImpl<CameraTrait>::grabBlaze(sensor_msgs::msg::PointCloud2&
     return true;
 }
 
+template <typename CameraTrait>
+bool PylonROS2CameraImpl<CameraTrait>::grabBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
+                                                 sensor_msgs::msg::Image& intensity_map_msg, 
+                                                 sensor_msgs::msg::Image& depth_map_msg, 
+                                                 sensor_msgs::msg::Image& depth_map_color_msg, 
+                                                 sensor_msgs::msg::Image& confidence_map_msg,
+                                                 sensor_msgs::msg::Image& depth_image_msg)
+{
+    RCLCPP_WARN(LOGGER_BASE, "The connected camera is not a blaze, nothing is going to be grabbed!");
+    return true;
+}
+
+template <typename CameraTrait>
+bool PylonROS2CameraImpl<CameraTrait>::grabBlazeRaw(BlazeRawData& raw)
+{
+    RCLCPP_WARN(LOGGER_BASE, "The connected camera is not a blaze, nothing is going to be grabbed!");
+    return false;
+}
+
+template <typename CameraTrait>
+bool PylonROS2CameraImpl<CameraTrait>::blazeConversionSettings(BlazeConversionSettings& settings)
+{
+    RCLCPP_WARN(LOGGER_BASE, "The connected camera is not a blaze, there are no conversion settings!");
+    return false;
+}
+
 // Lowest level grab function called by the other grab functions
 template <typename CameraTrait>
 bool PylonROS2CameraImpl<CameraTrait>::grab(Pylon::CBaslerUniversalGrabResultPtr& grab_result)
@@ -547,6 +801,10 @@ bool PylonROS2CameraImpl<CameraTrait>::grab(Pylon::CBaslerUniversalGrabResultPtr
         {
             if (cam_->WaitForFrameTriggerReady(trigger_timeout, Pylon::TimeoutHandling_ThrowException))
             {   
+                if (frame_tracer_)
+                {
+                    frame_tracer_->mark(TS_TRIGGER_ISSUED);
+                }
                 cam_->ExecuteSoftwareTrigger(); 
             }
             else
@@ -557,6 +815,11 @@ bool PylonROS2CameraImpl<CameraTrait>::grab(Pylon::CBaslerUniversalGrabResultPtr
         }
 
         cam_->RetrieveResult(grab_timeout_, grab_result, Pylon::TimeoutHandling_ThrowException);
+
+        if (frame_tracer_)
+        {
+            frame_tracer_->mark(TS_RESULT_RETRIEVED);
+        }
     }
     catch (const GenICam::GenericException &e)
     {   
@@ -590,6 +853,12 @@ bool PylonROS2CameraImpl<CameraTrait>::grab(Pylon::CBaslerUniversalGrabResultPtr
         return false;
     }
 
+    // overwritten by the chunk frame counter if available
+    last_frame_counter_ = static_cast<int64_t>(grab_result->GetBlockID());
+    // the offsets the frame was read out with, from the payload of the frame
+    last_offset_x_ = static_cast<size_t>(grab_result->GetOffsetX());
+    last_offset_y_ = static_cast<size_t>(grab_result->GetOffsetY());
+
     return true;
 }
 
@@ -938,6 +1207,7 @@ bool PylonROS2CameraImpl<CameraTraitT>::setROI(const sensor_msgs::msg::RegionOfI
             img_cols_ = static_cast<size_t>(cam_->Width.GetValue());
             img_rows_ = static_cast<size_t>(cam_->Height.GetValue());
             img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
+            is_sensor_geometry_changed_ = true;
 
             // For ACE cameras we need to completely stop grabbing and then the
             // user needs to call start grabbing, if not the driver crashes.
@@ -965,6 +1235,159 @@ bool PylonROS2CameraImpl<CameraTraitT>::setROI(const sensor_msgs::msg::RegionOfI
     return true;
 }
 
+template <typename CameraTraitT>
+bool PylonROS2CameraImpl<CameraTraitT>::moveROI(const int64_t& offset_x, const int64_t& offset_y,
+                                                sensor_msgs::msg::RegionOfInterest& reached_roi)
+{
+    try
+    {
+        if ( !GenApi::IsAvailable(cam_->OffsetX) || !GenApi::IsAvailable(cam_->OffsetY) )
+        {
+            RCLCPP_WARN_STREAM(LOGGER_BASE, "Camera does not support area of interest. Will keep the current settings");
+            reached_roi = currentROI();
+            return false;
+        }
+
+        // the roi is kept inside the sensor, the limits of the offsets follow the current width and height
+        const auto adapt = [](const int64_t& value, const int64_t& min, const int64_t& max, const int64_t& inc)
+        {
+            const int64_t clamped = std::min(std::max(value, min), max);
+            return clamped - (clamped - min) % std::max<int64_t>(inc, 1);
+        };
+        const int64_t offset_x_to_set = adapt(offset_x, cam_->OffsetX.GetMin(), cam_->OffsetX.GetMax(), cam_->OffsetX.GetInc());
+        const int64_t offset_y_to_set = adapt(offset_y, cam_->OffsetY.GetMin(), cam_->OffsetY.GetMax(), cam_->OffsetY.GetInc());
+
+        if (offset_x_to_set != cam_->OffsetX.GetValue() || offset_y_to_set != cam_->OffsetY.GetValue())
+        {
+            // most cameras take new offsets while grabbing, the others are stopped for the change
+            const bool is_stop_needed = cam_->IsGrabbing() && (!GenApi::IsWritable(cam_->OffsetX) || !GenApi::IsWritable(cam_->OffsetY));
+            if (is_stop_needed)
+            {
+                RCLCPP_WARN_STREAM_ONCE(LOGGER_BASE, "The camera does not take new offsets while grabbing, the grabbing is restarted for each move of the roi");
+                cam_->StopGrabbing();
+            }
+            cam_->OffsetX.SetValue(offset_x_to_set);
+            cam_->OffsetY.SetValue(offset_y_to_set);
+            if (is_stop_needed)
+            {
+                grabbingStarting();
+            }
+        }
+        reached_roi = currentROI();
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BASE, "An exception while moving the area of interest to ("
+                << offset_x << ", " << offset_y << ") occurred: " << e.GetDescription());
+        return false;
+    }
+
+    return true;
+}
+
+template <typename CameraTraitT>
+bool PylonROS2CameraImpl<CameraTraitT>::setMultipleROI(const std::vector<ROIZone>& target_rows, const std::vector<ROIZone>& target_columns,
+                                                       std::vector<ROIZone>& reached_rows, std::vector<ROIZone>& reached_columns)
+{
+    reached_rows.clear();
+    reached_columns.clear();
+
+    // the zones of one direction: each entry of the selector is a zone, the entries beyond the targets are left untouched
+    const auto configure_zones = [](auto& enable, auto& selector, auto& offset, auto& size,
+                                    const std::vector<ROIZone>& targets, const int64_t& full_size, std::vector<ROIZone>& reached)
+    {
+        if (targets.empty())
+        {
+            enable.SetValue(false);
+            reached.push_back(ROIZone(0, static_cast<size_t>(full_size)));
+            return true;
+        }
+
+        GenApi::StringList_t entries;
+        selector.GetSettableValues(entries);
+        if (targets.size() > entries.size())
+        {
+            RCLCPP_ERROR_STREAM(LOGGER_BASE, targets.size() << " zones of multiple ROI requested, the camera has " << entries.size());
+            return false;
+        }
+
+        enable.SetValue(true);
+        for (size_t i = 0; i < targets.size(); ++i)
+        {
+            selector.SetValue(entries[i]);
+            // the size is reduced first, so that the offset of the zone can be reached
+            size.SetValue(size.GetMin());
+            offset.SetValue(static_cast<int64_t>(targets[i].first), Pylon::IntegerValueCorrection_Nearest);
+            size.SetValue(static_cast<int64_t>(targets[i].second), Pylon::IntegerValueCorrection_Nearest);
+            reached.push_back(ROIZone(static_cast<size_t>(offset.GetValue()), static_cast<size_t>(size.GetValue())));
+        }
+        return true;
+    };
+
+    try
+    {
+        if ( !GenApi::IsAvailable(cam_->BslMultipleROIRowsEnable) || !GenApi::IsAvailable(cam_->BslMultipleROIColumnsEnable) )
+        {
+            RCLCPP_ERROR_STREAM(LOGGER_BASE, "Error while trying to set the multiple ROI. The connected Camera not supporting this feature");
+            return false;
+        }
+
+        cam_->StopGrabbing();
+        // the zones are placed on the full sensor
+        cam_->OffsetX.SetValue(0);
+        cam_->OffsetY.SetValue(0);
+        cam_->Width.SetValue(cam_->WidthMax.GetValue());
+        cam_->Height.SetValue(cam_->HeightMax.GetValue());
+
+        bool is_set = configure_zones(cam_->BslMultipleROIRowsEnable, cam_->BslMultipleROIRowSelector, cam_->BslMultipleROIRowOffset,
+                                      cam_->BslMultipleROIRowSize, target_rows, cam_->HeightMax.GetValue(), reached_rows) &&
+                      configure_zones(cam_->BslMultipleROIColumnsEnable, cam_->BslMultipleROIColumnSelector, cam_->BslMultipleROIColumnOffset,
+                                      cam_->BslMultipleROIColumnSize, target_columns, cam_->WidthMax.GetValue(), reached_columns);
+
+        // the frame is split along the reached zones, they must make up the whole frame
+        size_t rows_sum = 0;
+        size_t columns_sum = 0;
+        for (const ROIZone& zone : reached_rows)
+        {
+            rows_sum += zone.second;
+        }
+        for (const ROIZone& zone : reached_columns)
+        {
+            columns_sum += zone.second;
+        }
+        if (is_set && (rows_sum != static_cast<size_t>(cam_->Height.GetValue()) || columns_sum != static_cast<size_t>(cam_->Width.GetValue())))
+        {
+            RCLCPP_ERROR_STREAM(LOGGER_BASE, "The frame of the multiple ROI (" << cam_->Width.GetValue() << "x" << cam_->Height.GetValue()
+                    << ") is not made of the configured zones (" << columns_sum << "x" << rows_sum << "), "
+                    << "the camera reads out zones that were not configured");
+            is_set = false;
+        }
+        if (!is_set)
+        {
+            cam_->BslMultipleROIRowsEnable.SetValue(false);
+            cam_->BslMultipleROIColumnsEnable.SetValue(false);
+            reached_rows.clear();
+            reached_columns.clear();
+        }
+
+        grabbingStarting();
+
+        img_cols_ = static_cast<size_t>(cam_->Width.GetValue());
+        img_rows_ = static_cast<size_t>(cam_->Height.GetValue());
+        img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
+        is_sensor_geometry_changed_ = true;
+        return is_set;
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BASE, "An exception while setting the multiple ROI occurred: " << e.GetDescription());
+        reached_rows.clear();
+        reached_columns.clear();
+        grabbingStarting();
+        return false;
+    }
+}
+
 template <typename CameraTraitT>
 bool PylonROS2CameraImpl<CameraTraitT>::setBinningX(const size_t& target_binning_x,
                                                 size_t& reached_binning_x)
@@ -995,6 +1418,7 @@ bool PylonROS2CameraImpl<CameraTraitT>::setBinningX(const size_t& target_binning
             grabbingStarting();
             img_cols_ = static_cast<size_t>(cam_->Width.GetValue());
             img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
+            is_sensor_geometry_changed_ = true;
         }
         else
         {
@@ -1042,6 +1466,7 @@ bool PylonROS2CameraImpl<CameraTraitT>::setBinningY(const size_t& target_binning
             grabbingStarting();
             img_rows_ = static_cast<size_t>(cam_->Height.GetValue());
             img_size_byte_ =  img_cols_ * img_rows_ * imagePixelDepth();
+            is_sensor_geometry_changed_ = true;
         }
         else
         {
@@ -1926,6 +2351,53 @@ int PylonROS2CameraImpl<CameraTraitT>::getSensorReadoutMode()
     }
 }
 
+template <typename CameraTraitT>
+std::string PylonROS2CameraImpl<CameraTraitT>::setLookupTable(const std::vector<uint16_t>& values)
+{
+    try
+    {
+        if ( values.empty() )
+        {
+            return "Error: empty lookup table";
+        }
+
+        if ( GenApi::IsAvailable(cam_->LUTEnable) && GenApi::IsAvailable(cam_->LUTIndex) && GenApi::IsAvailable(cam_->LUTValue) )
+        {
+            if ( GenApi::IsAvailable(cam_->LUTSelector) )
+            {
+                cam_->LUTSelector.SetValue(LUTSelectorEnums::LUTSelector_Luminance);
+            }
+
+            // the LUT of the camera may have less entries than the table (e.g., one every 8 pixel values)
+            // and another range of values, both are scaled
+            const int64_t index_min = cam_->LUTIndex.GetMin();
+            const int64_t index_max = cam_->LUTIndex.GetMax();
+            const int64_t index_inc = cam_->LUTIndex.GetInc();
+            const int64_t value_max = cam_->LUTValue.GetMax();
+            const int64_t index_range = index_max + index_inc;
+            const int64_t table_max = static_cast<int64_t>(values.size()) - 1;
+            for (int64_t index = index_min; index <= index_max; index += index_inc)
+            {
+                const size_t entry = static_cast<size_t>(std::min(index * static_cast<int64_t>(values.size()) / index_range, table_max));
+                cam_->LUTIndex.SetValue(index);
+                cam_->LUTValue.SetValue(values.at(entry) * value_max / std::max<int64_t>(table_max, 1));
+            }
+            cam_->LUTEnable.SetValue(true);
+        }
+        else 
+        {
+            RCLCPP_ERROR_STREAM(LOGGER_BASE, "Error while trying to set the lookup table. The connected Camera not supporting this feature");
+            return "The connected Camera not supporting this feature";
+        }
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BASE, "An exception while trying to set the lookup table occurred:" << e.GetDescription());
+        return e.GetDescription();
+    }
+    return "done";
+}
+
 template <typename CameraTraitT>
 std::string PylonROS2CameraImpl<CameraTraitT>::setTriggerSelector(const int& mode)
 {
@@ -2966,6 +3438,120 @@ std::string PylonROS2CameraImpl<CameraTraitT>::loadPfs(const std::string& fileNa
     return "done";
 }
 
+template <typename CameraTraitT>
+bool PylonROS2CameraImpl<CameraTraitT>::applyStartupSnapshot(const std::string& fileName)
+{
+    std::ifstream snapshot_file(fileName);
+    if (!snapshot_file.is_open())
+    {
+        return false;
+    }
+
+    try
+    {
+        GenApi::INodeMap& node_map = cam_->GetNodeMap();
+
+        // Read the whole current device state in one pass. Both pfs contents list the
+        // features in the same order, hence they can be compared line by line.
+        Pylon::String_t current_pfs;
+        Pylon::CFeaturePersistence::SaveToString(current_pfs, &node_map);
+        std::istringstream current_stream(current_pfs.c_str());
+
+        // selector values are only written when a dependent feature has to be written
+        std::vector<std::pair<std::string, std::string>> snapshot_selectors;
+        std::map<std::string, std::string> device_selectors;
+
+        size_t nr_features = 0;
+        size_t nr_written = 0;
+        std::string snapshot_line;
+        std::string current_line;
+        while (std::getline(snapshot_file, snapshot_line))
+        {
+            if (snapshot_line.empty() || snapshot_line[0] == '#')
+            {
+                continue;
+            }
+
+            do
+            {
+                if (!std::getline(current_stream, current_line))
+                {
+                    current_line.clear();
+                    break;
+                }
+            }
+            while (current_line.empty() || current_line[0] == '#');
+
+            const size_t separator = snapshot_line.find('\t');
+            if (separator == std::string::npos ||
+                current_line.compare(0, separator + 1, snapshot_line, 0, separator + 1) != 0)
+            {
+                RCLCPP_WARN_STREAM(LOGGER_BASE, "The startup snapshot " << fileName << " does not match the "
+                    << "feature layout of the camera, it will be ignored");
+                return false;
+            }
+
+            ++nr_features;
+            const std::string feature_name = snapshot_line.substr(0, separator);
+            const std::string snapshot_value = snapshot_line.substr(separator + 1);
+            const std::string current_value = current_line.substr(separator + 1);
+
+            GenApi::CValuePtr feature = node_map.GetNode(feature_name.c_str());
+            if (!feature)
+            {
+                return false;
+            }
+
+            if (feature->GetNode()->IsSelector())
+            {
+                auto it = std::find_if(snapshot_selectors.begin(), snapshot_selectors.end(),
+                                       [&feature_name](const std::pair<std::string, std::string>& selector)
+                                       { return selector.first == feature_name; });
+                if (it == snapshot_selectors.end())
+                {
+                    snapshot_selectors.emplace_back(feature_name, snapshot_value);
+                    device_selectors[feature_name] = current_value;
+                }
+                else
+                {
+                    it->second = snapshot_value;
+                }
+                continue;
+            }
+
+            if (snapshot_value == current_value)
+            {
+                continue;
+            }
+
+            for (const auto& selector : snapshot_selectors)
+            {
+                if (device_selectors[selector.first] != selector.second)
+                {
+                    GenApi::CValuePtr(node_map.GetNode(selector.first.c_str()))->FromString(selector.second.c_str());
+                    device_selectors[selector.first] = selector.second;
+                }
+            }
+
+            RCLCPP_DEBUG_STREAM(LOGGER_BASE, "Startup snapshot: " << feature_name << " = " << snapshot_value
+                << " (was " << current_value << ")");
+            feature->FromString(snapshot_value.c_str());
+            ++nr_written;
+        }
+
+        RCLCPP_INFO_STREAM(LOGGER_BASE, "Startup snapshot restored: " << nr_written << " of "
+            << nr_features << " features written");
+    }
+    catch ( const GenICam::GenericException &e )
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BASE, "An exception while restoring the startup snapshot " << fileName << ": "
+            << e.GetDescription());
+        return false;
+    }
+
+    return true;
+}
+
 template <typename CameraTraitT>
 std::string PylonROS2CameraImpl<CameraTraitT>::setUserSetDefaultSelector(const int& set)
 {
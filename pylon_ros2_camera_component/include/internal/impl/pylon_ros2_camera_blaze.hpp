@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "internal/impl/pylon_ros2_camera_gige.hpp"
+#include "rgbd_registration.hpp"
 
 #include <pylon/BlazeInstantCamera.h>
 
@@ -41,6 +42,9 @@
 //#include <boost/make_shared.hpp>
 
 #include "pcl_conversions/pcl_conversions.h"
+#include <sensor_msgs/point_cloud2_iterator.hpp>
+
+#include <cstring>
 
 #pragma pack(push, 1)
 struct BGR 
@@ -78,6 +82,18 @@ namespace
         static constexpr bool isInvalidValueNaN = s_invalid_data_value != s_invalid_data_value; // true, when s_invalid_data_value equals NaN
         return isInvalidValueNaN ? !std::isnan(point->z) : point->z != s_invalid_data_value;
     }
+
+    // Sets the properties of an image message and sizes its buffer, which keeps its capacity from frame to frame.
+    static inline void prepareImageMsg(sensor_msgs::msg::Image& msg, const int height, const int width,
+                                       const std::string& encoding, const size_t pixel_size)
+    {
+        msg.height = height;
+        msg.width = width;
+        msg.encoding = encoding;
+        msg.is_bigendian = false;
+        msg.step = width * pixel_size;
+        msg.data.resize(msg.step * height);
+    }
 }
 
 class PylonROS2BlazeCamera : public PylonROS2GigECamera
@@ -95,33 +111,99 @@ public:
     virtual std::string grabbingStarting();
     virtual std::string grabbingStopping();
     virtual bool isCamRemoved();
+    virtual void releaseDevice();
+    virtual bool restartStream(const STREAM_RECOVERY_STEP& step);
+    virtual bool setInternalThreadPriority(const int& priority);
+    virtual bool setHeartbeatTimeout(const int& timeout_ms);
+    virtual bool applyStartupSnapshot(const std::string& fileName);
 
     virtual bool grabBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
                            sensor_msgs::msg::Image& intensity_map_msg, 
                            sensor_msgs::msg::Image& depth_map_msg, 
                            sensor_msgs::msg::Image& depth_map_color_msg, 
                            sensor_msgs::msg::Image& confidence_map_msg);
+    virtual bool grabBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
+                           sensor_msgs::msg::Image& intensity_map_msg, 
+                           sensor_msgs::msg::Image& depth_map_msg, 
+                           sensor_msgs::msg::Image& depth_map_color_msg, 
+                           sensor_msgs::msg::Image& confidence_map_msg,
+                           sensor_msgs::msg::Image& depth_image_msg);
+            // The depth image is only computed if depth_image_msg is given.
+            bool grabAndConvertBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
+                                     sensor_msgs::msg::Image& intensity_map_msg, 
+                                     sensor_msgs::msg::Image& depth_map_msg, 
+                                     sensor_msgs::msg::Image& depth_map_color_msg, 
+                                     sensor_msgs::msg::Image& confidence_map_msg,
+                                     sensor_msgs::msg::Image* depth_image_msg);
             bool grabBlaze(Pylon::CGrabResultPtr& grab_result);
+    virtual bool grabBlazeRaw(BlazeRawData& raw);
+    virtual bool blazeConversionSettings(BlazeConversionSettings& settings);
+            // The conversion functions are static, they only read the given settings and never access the camera.
+            static bool convertBlazeRaw(const BlazeConversionSettings& settings,
+                                        const BlazeRawData& raw,
+                                        const int& products,
+                                        sensor_msgs::msg::PointCloud2& cloud_msg,
+                                        sensor_msgs::msg::Image& intensity_map_msg, 
+                                        sensor_msgs::msg::Image& depth_map_msg, 
+                                        sensor_msgs::msg::Image& depth_map_color_msg, 
+                                        sensor_msgs::msg::Image& confidence_map_msg);
     virtual bool grab(Pylon::CGrabResultPtr& grab_result);                 // is not used but needs to be implemented
     virtual bool grab(std::vector<uint8_t>& image, rclcpp::Time &stamp);   // is not used but needs to be implemented
 
+            // Checks that the container holds the range, intensity and confidence components in the expected formats.
+            bool checkBlazeData(const Pylon::CPylonDataContainer& container);
             bool processAndConvertBlazeData(const Pylon::CPylonDataContainer& container,
                                             sensor_msgs::msg::PointCloud2& cloud_msg,
                                             sensor_msgs::msg::Image& intensity_map_msg, 
                                             sensor_msgs::msg::Image& depth_map_msg, 
                                             sensor_msgs::msg::Image& depth_map_color_msg, 
-                                            sensor_msgs::msg::Image& confidence_map_msg);
-            bool convertGrabResultToPointCloud(const Pylon::CPylonDataContainer& container,
-                                               sensor_msgs::msg::PointCloud2& cloud_msg);
+                                            sensor_msgs::msg::Image& confidence_map_msg,
+                                            sensor_msgs::msg::Image* depth_image_msg);
+            // Converts the 3D points (in mm) and the maps into the selected products (BLAZE_PRODUCT flags).
+            // It only reads the given settings, so that data sets can be converted concurrently.
+            static void convertBlazeData(const BlazeConversionSettings& settings, const Point* points, const uint16_t* pintensity, const uint16_t* pconfidence,
+                                         int width, int height, int min_depth, int max_depth, int products,
+                                         sensor_msgs::msg::PointCloud2& cloud_msg,
+                                         sensor_msgs::msg::Image& intensity_map_msg, 
+                                         sensor_msgs::msg::Image& depth_map_msg, 
+                                         sensor_msgs::msg::Image& depth_map_color_msg, 
+                                         sensor_msgs::msg::Image& confidence_map_msg,
+                                         sensor_msgs::msg::Image* depth_image_msg);
+            static bool convertGrabResultToPointCloud(const BlazeConversionSettings& settings,
+                                                      const Point* points,
+                                                      const uint16_t* pintensity,
+                                                      size_t width,
+                                                      size_t height,
+                                                      sensor_msgs::msg::PointCloud2& cloud_msg);
+            // Writes the points (in m, transformed if a cloud frame is given) and the intensity as
+            // color into the cloud, laid out as PointT (pcl::PointXYZRGB or pcl::PointXYZRGBNormal).
+            template <typename PointT>
+            static void fillPointCloud(const BlazeConversionSettings& settings, const Point* points, const uint16_t* pintensity, size_t size, PointT* pdst_point);
+            // Estimates the normals and curvatures of an organized pcl::PointXYZRGBNormal cloud from its
+            // grid neighbourhood, leaving out the points below the confidence threshold.
+            // Kept as a scalar pass: integral images of the moments and vectorized 3x3 sums measured no faster.
+            static void calculateNormals(const BlazeConversionSettings& settings, const uint16_t* pconfidence, sensor_msgs::msg::PointCloud2& cloud_msg);
 
             // Calculates a grayscale depth map from point cloud data sent from a blaze camera.
             // The buffer that pDepthMap points to must be allocated accordingly before 
             // passing it to the calculateDepthMap function.
-            void calculateDepthMap(const Pylon::CPylonDataComponent& pointCloud, int min_depth, int max_depth, uint16_t* pDepthMap);
+            static void calculateDepthMap(const Point* points, int width, int height, int min_depth, int max_depth, uint16_t* pDepthMap);
             // Calculates a color depth map from point cloud data sent from a blaze camera.
             // The buffer that pDepthMap points to must be allocated accordingly before
             // passing it to the calculateDepthMap function.
-            void calculateDepthMapColor(const Pylon::CPylonDataComponent& pointCloud, int min_depth, int max_depth, BGR* pDepthMap);
+            static void calculateDepthMapColor(const Point* points, int width, int height, int min_depth, int max_depth, BGR* pDepthMap);
+            // Calculates the metric depth image (16UC1 in mm or 32FC1 in m, holding Z or the range) from point cloud data.
+            // Missing depth is set to 0 (16UC1) or NaN (32FC1).
+            static void calculateDepthImage(const BlazeConversionSettings& settings, const Point* points, int width, int height, sensor_msgs::msg::Image& depth_image_msg);
+
+            // Reads the coordinate scale and offset of the depth map and computes the per-pixel
+            // ray table from the camera intrinsics. Only used in range only mode (Coord3D_C16).
+            bool setupRangeReconstruction();
+            // Reconstructs the 3D points (in mm, NaN if invalid) of a Coord3D_C16 depth map
+            // into range_points_, using the ray table.
+            const Point* reconstructPoints(const Pylon::CPylonDataComponent& range_component);
+            // Reconstructs the 3D points of a depth map of the size of the ray table into pdst.
+            static void reconstructPoints(const BlazeConversionSettings& settings, const uint16_t* depth_map, Point* pdst);
     
     virtual void getInitialCameraInfo(sensor_msgs::msg::CameraInfo& cam_info_msg);
     
@@ -168,12 +250,26 @@ public:
 
     // remember current setting in order to restore it when node is shut down
     double invalid_data_value_old_;
+
+    // settings of the conversion, copied by the blaze data action
+    BlazeConversionSettings conversion_;
+    // points reconstructed from the depth map in range only mode
+    std::vector<Point> range_points_;
+
+    // coloring of the point cloud with an area-scan camera of the same process
+    RGBDRegistration registration_;
+    // hardware timestamp of the last grab result in ns
+    int64_t last_grab_timestamp_;
 };
 
 PylonROS2BlazeCamera::PylonROS2BlazeCamera(Pylon::IPylonDevice* device) :
     PylonROS2GigECamera(device),
     blaze_cam_(new Pylon::CBlazeInstantCamera(device)),
-    invalid_data_value_old_(0.0f)
+    invalid_data_value_old_(0.0f),
+    conversion_(),
+    range_points_(),
+    registration_(),
+    last_grab_timestamp_(0)
 {
     // information logging severity mode
     rcutils_ret_t __attribute__((unused)) res = rcutils_logging_set_logger_level(LOGGER_BLAZE.get_name(), RCUTILS_LOG_SEVERITY_DEBUG);
@@ -237,6 +333,9 @@ bool PylonROS2BlazeCamera::registerCameraConfiguration()
         blaze_cam_->RegisterConfiguration(new Pylon::CBlazeDefaultConfiguration,
                                           Pylon::RegistrationMode_ReplaceAll,
                                           Pylon::Cleanup_Delete);
+        blaze_cam_->RegisterConfiguration(new PylonROS2DeviceRemovalHandler(is_device_removed_),
+                                          Pylon::RegistrationMode_Append,
+                                          Pylon::Cleanup_Delete);
     }
     catch (const GenICam::GenericException& e)
     {
@@ -282,9 +381,75 @@ bool PylonROS2BlazeCamera::applyCamSpecificStartupSettings(const PylonROS2Camera
         // Set up acquisition.
         
         // Enable depth data
+        conversion_.is_range_only = parameters.blaze_range_only_;
         blaze_cam_->ComponentSelector.SetValue(Pylon::BlazeCameraParams_Params::ComponentSelector_Range);
         blaze_cam_->ComponentEnable.SetValue(true);
-        blaze_cam_->PixelFormat.SetValue(Pylon::BlazeCameraParams_Params::PixelFormat_Coord3D_ABC32f);
+        if (conversion_.is_range_only)
+        {
+            // 2 bytes per pixel instead of 12, the point cloud is reconstructed by the driver
+            blaze_cam_->PixelFormat.SetValue(Pylon::BlazeCameraParams_Params::PixelFormat_Coord3D_C16);
+            RCLCPP_INFO(LOGGER_BLAZE, "blaze sends its range as depth map (Coord3D_C16), the point cloud is reconstructed by the driver");
+        }
+        else
+        {
+            blaze_cam_->PixelFormat.SetValue(Pylon::BlazeCameraParams_Params::PixelFormat_Coord3D_ABC32f);
+        }
+
+        // metric depth image
+        conversion_.is_depth_image_float = parameters.blaze_depth_image_encoding_ != sensor_msgs::image_encodings::TYPE_16UC1;
+        if (conversion_.is_depth_image_float && parameters.blaze_depth_image_encoding_ != sensor_msgs::image_encodings::TYPE_32FC1)
+        {
+            RCLCPP_WARN_STREAM(LOGGER_BLAZE, "Unsupported depth image encoding '" << parameters.blaze_depth_image_encoding_
+                                             << "', 16UC1 or 32FC1 is expected. 32FC1 is used instead.");
+        }
+        conversion_.is_depth_image_range = parameters.blaze_depth_image_content_ == "range";
+        if (!conversion_.is_depth_image_range && parameters.blaze_depth_image_content_ != "z")
+        {
+            RCLCPP_WARN_STREAM(LOGGER_BLAZE, "Unsupported depth image content '" << parameters.blaze_depth_image_content_
+                                             << "', z or range is expected. z is used instead.");
+        }
+
+        // static extrinsic of the point cloud
+        conversion_.is_cloud_transformed = false;
+        if (!parameters.blaze_cloud_frame_.empty())
+        {
+            // validated while reading the parameters
+            const std::vector<double>& tf = parameters.blaze_cloud_transform_;
+            const double norm = std::sqrt(tf[3] * tf[3] + tf[4] * tf[4] + tf[5] * tf[5] + tf[6] * tf[6]);
+            const double x = tf[3] / norm, y = tf[4] / norm, z = tf[5] / norm, w = tf[6] / norm;
+            // rotation matrix of the quaternion, scaled from mm to m
+            const double rotation[9] = {1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y - z * w), 2.0 * (x * z + y * w),
+                                        2.0 * (x * y + z * w), 1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z - x * w),
+                                        2.0 * (x * z - y * w), 2.0 * (y * z + x * w), 1.0 - 2.0 * (x * x + y * y)};
+            for (size_t i = 0; i < 9; ++i)
+            {
+                conversion_.cloud_rotation[i] = static_cast<float>(rotation[i] * 0.001);
+            }
+            for (size_t i = 0; i < 3; ++i)
+            {
+                conversion_.cloud_translation[i] = static_cast<float>(tf[i]);
+            }
+            conversion_.is_cloud_transformed = true;
+            RCLCPP_INFO_STREAM(LOGGER_BLAZE, "The point cloud is transformed into the frame " << parameters.blaze_cloud_frame_);
+        }
+
+        // surface normals
+        conversion_.is_normals_computed = parameters.blaze_compute_normals_;
+        conversion_.normals_min_confidence = parameters.blaze_normals_min_confidence_;
+
+        // RGB-D registration
+        if (!parameters.registration_channel_.empty())
+        {
+            registration_.enable(parameters.registration_channel_,
+                                 parameters.blaze_registration_transform_,
+                                 parameters.blaze_registration_max_time_offset_);
+            RCLCPP_INFO_STREAM(LOGGER_BLAZE, "The point cloud is colored with the frames of the registration channel "
+                                             << parameters.registration_channel_);
+        }
+        else
+        {
+            registration_.disable();
+        }
 
         // Enable intensity image
         blaze_cam_->ComponentSelector.SetValue(Pylon::BlazeCameraParams_Params::ComponentSelector_Intensity);
@@ -353,6 +518,11 @@ bool PylonROS2BlazeCamera::startGrabbing(const PylonROS2CameraParameter& paramet
         RCLCPP_DEBUG_STREAM_ONCE(LOGGER_BLAZE, "Grab timeout for blaze: " << grab_timeout_);
         RCLCPP_DEBUG_STREAM_ONCE(LOGGER_BLAZE, "Trigger timeout for blaze: " << trigger_timeout);
 
+        if (conversion_.is_range_only && !this->setupRangeReconstruction())
+        {
+            return false;
+        }
+
         Pylon::CGrabResultPtr grab_result;
         this->grabBlaze(grab_result);
         
@@ -407,7 +577,91 @@ std::string PylonROS2BlazeCamera::grabbingStopping()
 
 bool PylonROS2BlazeCamera::isCamRemoved()
 {
-    return cam_->IsCameraDeviceRemoved();
+    return is_device_removed_ || blaze_cam_->IsCameraDeviceRemoved();
+}
+
+void PylonROS2BlazeCamera::releaseDevice()
+{
+    try
+    {
+        // both instant cameras share the same pylon device, it must only be destroyed once
+        cam_->DetachDevice();
+        blaze_cam_->DestroyDevice();
+    }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BLAZE, "An exception occurred while releasing the camera device: " << e.GetDescription());
+    }
+}
+
+bool PylonROS2BlazeCamera::restartStream(const STREAM_RECOVERY_STEP& step)
+{
+    try
+    {
+        blaze_cam_->StopGrabbing();
+
+        if (step >= SRS_REOPEN_DEVICE)
+        {
+            // the device is shared with cam_, which is never opened for the blaze
+            blaze_cam_->Close();
+            blaze_cam_->Open();
+        }
+
+        blaze_cam_->StartGrabbing();
+    }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BLAZE, "An exception occurred while restarting the image stream: " << e.GetDescription());
+        return false;
+    }
+
+    return true;
+}
+
+bool PylonROS2BlazeCamera::setInternalThreadPriority(const int& priority)
+{
+    try
+    {
+        blaze_cam_->InternalGrabEngineThreadPriorityOverride.SetValue(true);
+        blaze_cam_->InternalGrabEngineThreadPriority.SetValue(priority);
+    }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_WARN_STREAM(LOGGER_BLAZE, "The grab engine thread priority could not be set: " << e.GetDescription());
+        return false;
+    }
+
+    RCLCPP_INFO_STREAM(LOGGER_BLAZE, "Pylon internal thread priority set to " << priority);
+    return true;
+}
+
+bool PylonROS2BlazeCamera::applyStartupSnapshot(const std::string& fileName)
+{
+    // the blaze startup settings also initialize internal states, they are always applied
+    RCLCPP_DEBUG_STREAM(LOGGER_BLAZE, "The startup snapshot " << fileName << " is not used for the blaze");
+    return false;
+}
+
+bool PylonROS2BlazeCamera::setHeartbeatTimeout(const int& timeout_ms)
+{
+    try
+    {
+        if (Pylon::CIntegerParameter(blaze_cam_->GetTLNodeMap(), "HeartbeatTimeout").TrySetValue(timeout_ms))
+        {
+            RCLCPP_INFO_STREAM(LOGGER_BLAZE, "Heartbeat timeout set to " << timeout_ms << " ms");
+            return true;
+        }
+        else
+        {
+            RCLCPP_WARN_STREAM(LOGGER_BLAZE, "The heartbeat timeout is not available for this camera");
+            return false;
+        }
+    }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BLAZE, "An exception occurred while setting the heartbeat timeout: " << e.GetDescription());
+        return false;
+    }
 }
 
 bool PylonROS2BlazeCamera::grabBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
@@ -415,6 +669,26 @@ bool PylonROS2BlazeCamera::grabBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
                                      sensor_msgs::msg::Image& depth_map_msg, 
                                      sensor_msgs::msg::Image& depth_map_color_msg, 
                                      sensor_msgs::msg::Image& confidence_map_msg)
+{
+    return this->grabAndConvertBlaze(cloud_msg, intensity_map_msg, depth_map_msg, depth_map_color_msg, confidence_map_msg, nullptr);
+}
+
+bool PylonROS2BlazeCamera::grabBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
+                                     sensor_msgs::msg::Image& intensity_map_msg, 
+                                     sensor_msgs::msg::Image& depth_map_msg, 
+                                     sensor_msgs::msg::Image& depth_map_color_msg, 
+                                     sensor_msgs::msg::Image& confidence_map_msg,
+                                     sensor_msgs::msg::Image& depth_image_msg)
+{
+    return this->grabAndConvertBlaze(cloud_msg, intensity_map_msg, depth_map_msg, depth_map_color_msg, confidence_map_msg, &depth_image_msg);
+}
+
+bool PylonROS2BlazeCamera::grabAndConvertBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
+                                               sensor_msgs::msg::Image& intensity_map_msg, 
+                                               sensor_msgs::msg::Image& depth_map_msg, 
+                                               sensor_msgs::msg::Image& depth_map_color_msg, 
+                                               sensor_msgs::msg::Image& confidence_map_msg,
+                                               sensor_msgs::msg::Image* depth_image_msg)
 {
     Pylon::CGrabResultPtr ptr_grab_result;
     if (!this->grabBlaze(ptr_grab_result))
@@ -424,8 +698,18 @@ bool PylonROS2BlazeCamera::grabBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
     }
 
     // process the acquired data
+    if (frame_tracer_)
+    {
+        frame_tracer_->mark(TS_CONVERSION_START);
+    }
+
     auto container = ptr_grab_result->GetDataContainer();
-    this->processAndConvertBlazeData(container, cloud_msg, intensity_map_msg, depth_map_msg, depth_map_color_msg, confidence_map_msg);
+    this->processAndConvertBlazeData(container, cloud_msg, intensity_map_msg, depth_map_msg, depth_map_color_msg, confidence_map_msg, depth_image_msg);
+
+    if (frame_tracer_)
+    {
+        frame_tracer_->mark(TS_CONVERSION_END);
+    }
 
     return true;
 }
@@ -442,10 +726,19 @@ bool PylonROS2BlazeCamera::grabBlaze(Pylon::CGrabResultPtr& grab_result)
         if (blaze_cam_->TriggerMode.GetValue() == Pylon::BlazeCameraParams_Params::TriggerMode_On)
         {
             // The blaze does not support waiting for frame trigger ready.
+            if (frame_tracer_)
+            {
+                frame_tracer_->mark(TS_TRIGGER_ISSUED);
+            }
             blaze_cam_->ExecuteSoftwareTrigger();
         }
         
         blaze_cam_->RetrieveResult(grab_timeout_, grab_result, Pylon::TimeoutHandling_ThrowException);
+
+        if (frame_tracer_)
+        {
+            frame_tracer_->mark(TS_RESULT_RETRIEVED);
+        }
     }
     catch (const GenICam::GenericException &e)
     {
@@ -479,15 +772,14 @@ bool PylonROS2BlazeCamera::grabBlaze(Pylon::CGrabResultPtr& grab_result)
         return false;
     }
 
+    last_frame_counter_ = static_cast<int64_t>(grab_result->GetBlockID());
+    // used to pair the frame with a color frame
+    last_grab_timestamp_ = static_cast<int64_t>(grab_result->GetTimeStamp());
+
     return true;
 }
 
-bool PylonROS2BlazeCamera::processAndConvertBlazeData(const Pylon::CPylonDataContainer& container,
-                                                      sensor_msgs::msg::PointCloud2& cloud_msg,
-                                                      sensor_msgs::msg::Image& intensity_map_msg,
-                                                      sensor_msgs::msg::Image& depth_map_msg,
-                                                      sensor_msgs::msg::Image& depth_map_color_msg,
-                                                      sensor_msgs::msg::Image& confidence_map_msg)
+bool PylonROS2BlazeCamera::checkBlazeData(const Pylon::CPylonDataContainer& container)
 {
     // some first checks
     if (container.GetDataComponentCount() != 3)
@@ -498,21 +790,44 @@ bool PylonROS2BlazeCamera::processAndConvertBlazeData(const Pylon::CPylonDataCon
 
     auto range_component = container.GetDataComponent(0);
     auto intensity_component = container.GetDataComponent(1);
-    auto confidence_component = container.GetDataComponent(2);
 
-    if (range_component.GetPixelType() != Pylon::PixelType_Coord3D_ABC32f)
+    if (!conversion_.is_range_only && range_component.GetPixelType() != Pylon::PixelType_Coord3D_ABC32f)
     {
         RCLCPP_ERROR_STREAM(LOGGER_BLAZE, "Unexpected data format for the first image part. Coord3D_ABC32f is expected.");
         return false;
     }
 
+    if (conversion_.is_range_only && range_component.GetPixelType() != Pylon::PixelType_Coord3D_C16)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BLAZE, "Unexpected data format for the first image part. Coord3D_C16 is expected.");
+        return false;
+    }
+
     if (intensity_component.GetPixelType() != Pylon::PixelType_Mono16)
     {
         RCLCPP_ERROR_STREAM(LOGGER_BLAZE, "Unexpected data format for the second image part. Mono16 is expected.");
         return false;
     }
 
-    // processing and converting data
+    return true;
+}
+
+bool PylonROS2BlazeCamera::processAndConvertBlazeData(const Pylon::CPylonDataContainer& container,
+                                                      sensor_msgs::msg::PointCloud2& cloud_msg,
+                                                      sensor_msgs::msg::Image& intensity_map_msg,
+                                                      sensor_msgs::msg::Image& depth_map_msg,
+                                                      sensor_msgs::msg::Image& depth_map_color_msg,
+                                                      sensor_msgs::msg::Image& confidence_map_msg,
+                                                      sensor_msgs::msg::Image* depth_image_msg)
+{
+    if (!this->checkBlazeData(container))
+    {
+        return false;
+    }
+
+    auto range_component = container.GetDataComponent(0);
+    auto intensity_component = container.GetDataComponent(1);
+    auto confidence_component = container.GetDataComponent(2);
 
     const int width = range_component.GetWidth();
     const int height = range_component.GetHeight();
@@ -520,83 +835,180 @@ bool PylonROS2BlazeCamera::processAndConvertBlazeData(const Pylon::CPylonDataCon
     int min_depth = blaze_cam_->DepthMin.GetValue();
     int max_depth = blaze_cam_->DepthMax.GetValue();
 
+    // 3D points in mm, sent by the camera or reconstructed from the depth map
+    const Point* points = conversion_.is_range_only ? this->reconstructPoints(range_component)
+                                                      : reinterpret_cast<const Point*>(range_component.GetData());
+    if (points == nullptr)
+    {
+        return false;
+    }
+
+    convertBlazeData(conversion_, points,
+                     reinterpret_cast<const uint16_t*>(intensity_component.GetData()),
+                     reinterpret_cast<const uint16_t*>(confidence_component.GetData()),
+                     width, height, min_depth, max_depth, BP_ALL,
+                     cloud_msg, intensity_map_msg, depth_map_msg, depth_map_color_msg, confidence_map_msg, depth_image_msg);
+
+    if (registration_.isEnabled())
+    {
+        // the rgb field is overwritten for the points seen by the color camera, in one pass over the points
+        registration_.colorize(reinterpret_cast<const float*>(points), static_cast<size_t>(width) * height, last_grab_timestamp_,
+                               cloud_msg.data.data() + cloud_msg.fields[3].offset, cloud_msg.point_step);
+    }
+
+    return true;
+}
+
+bool PylonROS2BlazeCamera::grabBlazeRaw(BlazeRawData& raw)
+{
+    Pylon::CGrabResultPtr ptr_grab_result;
+    if (!this->grabBlaze(ptr_grab_result))
+    {   
+        RCLCPP_ERROR(LOGGER_BLAZE, "Grabbing with blaze failed");
+        return false;
+    }
+
+    auto container = ptr_grab_result->GetDataContainer();
+    if (!this->checkBlazeData(container))
+    {
+        return false;
+    }
+
+    auto range_component = container.GetDataComponent(0);
+    auto intensity_component = container.GetDataComponent(1);
+    auto confidence_component = container.GetDataComponent(2);
+
+    // the components are copied, the grab result goes back to pylon right away
+    raw.width = range_component.GetWidth();
+    raw.height = range_component.GetHeight();
+    const uint8_t* prange = reinterpret_cast<const uint8_t*>(range_component.GetData());
+    raw.range.assign(prange, prange + range_component.GetDataSize());
+    const uint16_t* pintensity = reinterpret_cast<const uint16_t*>(intensity_component.GetData());
+    raw.intensity.assign(pintensity, pintensity + static_cast<size_t>(raw.width) * raw.height);
+    const uint16_t* pconfidence = reinterpret_cast<const uint16_t*>(confidence_component.GetData());
+    raw.confidence.assign(pconfidence, pconfidence + static_cast<size_t>(raw.width) * raw.height);
+
+    // the depth range is read now, the conversion must not access the camera
+    raw.min_depth = blaze_cam_->DepthMin.GetValue();
+    raw.max_depth = blaze_cam_->DepthMax.GetValue();
+
+    return true;
+}
+
+bool PylonROS2BlazeCamera::blazeConversionSettings(BlazeConversionSettings& settings)
+{
+    settings = conversion_;
+    return true;
+}
+
+bool PylonROS2BlazeCamera::convertBlazeRaw(const BlazeConversionSettings& settings,
+                                           const BlazeRawData& raw,
+                                           const int& products,
+                                           sensor_msgs::msg::PointCloud2& cloud_msg,
+                                           sensor_msgs::msg::Image& intensity_map_msg,
+                                           sensor_msgs::msg::Image& depth_map_msg,
+                                           sensor_msgs::msg::Image& depth_map_color_msg,
+                                           sensor_msgs::msg::Image& confidence_map_msg)
+{
+    const size_t size = static_cast<size_t>(raw.width) * raw.height;
+    const size_t range_pixel_size = settings.is_range_only ? sizeof(uint16_t) : sizeof(Point);
+    if (raw.range.size() < size * range_pixel_size || raw.intensity.size() < size || raw.confidence.size() < size)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BLAZE, "The raw blaze data set is incomplete");
+        return false;
+    }
+
+    // in range only mode, each conversion reconstructs its points in its own buffer
+    std::vector<Point> points_buffer;
+    const Point* points = reinterpret_cast<const Point*>(raw.range.data());
+    if (settings.is_range_only)
+    {
+        if (size != settings.ray_x.size())
+        {
+            RCLCPP_ERROR_STREAM(LOGGER_BLAZE, "The depth map size (" << size << " pixels) does not match the ray table ("
+                                              << settings.ray_x.size() << " pixels)");
+            return false;
+        }
+        points_buffer.resize(size);
+        reconstructPoints(settings, reinterpret_cast<const uint16_t*>(raw.range.data()), points_buffer.data());
+        points = points_buffer.data();
+    }
+
+    convertBlazeData(settings, points, raw.intensity.data(), raw.confidence.data(),
+                     raw.width, raw.height, raw.min_depth, raw.max_depth, products,
+                     cloud_msg, intensity_map_msg, depth_map_msg, depth_map_color_msg, confidence_map_msg, nullptr);
+
+    return true;
+}
+
+void PylonROS2BlazeCamera::convertBlazeData(const BlazeConversionSettings& settings,
+                                            const Point* points, const uint16_t* pintensity, const uint16_t* pconfidence,
+                                            int width, int height, int min_depth, int max_depth, int products,
+                                            sensor_msgs::msg::PointCloud2& cloud_msg,
+                                            sensor_msgs::msg::Image& intensity_map_msg,
+                                            sensor_msgs::msg::Image& depth_map_msg,
+                                            sensor_msgs::msg::Image& depth_map_color_msg,
+                                            sensor_msgs::msg::Image& confidence_map_msg,
+                                            sensor_msgs::msg::Image* depth_image_msg)
+{
     // point cloud
-    this->convertGrabResultToPointCloud(container, cloud_msg);
-    
+    if (products & BP_POINT_CLOUD)
+    {
+        convertGrabResultToPointCloud(settings, points, pintensity, width, height, cloud_msg);
+        if (settings.is_normals_computed)
+        {
+            calculateNormals(settings, pconfidence, cloud_msg);
+        }
+    }
+
+    // All maps are written directly into the message buffers, which keep their
+    // capacity from frame to frame: nothing is allocated once the first frame is converted.
+
     // intensity
-    cv::Mat intensity_map = cv::Mat(height, width, CV_16UC1, (void*) intensity_component.GetData());
-    // Scale the intensity image since it often looks quite dark.
-    double  max;
-    cv::minMaxLoc(intensity_map, NULL, &max);
-    intensity_map /= (max / std::numeric_limits<uint16_t>::max());
-    // convert
-    cv_bridge::CvImage intensity_cv_img;
-    intensity_cv_img.encoding = sensor_msgs::image_encodings::MONO16;
-    intensity_cv_img.image    = intensity_map;
-    // define message
-    intensity_map_msg.header = intensity_cv_img.toImageMsg()->header;
-    intensity_map_msg.height = intensity_cv_img.toImageMsg()->height;
-    intensity_map_msg.width = intensity_cv_img.toImageMsg()->width;
-    intensity_map_msg.encoding = intensity_cv_img.toImageMsg()->encoding;
-    intensity_map_msg.is_bigendian = intensity_cv_img.toImageMsg()->is_bigendian;
-    intensity_map_msg.step = intensity_cv_img.toImageMsg()->step;
-    intensity_map_msg.data = intensity_cv_img.toImageMsg()->data;
+    if (products & BP_INTENSITY_MAP)
+    {
+        const cv::Mat intensity_map = cv::Mat(height, width, CV_16UC1, (void*) pintensity);
+        // Scale the intensity image since it often looks quite dark.
+        double  max;
+        cv::minMaxLoc(intensity_map, NULL, &max);
+        prepareImageMsg(intensity_map_msg, height, width, sensor_msgs::image_encodings::MONO16, sizeof(uint16_t));
+        cv::Mat intensity_dst = cv::Mat(height, width, CV_16UC1, intensity_map_msg.data.data(), intensity_map_msg.step);
+        intensity_map.convertTo(intensity_dst, CV_16UC1, max > 0 ? std::numeric_limits<uint16_t>::max() / max : 1.0);
+    }
 
     // depth map
-    uint16_t* pdepth_data = new uint16_t[width * height];
-    this->calculateDepthMap(range_component, min_depth, max_depth, pdepth_data);
-    cv::Mat depth_map = cv::Mat(height, width, CV_16UC1, pdepth_data);
-    free(pdepth_data);
-    // convert
-    cv_bridge::CvImage depth_map_cv_img;
-    depth_map_cv_img.encoding = sensor_msgs::image_encodings::MONO16;
-    depth_map_cv_img.image    = depth_map;
-    // define message
-    depth_map_msg.header = depth_map_cv_img.toImageMsg()->header;
-    depth_map_msg.height = depth_map_cv_img.toImageMsg()->height;
-    depth_map_msg.width = depth_map_cv_img.toImageMsg()->width;
-    depth_map_msg.encoding = depth_map_cv_img.toImageMsg()->encoding;
-    depth_map_msg.is_bigendian = depth_map_cv_img.toImageMsg()->is_bigendian;
-    depth_map_msg.step = depth_map_cv_img.toImageMsg()->step;
-    depth_map_msg.data = depth_map_cv_img.toImageMsg()->data;
+    if (products & BP_DEPTH_MAP)
+    {
+        prepareImageMsg(depth_map_msg, height, width, sensor_msgs::image_encodings::MONO16, sizeof(uint16_t));
+        calculateDepthMap(points, width, height, min_depth, max_depth, reinterpret_cast<uint16_t*>(depth_map_msg.data.data()));
+    }
 
     // depth map color
-    BGR* pdepth_data_color = new BGR[width * height];
-    this->calculateDepthMapColor(range_component, min_depth, max_depth, pdepth_data_color);
-    cv::Mat depth_map_color = cv::Mat(height, width, CV_8UC3, pdepth_data_color);
-    free(pdepth_data_color);
-    // convert
-    cv_bridge::CvImage depth_map_color_cv_img;
-    depth_map_color_cv_img.encoding = sensor_msgs::image_encodings::BGR8;
-    depth_map_color_cv_img.image    = depth_map_color;
-    // define message
-    depth_map_color_msg.header = depth_map_color_cv_img.toImageMsg()->header;
-    depth_map_color_msg.height = depth_map_color_cv_img.toImageMsg()->height;
-    depth_map_color_msg.width = depth_map_color_cv_img.toImageMsg()->width;
-    depth_map_color_msg.encoding = depth_map_color_cv_img.toImageMsg()->encoding;
-    depth_map_color_msg.is_bigendian = depth_map_color_cv_img.toImageMsg()->is_bigendian;
-    depth_map_color_msg.step = depth_map_color_cv_img.toImageMsg()->step;
-    depth_map_color_msg.data = depth_map_color_cv_img.toImageMsg()->data;
+    if (products & BP_DEPTH_COLOR_MAP)
+    {
+        prepareImageMsg(depth_map_color_msg, height, width, sensor_msgs::image_encodings::BGR8, sizeof(BGR));
+        calculateDepthMapColor(points, width, height, min_depth, max_depth, reinterpret_cast<BGR*>(depth_map_color_msg.data.data()));
+    }
 
     // confidence map
-    cv::Mat confidence_map = cv::Mat(height, width, CV_16UC1, (void*) confidence_component.GetData());
-    // convert
-    cv_bridge::CvImage confidence_cv_img;
-    confidence_cv_img.encoding = sensor_msgs::image_encodings::MONO16;
-    confidence_cv_img.image    = confidence_map;
-    // define message
-    confidence_map_msg.header = confidence_cv_img.toImageMsg()->header;
-    confidence_map_msg.height = confidence_cv_img.toImageMsg()->height;
-    confidence_map_msg.width = confidence_cv_img.toImageMsg()->width;
-    confidence_map_msg.encoding = confidence_cv_img.toImageMsg()->encoding;
-    confidence_map_msg.is_bigendian = confidence_cv_img.toImageMsg()->is_bigendian;
-    confidence_map_msg.step = confidence_cv_img.toImageMsg()->step;
-    confidence_map_msg.data = confidence_cv_img.toImageMsg()->data;
+    if (products & BP_CONFIDENCE_MAP)
+    {
+        prepareImageMsg(confidence_map_msg, height, width, sensor_msgs::image_encodings::MONO16, sizeof(uint16_t));
+        std::memcpy(confidence_map_msg.data.data(), pconfidence, confidence_map_msg.data.size());
+    }
 
-    return true;
+    // metric depth image
+    if (depth_image_msg != nullptr)
+    {
+        calculateDepthImage(settings, points, width, height, *depth_image_msg);
+    }
 }
 
-bool PylonROS2BlazeCamera::convertGrabResultToPointCloud(const Pylon::CPylonDataContainer& container,
+bool PylonROS2BlazeCamera::convertGrabResultToPointCloud(const BlazeConversionSettings& settings,
+                                                         const Point* points,
+                                                         const uint16_t* pintensity,
+                                                         size_t width,
+                                                         size_t height,
                                                          sensor_msgs::msg::PointCloud2& cloud_msg)
 {
     // An organized point cloud is used, i.e., for each camera pixel there is an entry 
@@ -604,51 +1016,217 @@ bool PylonROS2BlazeCamera::convertGrabResultToPointCloud(const Pylon::CPylonData
     // If the camera wasn't able to create depth information for a pixel, the x, y, and z coordinates 
     // are set to NaN. These NaNs will be retained in the PCL point cloud.
 
-    auto range_component = container.GetDataComponent(0);
-    auto intensity_component = container.GetDataComponent(1);
+    const size_t nr_fields = settings.is_normals_computed ? 8 : 4;
 
-    const size_t width = range_component.GetWidth();
-    const size_t height = range_component.GetHeight();
+    // The layout of pcl::PointXYZRGB (x, y, z, padding, rgb, padding) or pcl::PointXYZRGBNormal
+    // (x, y, z, padding, normal_x, normal_y, normal_z, padding, rgb, curvature, padding) is kept, the fields are
+    // only set up when the cloud size changes and the points are written directly into the message.
+    if (cloud_msg.width != width || cloud_msg.height != height || cloud_msg.fields.size() != nr_fields)
+    {
+        sensor_msgs::PointCloud2Modifier modifier(cloud_msg);
+        if (settings.is_normals_computed)
+        {
+            modifier.setPointCloud2Fields(8,
+                                          "x", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                          "y", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                          "z", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                          "rgb", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                          "normal_x", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                          "normal_y", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                          "normal_z", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                          "curvature", 1, sensor_msgs::msg::PointField::FLOAT32);
+            // setPointCloud2Fields packs the fields, the pcl layout is aligned on 16 bytes
+            cloud_msg.fields[3].offset = 32;
+            cloud_msg.fields[4].offset = 16;
+            cloud_msg.fields[5].offset = 20;
+            cloud_msg.fields[6].offset = 24;
+            cloud_msg.fields[7].offset = 36;
+            cloud_msg.point_step = sizeof(pcl::PointXYZRGBNormal);
+        }
+        else
+        {
+            modifier.setPointCloud2Fields(4,
+                                          "x", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                          "y", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                          "z", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                          "rgb", 1, sensor_msgs::msg::PointField::FLOAT32);
+            // setPointCloud2Fields packs the fields, the pcl layout is aligned on 16 bytes
+            cloud_msg.fields[3].offset = 16;
+            cloud_msg.point_step = sizeof(pcl::PointXYZRGB);
+        }
+        cloud_msg.width = width;
+        cloud_msg.height = height;
+        cloud_msg.row_step = cloud_msg.point_step * width;
+        cloud_msg.is_bigendian = false;
+        cloud_msg.is_dense = false; // organized point cloud
+        cloud_msg.data.assign(cloud_msg.row_step * height, 0);
+    }
 
-    // allocate PCL point cloud.
-    pcl::PointCloud<pcl::PointXYZRGB>::Ptr ppoint_cloud = std::make_shared<pcl::PointCloud<pcl::PointXYZRGB>>();
-    ppoint_cloud->width = width;
-    ppoint_cloud->height = height;
-    ppoint_cloud->points.resize(width * height);
-    ppoint_cloud->is_dense = false; // organized point cloud
+    if (settings.is_normals_computed)
+    {
+        fillPointCloud(settings, points, pintensity, width * height, reinterpret_cast<pcl::PointXYZRGBNormal*>(cloud_msg.data.data()));
+    }
+    else
+    {
+        fillPointCloud(settings, points, pintensity, width * height, reinterpret_cast<pcl::PointXYZRGB*>(cloud_msg.data.data()));
+    }
 
-    // Create a pointer to the 3D coordinates of the first point.
-    // imgParts[0] always refers to the point cloud data.
-    Point* psrc_point = (Point*) range_component.GetData();
+    return true;
+}
+
+template <typename PointT>
+void PylonROS2BlazeCamera::fillPointCloud(const BlazeConversionSettings& settings, const Point* points, const uint16_t* pintensity, size_t size, PointT* pdst_point)
+{
+    // Pointer to the 3D coordinates of the first point.
+    const Point* psrc_point = points;
 
-    // Create a pointer to the intensity information stored in the second buffer part.
-    uint16_t* pintensity = (uint16_t*)intensity_component.GetData();
+    // the static extrinsic (including the mm to m scale) is applied in the same pass, avoiding a tf2 transform of the whole cloud
+    const float* r = settings.cloud_rotation;
+    const float* t = settings.cloud_translation;
+    const bool is_transformed = settings.is_cloud_transformed;
 
     // Set the points.
-    for (size_t i = 0; i < height * width; ++i, ++psrc_point, ++pintensity)
+    for (size_t i = 0; i < size; ++i, ++psrc_point, ++pintensity, ++pdst_point)
     {
         // Set the X/Y/Z cordinates.
-        pcl::PointXYZRGB& dst_point = ppoint_cloud->points[i];
+        PointT& dst_point = *pdst_point;
 
-        dst_point.x = psrc_point->x * 0.001;
-        dst_point.y = psrc_point->y * 0.001;
-        dst_point.z = psrc_point->z * 0.001;
+        if (is_transformed)
+        {
+            // NaN points stay NaN
+            const float x = psrc_point->x, y = psrc_point->y, z = psrc_point->z;
+            dst_point.x = r[0] * x + r[1] * y + r[2] * z + t[0];
+            dst_point.y = r[3] * x + r[4] * y + r[5] * z + t[1];
+            dst_point.z = r[6] * x + r[7] * y + r[8] * z + t[2];
+        }
+        else
+        {
+            dst_point.x = psrc_point->x * 0.001;
+            dst_point.y = psrc_point->y * 0.001;
+            dst_point.z = psrc_point->z * 0.001;
+        }
+        dst_point.data[3] = 1.0f;
 
         // Use the intensity value of the pixel for coloring the point.
         dst_point.r = dst_point.g = dst_point.b = (uint8_t)(*pintensity >> 8);
+        dst_point.a = 255;
     }
+}
 
-    // convert from pcl to ros
-    pcl::toROSMsg(*ppoint_cloud, cloud_msg);
+void PylonROS2BlazeCamera::calculateNormals(const BlazeConversionSettings& settings, const uint16_t* pconfidence, sensor_msgs::msg::PointCloud2& cloud_msg)
+{
+    const int width = cloud_msg.width;
+    const int height = cloud_msg.height;
+    pcl::PointXYZRGBNormal* cloud = reinterpret_cast<pcl::PointXYZRGBNormal*>(cloud_msg.data.data());
+    const int min_confidence = settings.normals_min_confidence;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
 
-    return true;
+    // the normals are oriented towards the camera, whose origin is the translation of the cloud transform
+    const float viewpoint[3] = {settings.cloud_translation[0], settings.cloud_translation[1], settings.cloud_translation[2]};
+
+    // a point is used if it has depth information and a sufficient confidence
+    auto isUsable = [&](const int index) -> bool
+    {
+        return !std::isnan(cloud[index].z) && pconfidence[index] >= min_confidence;
+    };
+
+    for (int v = 0; v < height; ++v)
+    {
+        for (int u = 0; u < width; ++u)
+        {
+            const int i = v * width + u;
+            pcl::PointXYZRGBNormal& point = cloud[i];
+            point.data_n[3] = 0.0f;
+
+            if (!isUsable(i))
+            {
+                point.normal_x = point.normal_y = point.normal_z = point.curvature = nan;
+                continue;
+            }
+
+            // tangents from the central differences on the grid, one-sided at borders and holes
+            const int left = (u > 0 && isUsable(i - 1)) ? i - 1 : i;
+            const int right = (u < width - 1 && isUsable(i + 1)) ? i + 1 : i;
+            const int top = (v > 0 && isUsable(i - width)) ? i - width : i;
+            const int bottom = (v < height - 1 && isUsable(i + width)) ? i + width : i;
+            if (left == right || top == bottom)
+            {
+                point.normal_x = point.normal_y = point.normal_z = point.curvature = nan;
+                continue;
+            }
+
+            const float du[3] = {cloud[right].x - cloud[left].x, cloud[right].y - cloud[left].y, cloud[right].z - cloud[left].z};
+            const float dv[3] = {cloud[bottom].x - cloud[top].x, cloud[bottom].y - cloud[top].y, cloud[bottom].z - cloud[top].z};
+            float n[3] = {du[1] * dv[2] - du[2] * dv[1], du[2] * dv[0] - du[0] * dv[2], du[0] * dv[1] - du[1] * dv[0]};
+            const float norm = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (norm <= 0.0f)
+            {
+                point.normal_x = point.normal_y = point.normal_z = point.curvature = nan;
+                continue;
+            }
+            float scale = 1.0f / norm;
+            if (n[0] * (viewpoint[0] - point.x) + n[1] * (viewpoint[1] - point.y) + n[2] * (viewpoint[2] - point.z) < 0.0f)
+            {
+                scale = -scale;
+            }
+            n[0] *= scale;
+            n[1] *= scale;
+            n[2] *= scale;
+
+            // curvature: variance along the normal over the total variance of the 3x3 neighbourhood,
+            // i.e. the surface variation smallest eigenvalue / sum of the eigenvalues as estimated by pcl
+            float mean[3] = {0.0f, 0.0f, 0.0f};
+            int count = 0;
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    const int nu = u + dx, nv = v + dy;
+                    if (nu < 0 || nu >= width || nv < 0 || nv >= height || !isUsable(nv * width + nu))
+                    {
+                        continue;
+                    }
+                    const pcl::PointXYZRGBNormal& neighbour = cloud[nv * width + nu];
+                    mean[0] += neighbour.x;
+                    mean[1] += neighbour.y;
+                    mean[2] += neighbour.z;
+                    ++count;
+                }
+            }
+            mean[0] /= count;
+            mean[1] /= count;
+            mean[2] /= count;
+
+            float variance_normal = 0.0f;
+            float variance_total = 0.0f;
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    const int nu = u + dx, nv = v + dy;
+                    if (nu < 0 || nu >= width || nv < 0 || nv >= height || !isUsable(nv * width + nu))
+                    {
+                        continue;
+                    }
+                    const pcl::PointXYZRGBNormal& neighbour = cloud[nv * width + nu];
+                    const float d[3] = {neighbour.x - mean[0], neighbour.y - mean[1], neighbour.z - mean[2]};
+                    const float dn = d[0] * n[0] + d[1] * n[1] + d[2] * n[2];
+                    variance_normal += dn * dn;
+                    variance_total += d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+                }
+            }
+
+            point.normal_x = n[0];
+            point.normal_y = n[1];
+            point.normal_z = n[2];
+            point.curvature = variance_total > 0.0f ? variance_normal / variance_total : 0.0f;
+        }
+    }
 }
 
-void PylonROS2BlazeCamera::calculateDepthMap(const Pylon::CPylonDataComponent& pointCloud, int min_depth, int max_depth, uint16_t* pDepthMap)
+void PylonROS2BlazeCamera::calculateDepthMap(const Point* points, int width, int height, int min_depth, int max_depth, uint16_t* pDepthMap)
 {
-    const int width = pointCloud.GetWidth();
-    const int height = pointCloud.GetHeight();
-    const Point *pPoint = reinterpret_cast<const Point*>(pointCloud.GetData());
+    const Point *pPoint = points;
 
     const double scale = 65535.0 / (max_depth - min_depth);
 
@@ -676,11 +1254,9 @@ void PylonROS2BlazeCamera::calculateDepthMap(const Pylon::CPylonDataComponent& p
     }
 }
 
-void PylonROS2BlazeCamera::calculateDepthMapColor(const Pylon::CPylonDataComponent& pointCloud, int min_depth, int max_depth, BGR* pDepthMap)
+void PylonROS2BlazeCamera::calculateDepthMapColor(const Point* points, int width, int height, int min_depth, int max_depth, BGR* pDepthMap)
 {
-    const int width = pointCloud.GetWidth();
-    const int height = pointCloud.GetHeight();
-    const Point *pPoint = reinterpret_cast<const Point*>(pointCloud.GetData());
+    const Point *pPoint = points;
 
     const double scale = 65535.0 / (max_depth - min_depth);
 
@@ -732,6 +1308,119 @@ void PylonROS2BlazeCamera::calculateDepthMapColor(const Pylon::CPylonDataCompone
     }
 }
 
+void PylonROS2BlazeCamera::calculateDepthImage(const BlazeConversionSettings& settings, const Point* points, int width, int height, sensor_msgs::msg::Image& depth_image_msg)
+{
+    const size_t size = static_cast<size_t>(width) * height;
+    const bool is_range = settings.is_depth_image_range;
+
+    if (settings.is_depth_image_float)
+    {
+        // REP 118: metres, NaN if there is no depth
+        prepareImageMsg(depth_image_msg, height, width, sensor_msgs::image_encodings::TYPE_32FC1, sizeof(float));
+        float* pdepth = reinterpret_cast<float*>(depth_image_msg.data.data());
+        for (size_t i = 0; i < size; ++i)
+        {
+            const Point& point = points[i];
+            // NaN points stay NaN
+            const float depth_mm = is_range ? std::sqrt(point.x * point.x + point.y * point.y + point.z * point.z) : point.z;
+            pdepth[i] = depth_mm * 0.001f;
+        }
+    }
+    else
+    {
+        // REP 118: millimetres, 0 if there is no depth
+        prepareImageMsg(depth_image_msg, height, width, sensor_msgs::image_encodings::TYPE_16UC1, sizeof(uint16_t));
+        uint16_t* pdepth = reinterpret_cast<uint16_t*>(depth_image_msg.data.data());
+        for (size_t i = 0; i < size; ++i)
+        {
+            const Point& point = points[i];
+            if (!isValid(&point))
+            {
+                pdepth[i] = 0;
+                continue;
+            }
+            const float depth_mm = is_range ? std::sqrt(point.x * point.x + point.y * point.y + point.z * point.z) : point.z;
+            pdepth[i] = static_cast<uint16_t>(std::min(std::max(depth_mm + 0.5f, 0.0f), 65535.0f));
+        }
+    }
+}
+
+bool PylonROS2BlazeCamera::setupRangeReconstruction()
+{
+    try
+    {
+        // the depth map only holds the C coordinate
+        blaze_cam_->Scan3dCoordinateSelector.SetValue(Pylon::BlazeCameraParams_Params::Scan3dCoordinateSelector_CoordinateC);
+        conversion_.range_scale = static_cast<float>(blaze_cam_->Scan3dCoordinateScale.GetValue());
+        conversion_.range_offset = static_cast<float>(blaze_cam_->Scan3dCoordinateOffset.GetValue());
+
+        const size_t width = static_cast<size_t>(blaze_cam_->Width.GetValue());
+        const size_t height = static_cast<size_t>(blaze_cam_->Height.GetValue());
+        const double f = blaze_cam_->Scan3dFocalLength.GetValue();
+        const double cx = blaze_cam_->Scan3dPrincipalPointU.GetValue();
+        const double cy = blaze_cam_->Scan3dPrincipalPointV.GetValue();
+
+        // x = (u - cx) * z / f and y = (v - cy) * z / f
+        conversion_.ray_x.resize(width * height);
+        conversion_.ray_y.resize(width * height);
+        for (size_t v = 0; v < height; ++v)
+        {
+            for (size_t u = 0; u < width; ++u)
+            {
+                conversion_.ray_x[v * width + u] = static_cast<float>((u - cx) / f);
+                conversion_.ray_y[v * width + u] = static_cast<float>((v - cy) / f);
+            }
+        }
+        range_points_.resize(width * height);
+
+        RCLCPP_DEBUG_STREAM(LOGGER_BLAZE, "Range reconstruction set up for " << width << "x" << height
+                                          << " pixels, scale: " << conversion_.range_scale << ", offset: " << conversion_.range_offset);
+    }
+    catch (const GenICam::GenericException &e)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BLAZE, "An exception occurred while setting up the range reconstruction: " << e.GetDescription());
+        return false;
+    }
+
+    return true;
+}
+
+const Point* PylonROS2BlazeCamera::reconstructPoints(const Pylon::CPylonDataComponent& range_component)
+{
+    const size_t size = range_component.GetWidth() * range_component.GetHeight();
+    if (size != conversion_.ray_x.size())
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_BLAZE, "The depth map size (" << size << " pixels) does not match the ray table ("
+                                          << conversion_.ray_x.size() << " pixels)");
+        return nullptr;
+    }
+
+    reconstructPoints(conversion_, reinterpret_cast<const uint16_t*>(range_component.GetData()), range_points_.data());
+
+    return range_points_.data();
+}
+
+void PylonROS2BlazeCamera::reconstructPoints(const BlazeConversionSettings& settings, const uint16_t* depth_map, Point* pdst)
+{
+    const size_t size = settings.ray_x.size();
+    const uint16_t* __restrict__ depth = depth_map;
+    const float* __restrict__ ray_x = settings.ray_x.data();
+    const float* __restrict__ ray_y = settings.ray_y.data();
+    float* __restrict__ dst = reinterpret_cast<float*>(pdst);
+    const float scale = settings.range_scale;
+    const float offset = settings.range_offset;
+    const float invalid = std::numeric_limits<float>::quiet_NaN();
+
+    // branch-free, so that the compiler vectorizes the loop; a raw value of 0 marks a missing depth
+    for (size_t i = 0; i < size; ++i)
+    {
+        const float z = depth[i] != 0 ? depth[i] * scale + offset : invalid;
+        dst[3 * i] = ray_x[i] * z;
+        dst[3 * i + 1] = ray_y[i] * z;
+        dst[3 * i + 2] = z;
+    }
+}
+
 void PylonROS2BlazeCamera::getInitialCameraInfo(sensor_msgs::msg::CameraInfo& cam_info_msg)
 {
     // https://github.com/ros2/common_interfaces/blob/master/sensor_msgs/msg/CameraInfo.msg
@@ -748,7 +1437,7 @@ void PylonROS2BlazeCamera::getInitialCameraInfo(sensor_msgs::msg::CameraInfo& ca
 
     // The distortion parameters, size depending on the distortion model.
     // For "plumb_bob", the 5 parameters are: (k1, k2, t1, t2, k3) -> float64[] d.
-    cam_info_msg.d = std::vector<double>(5, 0.);
+    cam_info_msg.d.assign(5, 0.);
 
     const double f = blaze_cam_->Scan3dFocalLength.GetValue();
     const double cx = blaze_cam_->Scan3dPrincipalPointU.GetValue();
@@ -45,6 +45,26 @@
 namespace pylon_ros2_camera
 {
 
+/**
+ * Configuration event handler raising the removal flag of a camera as soon as
+ * pylon detects the removal of its device, independently of any grab call.
+ */
+class PylonROS2DeviceRemovalHandler : public Pylon::CConfigurationEventHandler
+{
+public:
+    explicit PylonROS2DeviceRemovalHandler(std::atomic<bool>& is_device_removed)
+        : is_device_removed_(is_device_removed)
+    {}
+
+    virtual void OnCameraDeviceRemoved(Pylon::CInstantCamera& /*camera*/)
+    {
+        is_device_removed_ = true;
+    }
+
+private:
+    std::atomic<bool>& is_device_removed_;
+};
+
 template <typename CameraTraitT>
 class PylonROS2CameraImpl : public PylonROS2Camera
 {
@@ -61,6 +81,14 @@ public:
 
     virtual bool isCamRemoved();
 
+    virtual void releaseDevice();
+
+    virtual bool restartStream(const STREAM_RECOVERY_STEP& step);
+
+    virtual bool setInternalThreadPriority(const int& priority);
+
+    virtual bool setHeartbeatTimeout(const int& timeout_ms);
+
     virtual bool setupSequencer(const std::vector<float>& exposure_times);
 
     virtual bool applyCamSpecificStartupSettings(const PylonROS2CameraParameter& parameters);
@@ -75,6 +103,12 @@ public:
 
     virtual bool setShutterMode(const pylon_ros2_camera::SHUTTER_MODE& mode);
 
+    virtual bool moveROI(const int64_t& offset_x, const int64_t& offset_y,
+                         sensor_msgs::msg::RegionOfInterest& reached_roi);
+
+    virtual bool setMultipleROI(const std::vector<ROIZone>& target_rows, const std::vector<ROIZone>& target_columns,
+                                std::vector<ROIZone>& reached_rows, std::vector<ROIZone>& reached_columns);
+
     virtual bool setROI(const sensor_msgs::msg::RegionOfInterest target_roi,
                         sensor_msgs::msg::RegionOfInterest& reached_roi);
     
@@ -121,6 +155,10 @@ public:
 
     virtual int imagePixelDepth() const;
 
+    virtual std::string outputROSEncoding() const;
+
+    virtual int outputPixelDepth() const;
+
     virtual float currentExposure();
 
     virtual float currentAutoExposureTimeLowerLimit();
@@ -239,6 +277,8 @@ public:
 
     virtual std::string loadPfs(const std::string& fileName);
 
+    virtual bool applyStartupSnapshot(const std::string& fileName);
+
     virtual std::string setUserSetDefaultSelector(const int& set);
 
     virtual int getUserSetDefaultSelector();
@@ -261,6 +301,8 @@ public:
 
     virtual std::string gammaEnable(const bool& enable);
 
+    virtual std::string setLookupTable(const std::vector<uint16_t>& values);
+
     virtual float getTemperature();
 
     virtual std::string setWhiteBalance(const double& redValue, const double& greenValue, const double& blueValue);
@@ -365,6 +407,17 @@ public:
                            sensor_msgs::msg::Image& depth_map_msg, 
                            sensor_msgs::msg::Image& depth_map_color_msg, 
                            sensor_msgs::msg::Image& confidence_map_msg);
+
+    virtual bool grabBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
+                           sensor_msgs::msg::Image& intensity_map_msg, 
+                           sensor_msgs::msg::Image& depth_map_msg, 
+                           sensor_msgs::msg::Image& depth_map_color_msg, 
+                           sensor_msgs::msg::Image& confidence_map_msg,
+                           sensor_msgs::msg::Image& depth_image_msg);
+
+    virtual bool grabBlazeRaw(BlazeRawData& raw);
+
+    virtual bool blazeConversionSettings(BlazeConversionSettings& settings);
     
     virtual std::string setDepthMin(const int& depth_min);
 
@@ -465,6 +518,32 @@ protected:
 
     virtual bool setupSequencer(const std::vector<float>& exposure_times,
                                 std::vector<float>& exposure_times_set);
+
+    /**
+     * Looks up the ROS encoding of the current pixel format, only if the pixel
+     * format changed since the last call, so that the grab loop does not convert strings.
+     * @return false if there is no ROS equivalent to the current pixel format.
+     */
+    bool updateEncodingCache() const;
+
+    /**
+     * @return true if the current pixel format is tone mapped to 8 bit in grab()
+     */
+    bool isToneMapped() const;
+
+    /**
+     * Copies a frame out of the pylon buffer, shifting or tone mapping the 12 bit
+     * formats and applying the sensor correction in the same pass.
+     */
+    void copyFrame(const uint8_t* src, uint8_t* dst);
+
+    // encoding of the current pixel format, see updateEncodingCache()
+    mutable int64_t cached_pixel_format_ = -1;
+    mutable std::string cached_ros_encoding_;
+    mutable bool is_12_bit_shift_needed_ = false;
+    mutable bool is_single_channel_ = false;
+    mutable bool is_bayer_ = false;
+    mutable std::string cached_tone_mapped_encoding_;
 };
 
 }  // namespace pylon_ros2_camera
@@ -0,0 +1,318 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Pool of worker threads processing frames in parallel and publishing them in order.
+ * A frame is split into parts, processed in parallel by the workers, each one with its own
+ * context (e.g., compression contexts). The frame slots are allocated once at start,
+ * so that their buffers keep their capacity from frame to frame.
+ * @tparam FrameT data of a frame slot
+ * @tparam ContextT context of a worker thread, default constructed in the thread
+ */
+template <typename FrameT, typename ContextT>
+class OrderedWorkerPool
+{
+
+public:
+    struct Slot
+    {
+        FrameT frame;
+        std::atomic<int> remaining_parts{0};
+        std::atomic<bool> is_failed{false};
+        bool is_done = false;
+    };
+
+    // processes a part of a frame, returns false if it failed
+    using ProcessFunction = std::function<bool(FrameT& frame, const int& part, ContextT& context)>;
+    // called once all the parts of a frame are processed
+    using PublishFunction = std::function<void(FrameT& frame, const bool& is_failed)>;
+
+    OrderedWorkerPool();
+
+    virtual ~OrderedWorkerPool();
+
+    /**
+     * Starts the worker threads, with one frame slot more than threads, so that a frame
+     * can be prepared while the others are processed
+     * @param threads number of worker threads
+     * @param parts number of parts of a frame
+     * @param thread_setup called first in each worker thread, e.g., to set its scheduling
+     * @param process called for each part of a frame, from a worker thread
+     * @param publish called with each frame, in the order of the frames, from a worker thread
+     * @return the number of worker threads
+     */
+    int start(const int& threads, const int& parts, const std::function<void()>& thread_setup,
+              const ProcessFunction& process, const PublishFunction& publish);
+
+    /**
+     * Stops the worker threads, the frames being processed are dropped
+     */
+    void stop();
+
+    bool isStarted() const;
+
+    /**
+     * Takes a free frame slot, without waiting for it
+     * @return nullptr if all the frame slots are in use
+     */
+    Slot* acquire();
+
+    /**
+     * Queues the parts of an acquired frame slot
+     */
+    void submit(Slot* slot);
+
+private:
+    void work();
+
+    /**
+     * Publishes the processed frames at the front of the queue and frees their slots
+     */
+    void publishDone(Slot* slot);
+
+    int parts_;
+    std::function<void()> thread_setup_;
+    ProcessFunction process_;
+    PublishFunction publish_;
+
+    // the frame slots, not resized while started
+    std::vector<std::unique_ptr<Slot>> slots_;
+
+    // free slots and parts to process, protected by mutex_
+    std::vector<Slot*> free_slots_;
+    std::deque<std::pair<Slot*, int>> tasks_;
+    bool is_stopping_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+
+    // frames being processed, in the order of the frames, protected by publish_mutex_
+    std::deque<Slot*> pending_slots_;
+    std::mutex publish_mutex_;
+
+    std::vector<std::thread> threads_;
+};
+
+template <typename FrameT, typename ContextT>
+OrderedWorkerPool<FrameT, ContextT>::OrderedWorkerPool() :
+    parts_(1),
+    thread_setup_(),
+    process_(),
+    publish_(),
+    slots_(),
+    free_slots_(),
+    tasks_(),
+    is_stopping_(false),
+    pending_slots_(),
+    threads_()
+{
+}
+
+template <typename FrameT, typename ContextT>
+OrderedWorkerPool<FrameT, ContextT>::~OrderedWorkerPool()
+{
+    this->stop();
+}
+
+template <typename FrameT, typename ContextT>
+int OrderedWorkerPool<FrameT, ContextT>::start(const int& threads, const int& parts, const std::function<void()>& thread_setup,
+                                               const ProcessFunction& process, const PublishFunction& publish)
+{
+    this->stop();
+
+    parts_ = std::max(parts, 1);
+    thread_setup_ = thread_setup;
+    process_ = process;
+    publish_ = publish;
+
+    const int nr_threads = std::max(threads, 1);
+    for (int i = 0; i < nr_threads + 1; ++i)
+    {
+        slots_.emplace_back(new Slot());
+        free_slots_.push_back(slots_.back().get());
+    }
+
+    for (int i = 0; i < nr_threads; ++i)
+    {
+        threads_.emplace_back(&OrderedWorkerPool::work, this);
+    }
+
+    return nr_threads;
+}
+
+template <typename FrameT, typename ContextT>
+void OrderedWorkerPool<FrameT, ContextT>::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_stopping_ = true;
+    }
+    condition_.notify_all();
+
+    for (std::thread& thread : threads_)
+    {
+        thread.join();
+    }
+    threads_.clear();
+
+    std::lock_guard<std::mutex> publish_lock(publish_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.clear();
+    pending_slots_.clear();
+    free_slots_.clear();
+    slots_.clear();
+    is_stopping_ = false;
+}
+
+template <typename FrameT, typename ContextT>
+bool OrderedWorkerPool<FrameT, ContextT>::isStarted() const
+{
+    return !threads_.empty();
+}
+
+template <typename FrameT, typename ContextT>
+typename OrderedWorkerPool<FrameT, ContextT>::Slot* OrderedWorkerPool<FrameT, ContextT>::acquire()
+{
+    if (!this->isStarted())
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_slots_.empty())
+    {
+        return nullptr;
+    }
+    Slot* slot = free_slots_.back();
+    free_slots_.pop_back();
+    return slot;
+}
+
+template <typename FrameT, typename ContextT>
+void OrderedWorkerPool<FrameT, ContextT>::submit(Slot* slot)
+{
+    slot->remaining_parts = parts_;
+    slot->is_failed = false;
+
+    {
+        std::lock_guard<std::mutex> publish_lock(publish_mutex_);
+        slot->is_done = false;
+        pending_slots_.push_back(slot);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int part = 0; part < parts_; ++part)
+        {
+            tasks_.emplace_back(slot, part);
+        }
+    }
+
+    if (parts_ == 1)
+    {
+        condition_.notify_one();
+    }
+    else
+    {
+        condition_.notify_all();
+    }
+}
+
+template <typename FrameT, typename ContextT>
+void OrderedWorkerPool<FrameT, ContextT>::work()
+{
+    if (thread_setup_)
+    {
+        thread_setup_();
+    }
+
+    ContextT context;
+
+    while (true)
+    {
+        std::pair<Slot*, int> task(nullptr, 0);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return is_stopping_ || !tasks_.empty(); });
+            if (is_stopping_)
+            {
+                return;
+            }
+            task = tasks_.front();
+            tasks_.pop_front();
+        }
+
+        Slot* slot = task.first;
+        if (!process_(slot->frame, task.second, context))
+        {
+            slot->is_failed = true;
+        }
+
+        if (--slot->remaining_parts == 0)
+        {
+            this->publishDone(slot);
+        }
+    }
+}
+
+template <typename FrameT, typename ContextT>
+void OrderedWorkerPool<FrameT, ContextT>::publishDone(Slot* slot)
+{
+    std::lock_guard<std::mutex> publish_lock(publish_mutex_);
+    slot->is_done = true;
+
+    // a frame processed before the previous ones waits for them
+    while (!pending_slots_.empty() && pending_slots_.front()->is_done)
+    {
+        Slot* front = pending_slots_.front();
+        pending_slots_.pop_front();
+
+        publish_(front->frame, front->is_failed);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_slots_.push_back(front);
+    }
+}
+
+}  // namespace pylon_ros2_camera
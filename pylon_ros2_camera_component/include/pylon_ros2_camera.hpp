@@ -29,8 +29,10 @@
 #pragma once
 
 #include <string>
+#include <utility>
 #include <vector>
 #include <map>
+#include <atomic>
 
 #include "sensor_msgs/msg/camera_info.hpp"
 #include "sensor_msgs/msg/region_of_interest.hpp"
@@ -39,6 +41,9 @@
 
 #include "pylon_ros2_camera_parameter.hpp"
 #include "binary_exposure_search.hpp"
+#include "frame_tracer.hpp"
+#include "sensor_correction.hpp"
+#include "tone_mapping.hpp"
 
 
 namespace pylon_ros2_camera
@@ -48,6 +53,78 @@ namespace pylon_ros2_camera
 #define CHANNEL_MONO8 1
 #define CHANNEL_RGB8  3
 
+/**
+ * Recovery steps of a stalled stream, from the cheapest to the most expensive one.
+ * Each step includes the previous ones.
+ */
+enum STREAM_RECOVERY_STEP
+{
+    SRS_RESTART_GRABBING = 1,
+    SRS_REOPEN_DEVICE = 2,
+};
+
+/**
+ * Products converted from a blaze data set, combined as flags.
+ */
+enum BLAZE_PRODUCT
+{
+    BP_POINT_CLOUD = 1,
+    BP_INTENSITY_MAP = 2,
+    BP_DEPTH_MAP = 4,
+    BP_DEPTH_COLOR_MAP = 8,
+    BP_CONFIDENCE_MAP = 16,
+    BP_ALL = 31,
+};
+
+/**
+ * Zone of the multiple ROI: offset and size, in rows or in columns of the sensor.
+ */
+typedef std::pair<size_t, size_t> ROIZone;
+
+/**
+ * Copy of a blaze data set, as grabbed, so that it can be converted later on.
+ */
+struct BlazeRawData
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Coord3D_ABC32f points or Coord3D_C16 depth map (range only mode)
+    std::vector<uint8_t> range;
+    std::vector<uint16_t> intensity;
+    std::vector<uint16_t> confidence;
+    // depth range at the time of the grab, used to scale the depth maps
+    int min_depth = 0;
+    int max_depth = 0;
+};
+
+/**
+ * Copy of the blaze settings needed to convert a data set, so that the conversion does not access the
+ * camera, which may be reconfigured or deleted meanwhile.
+ */
+struct BlazeConversionSettings
+{
+    // range only mode: the depth map (Coord3D_C16) is converted to mm with scale and offset,
+    // the 3D point of a pixel is its depth times its ray (x/z, y/z, 1)
+    bool is_range_only = false;
+    float range_scale = 1.0f;
+    float range_offset = 0.0f;
+    std::vector<float> ray_x;
+    std::vector<float> ray_y;
+
+    // metric depth image settings
+    bool is_depth_image_float = true;
+    bool is_depth_image_range = false;
+
+    // static extrinsic applied to the point cloud, the rotation includes the mm to m scale
+    bool is_cloud_transformed = false;
+    float cloud_rotation[9] = {0.001f, 0.0f, 0.0f, 0.0f, 0.001f, 0.0f, 0.0f, 0.0f, 0.001f};
+    float cloud_translation[3] = {0.0f, 0.0f, 0.0f};
+
+    // surface normals, added to the point cloud
+    bool is_normals_computed = false;
+    int normals_min_confidence = 0;
+};
+
 /**
  * The PylonROS2Camera base class. Create a new instance using the static create() functions.
  */
@@ -69,6 +146,29 @@ public:
      */
     static PylonROS2Camera* create(const std::string& device_user_id);
 
+    /**
+     * Create a new PylonROS2Camera instance without enumerating all devices of all
+     * transport layers. The full name is used for a direct device creation. Otherwise,
+     * the device is searched by serial number and / or IP address on the relevant
+     * transport layers only (unicast discovery for an IP address on GigE).
+     * @param serial_number The serial number of the camera, may be empty.
+     * @param ip_address The IP address of the camera (GigE, blaze), may be empty.
+     * @param full_name The pylon full name of the camera, may be empty.
+     * @return new PylonROS2Camera instance or NULL if the camera was not found.
+     */
+    static PylonROS2Camera* createDirect(const std::string& serial_number,
+                                         const std::string& ip_address,
+                                         const std::string& full_name);
+
+    /**
+     * Create a new PylonROS2Camera instance for the same device as an already existing
+     * (e.g., removed) camera instance. The device is looked up by its cached serial
+     * number on its own transport layer only, which avoids a full device enumeration.
+     * @param removed_camera The camera instance whose device has to be reopened.
+     * @return new PylonROS2Camera instance or NULL if the device is not available (yet).
+     */
+    static PylonROS2Camera* recreate(const PylonROS2Camera& removed_camera);
+
     /**
      * Configures the camera according to the software trigger mode.
      * @return true if all the configuration could be set up.
@@ -87,6 +187,39 @@ public:
      */
     virtual bool isCamRemoved() = 0;
 
+    /**
+     * Releases the pylon device attached to the camera object, e.g., after its
+     * removal has been detected. The pylon runtime remains initialized until
+     * the camera object is deleted.
+     */
+    virtual void releaseDevice() = 0;
+
+    /**
+     * Restarts a stalled image stream while keeping the device and its configuration.
+     * @param step SRS_RESTART_GRABBING stops and restarts grabbing, which also closes and
+     *             reopens the stream grabber with fresh buffers, SRS_REOPEN_DEVICE additionally
+     *             closes and reopens the device connection.
+     * @return true if the grabbing could be restarted.
+     */
+    virtual bool restartStream(const STREAM_RECOVERY_STEP& step) = 0;
+
+    /**
+     * Sets the priority of the pylon internal threads, i.e., the grab engine thread
+     * and the receive thread of the stream grabber (GigE only). Has to be called
+     * before the grabbing is started.
+     * @param priority The real-time priority (1 - 99) of the threads.
+     * @return true if the priority could be set for at least one of the threads.
+     */
+    virtual bool setInternalThreadPriority(const int& priority) = 0;
+
+    /**
+     * Sets the heartbeat timeout of the transport layer (GigE only). A shorter
+     * timeout leads to a faster detection of a device removal.
+     * @param timeout_ms The heartbeat timeout in ms.
+     * @return true if the timeout could be set.
+     */
+    virtual bool setHeartbeatTimeout(const int& timeout_ms) = 0;
+
     /**
      * Configure the sequencer exposure times.
      * @param exposure_times the list of exposure times.
@@ -148,6 +281,52 @@ public:
                            sensor_msgs::msg::Image& depth_map_color_msg, 
                            sensor_msgs::msg::Image& confidence_map_msg) = 0;
 
+    /**
+     * Dedicated to blaze integration within the pylon driver - grab data from blaze and return ros messages,
+     * including the metric depth image (16UC1 in mm or 32FC1 in m, holding Z or the range), computed in the same pass
+     * @return true if the process is successful.
+     */
+    virtual bool grabBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
+                           sensor_msgs::msg::Image& intensity_map_msg, 
+                           sensor_msgs::msg::Image& depth_map_msg, 
+                           sensor_msgs::msg::Image& depth_map_color_msg, 
+                           sensor_msgs::msg::Image& confidence_map_msg,
+                           sensor_msgs::msg::Image& depth_image_msg) = 0;
+
+    /**
+     * Dedicated to blaze integration within the pylon driver - grab a data set from blaze and copy it
+     * without converting it, so that data sets can be grabbed back-to-back at the camera frame rate
+     * @param raw the copy of the grabbed data set
+     * @return true if the process is successful.
+     */
+    virtual bool grabBlazeRaw(BlazeRawData& raw) = 0;
+
+    /**
+     * Dedicated to blaze integration within the pylon driver - copy the settings needed to convert the data sets
+     * grabbed with grabBlazeRaw(). They are read at startup, the copy stays valid once the camera is deleted.
+     * @param settings the copy of the conversion settings
+     * @return true if the process is successful.
+     */
+    virtual bool blazeConversionSettings(BlazeConversionSettings& settings) = 0;
+
+    /**
+     * Dedicated to blaze integration within the pylon driver - convert a data set grabbed with grabBlazeRaw()
+     * into ros messages. The camera is not accessed, the function can be called concurrently from several
+     * threads on different data sets.
+     * @param settings the conversion settings, copied with blazeConversionSettings()
+     * @param raw the grabbed data set
+     * @param products the products to convert, as BLAZE_PRODUCT flags. The other messages are left untouched.
+     * @return true if the process is successful.
+     */
+    static bool convertBlazeRaw(const BlazeConversionSettings& settings,
+                                const BlazeRawData& raw,
+                                const int& products,
+                                sensor_msgs::msg::PointCloud2& cloud_msg,
+                                sensor_msgs::msg::Image& intensity_map_msg, 
+                                sensor_msgs::msg::Image& depth_map_msg, 
+                                sensor_msgs::msg::Image& depth_map_color_msg, 
+                                sensor_msgs::msg::Image& confidence_map_msg);
+
     /**
      * @brief sets shutter mode for the camera (rolling or global_reset)
      * @param mode
@@ -163,6 +342,29 @@ public:
      */
     virtual bool setROI(const sensor_msgs::msg::RegionOfInterest target_roi,
 			sensor_msgs::msg::RegionOfInterest& reached_roi) = 0;
+
+    /**
+     * Moves the area of interest, keeping its size, without stopping the grabbing
+     * if the camera accepts new offsets while grabbing
+     * @param offset_x the target x offset, adapted to the increment and the sensor size
+     * @param offset_y the target y offset, adapted to the increment and the sensor size
+     * @param reached_roi the roi that could be set
+     * @return false if an error occurred
+     */
+    virtual bool moveROI(const int64_t& offset_x, const int64_t& offset_y,
+                         sensor_msgs::msg::RegionOfInterest& reached_roi) = 0;
+
+    /**
+     * Configures the multiple ROI of the camera (ace 2 and boost): only the row and column
+     * zones are read out, the frame is their compact combination, zone after zone
+     * @param target_rows the row zones, in increasing order, empty for the full height
+     * @param target_columns the column zones, in increasing order, empty for the full width
+     * @param reached_rows the row zones that could be set, the full height if there is none
+     * @param reached_columns the column zones that could be set, the full width if there is none
+     * @return false if the camera has no multiple ROI or the zones could not be set
+     */
+    virtual bool setMultipleROI(const std::vector<ROIZone>& target_rows, const std::vector<ROIZone>& target_columns,
+                                std::vector<ROIZone>& reached_rows, std::vector<ROIZone>& reached_columns) = 0;
     
     /**
      * Sets the target horizontal binning_x factor
@@ -321,6 +523,19 @@ public:
      */
     virtual int imagePixelDepth() const = 0;
 
+    /**
+     * Get the encoding of the images returned by grab(), which differs from
+     * currentROSEncoding() if the 12 bit formats are tone mapped to 8 bit
+     * @return the ros image pixel encoding of the grabbed images.
+     */
+    virtual std::string outputROSEncoding() const = 0;
+
+    /**
+     * Get the number of bytes per pixel of the images returned by grab()
+     * @return number of bytes per pixel of the grabbed images
+     */
+    virtual int outputPixelDepth() const = 0;
+
     /**
      * Returns the current exposure time in microseconds.
      * @return the exposure time in microseconds.
@@ -417,6 +632,58 @@ public:
      */
     const std::string& deviceUserID() const;
 
+    /**
+     * Getter for the serial number of the used camera, cached at creation
+     * @return the serial number
+     */
+    const std::string& deviceSerialNumber() const;
+
+    /**
+     * Getter for the number of frames lost since the camera was created, detected
+     * as gaps in the chunk frame counter. Only counted if the chunk mode and the
+     * frame counter chunk are enabled.
+     * @return the number of dropped frames
+     */
+    uint64_t droppedFrames() const;
+
+    /**
+     * Getter for the frame counter of the last grabbed frame: the chunk frame
+     * counter if available, the transport layer block id otherwise.
+     * @return the frame counter
+     */
+    int64_t frameCounter() const;
+
+    /**
+     * Getter for the x offset of the last grabbed frame, as read out by the camera:
+     * while the roi moves, it lags the current offset by the frames in flight.
+     * @return the x offset of the last grabbed frame
+     */
+    size_t frameOffsetX() const;
+
+    /**
+     * Getter for the y offset of the last grabbed frame, as read out by the camera.
+     * @return the y offset of the last grabbed frame
+     */
+    size_t frameOffsetY() const;
+
+    /**
+     * Sets the tracer recording the grab stages of each frame.
+     * @param tracer The tracer, owned by the caller, nullptr to disable the tracing.
+     */
+    void setFrameTracer(FrameTracer* tracer);
+
+    /**
+     * Sets the sensor correction applied while the mono and bayer frames are copied in grab().
+     * @param correction The correction, owned by the caller, nullptr to disable the correction.
+     */
+    void setSensorCorrection(SensorCorrection* correction);
+
+    /**
+     * Sets the tone mapping of the 12 bit mono and bayer formats to 8 bit, applied in grab().
+     * @param tone_mapping The tone mapping, owned by the caller, nullptr to disable the tone mapping.
+     */
+    void setToneMapping(ToneMapping* tone_mapping);
+
     /**
      * Getter for the image height
      * @return number of rows in the image
@@ -766,6 +1033,16 @@ public:
      */
     virtual std::string loadPfs(const std::string& fileName) = 0;
 
+    /**
+     * Restores a startup snapshot (pfs file) of the camera configuration.
+     * The current device state is read in one pass and only the features
+     * differing from the snapshot are written.
+     * Replaces applyCamSpecificStartupSettings() for a fast startup.
+     * @param fileName : Path to the pfs snapshot file
+     * @return true if the snapshot could be restored.
+     */
+    virtual bool applyStartupSnapshot(const std::string& fileName) = 0;
+
     /**
      * set camera user set default selector
      * @param set : 0 = Default, 1 = UserSet1, 2 = UserSet2, 3 = UserSet3, 4 = HighGain, 5 = AutoFunctions, 6 = ColorRaw
@@ -838,6 +1115,13 @@ public:
      */
     virtual std::string gammaEnable(const bool& enable) = 0;
 
+    /**
+     * load and enable the luminance LUT of the camera
+     * @param values : 4096 values (0 - 4095), one per 12 bit pixel value
+     * @return error message if an error occurred or done message otherwise.
+     */
+    virtual std::string setLookupTable(const std::vector<uint16_t>& values) = 0;
+
     /**
      * returns the current internal camera temperature
      * @return 0.0 if error or unknown
@@ -1278,6 +1562,62 @@ protected:
      */
     std::string device_user_id_;
 
+    /**
+     * The serial number of the found camera, used to reopen it after a removal
+     */
+    std::string device_serial_number_;
+
+    /**
+     * The pylon device class (i.e., transport layer) of the found camera
+     */
+    std::string device_class_;
+
+    /**
+     * Flag set by the pylon device removal callback
+     */
+    std::atomic<bool> is_device_removed_;
+
+    /**
+     * Number of frames lost, detected as gaps in the chunk frame counter
+     */
+    uint64_t dropped_frames_;
+
+    /**
+     * Chunk frame counter of the last grabbed frame, -1 if not available
+     */
+    int64_t last_chunk_frame_counter_;
+
+    /**
+     * Frame counter of the last grabbed frame
+     */
+    int64_t last_frame_counter_;
+
+    /**
+     * Offsets of the last grabbed frame
+     */
+    size_t last_offset_x_;
+    size_t last_offset_y_;
+
+    /**
+     * Tracer of the frame path, not owned
+     */
+    FrameTracer* frame_tracer_;
+
+    /**
+     * Sensor correction applied in grab(), not owned
+     */
+    SensorCorrection* sensor_correction_;
+
+    /**
+     * Set if the ROI or the binning changed, so that the sensor correction maps are selected again
+     */
+    bool is_sensor_geometry_changed_;
+
+    /**
+     * Tone mapping applied in grab(), not owned
+     */
+    ToneMapping* tone_mapping_;
+
     /**
      * Number of image rows.
      */
@@ -0,0 +1,120 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_lifecycle/lifecycle_node.hpp>
+#include <rclcpp_lifecycle/lifecycle_publisher.hpp>
+#include <rclcpp_components/register_node_macro.hpp>
+
+#include "visibility_control.hpp"
+
+#include <sensor_msgs/msg/image.hpp>
+#include <sensor_msgs/msg/camera_info.hpp>
+
+// camera
+#include "pylon_ros2_camera.hpp"
+#include "pylon_ros2_camera_parameter.hpp"
+
+#include <camera_info_manager/camera_info_manager.hpp>
+
+#include <memory>
+#include <mutex>
+
+
+namespace pylon_ros2_camera
+{
+
+using CallbackReturn = rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
+
+/**
+ * Lifecycle managed variant of the pylon camera node, publishing the raw images
+ * and the camera info. The expensive startup steps are done during the
+ * configuration, so that a configured (inactive) camera can be kept in warm
+ * standby and goes live with a single stream start:
+ * - configure: opens the camera and applies the complete startup configuration
+ * - activate: starts the image acquisition and the publishing
+ * - deactivate: stops the image acquisition, the camera stays open and configured
+ * - cleanup / shutdown: closes the camera
+ * The blaze camera is not supported by this node.
+ */
+class PylonROS2CameraLifecycleNode : public rclcpp_lifecycle::LifecycleNode
+{
+
+public:
+  PYLON_ROS2_CAMERA_PUBLIC
+  explicit PylonROS2CameraLifecycleNode(const rclcpp::NodeOptions& options);
+  virtual ~PylonROS2CameraLifecycleNode();
+
+protected:
+
+  CallbackReturn on_configure(const rclcpp_lifecycle::State& previous_state) override;
+  CallbackReturn on_activate(const rclcpp_lifecycle::State& previous_state) override;
+  CallbackReturn on_deactivate(const rclcpp_lifecycle::State& previous_state) override;
+  CallbackReturn on_cleanup(const rclcpp_lifecycle::State& previous_state) override;
+  CallbackReturn on_shutdown(const rclcpp_lifecycle::State& previous_state) override;
+
+  /**
+   * @brief Creates and opens the camera and applies the startup settings
+   * @return false if an error occurred
+   */
+  bool openAndConfigureCamera();
+
+  /**
+   * @brief Applies the image settings given as parameters (binning, exposure, gain, gamma)
+   */
+  void applyImageSettings();
+
+  /**
+   * @brief Closes the camera and releases the publishers
+   */
+  void releaseResources();
+
+  /**
+   * @brief Grabs and publishes an image, called at frame rate while active
+   */
+  void spin();
+
+  PylonROS2Camera* pylon_camera_;
+  PylonROS2CameraParameter pylon_camera_parameter_set_;
+
+  std::shared_ptr<camera_info_manager::CameraInfoManager> camera_info_manager_;
+
+  sensor_msgs::msg::Image img_raw_msg_;
+
+  rclcpp_lifecycle::LifecyclePublisher<sensor_msgs::msg::Image>::SharedPtr img_raw_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<sensor_msgs::msg::CameraInfo>::SharedPtr camera_info_pub_;
+
+  // spinning timer, only existing while active
+  rclcpp::TimerBase::SharedPtr timer_;
+  // mutex
+  std::recursive_mutex grab_mutex_;
+};
+
+} // namespace pylon_ros2_camera
@@ -41,6 +41,7 @@
 
 #include <sensor_msgs/msg/image.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
+#include <sensor_msgs/msg/region_of_interest.hpp>
 
 // services
 #include "pylon_ros2_camera_interfaces/srv/get_integer_value.hpp"
@@ -72,6 +73,12 @@
 // camera
 #include "pylon_ros2_camera.hpp"
 #include "pylon_ros2_camera_parameter.hpp"
+#include "rgbd_registration.hpp"
+#include "blaze_compressor.hpp"
+#include "image_encoder_pool.hpp"
+#include "video_encoder.hpp"
+#include "shm_frame_writer.hpp"
+#include "cv_mat_type_adapter.hpp"
 
 #include <camera_info_manager/camera_info_manager.hpp>
 #include <image_geometry/pinhole_camera_model.h>
@@ -84,6 +91,11 @@
 
 #include <diagnostic_updater/diagnostic_updater.hpp>
 
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 
 namespace pylon_ros2_camera
 {
@@ -115,6 +127,8 @@ using GrabImagesGoalHandle          = rclcpp_action::ServerGoalHandle<GrabImages
 using GrabBlazeDataAction           = pylon_ros2_camera_interfaces::action::GrabBlazeData;
 using GrabBlazeDataGoalHandle       = rclcpp_action::ServerGoalHandle<GrabBlazeDataAction>;
 
+// scheduling of the thread running the acquisition, defined with the node
+class AcquisitionThreadScheduling;
 
 class PylonROS2CameraNode : public rclcpp::Node
 {
@@ -136,7 +150,39 @@ public:
    */
   const std::string& cameraFrame() const;
 
+  /**
+   * @brief Getter for the tf frame of the blaze point cloud.
+   * @return the blaze cloud frame if set, the camera frame otherwise.
+   */
+  const std::string& blazeCloudFrame() const;
+
+  /**
+   * @brief Getter for the initialization state of the node.
+   * @return true if the camera could be opened and started.
+   */
+  bool isInitialized() const;
+
+  /**
+   * Processing times of a frame path stage, accumulated between two diagnostics updates
+   */
+  struct StageStatistics
+  {
+    double sum_ms = 0.0;
+    double max_ms = 0.0;
+    size_t count = 0;
+  };
+
 protected:
+
+  /**
+   * @brief Constructor with a factory of the camera instance, used in place of the device
+   * lookup (e.g., to run the node on a simulated camera in the tests).
+   * @param options node options
+   * @param camera_factory creates the camera instance, the devices are looked up if empty
+   */
+  PYLON_ROS2_CAMERA_PUBLIC
+  PylonROS2CameraNode(const rclcpp::NodeOptions& options,
+                      const std::function<PylonROS2Camera*()>& camera_factory);
   
   /**
    * @brief initialize the camera and the node. Calls ros::shutdown if an error occurs.
@@ -168,12 +214,69 @@ protected:
    */
   void initDiagnostics();
 
+  /**
+   * @brief initialize the diagnostics of the frame path (publish rate, frame age,
+   * dropped frames and processing times), once the parameters are read
+   */
+  void initFramePathDiagnostics();
+
   /**
    * @brief Creates the camera instance and starts the services and action servers.
    * @return false if an error occurred
    */
   bool initAndRegister();
 
+  /**
+   * @brief Creates the camera instance, either directly from its serial number, IP address
+   * or full name, or by enumerating the devices and matching the device user id.
+   * @return the camera instance or nullptr if the camera is not available
+   */
+  PylonROS2Camera* createCamera();
+
+  /**
+   * @brief Registers the camera configuration, opens the camera and applies the startup settings.
+   * @return false if an error occurred
+   */
+  bool setupCamera();
+
+  /**
+   * @brief Looks once for a removed camera by its cached serial number, at most every
+   * reconnect_poll_interval, and restarts grabbing with the current parameter set if it is back.
+   * Called from the spin loop without waiting, so that the executor is not blocked.
+   * @return false if the camera could not be reconnected (yet)
+   */
+  bool reconnect();
+
+  /**
+   * @brief Stream watchdog, called after each grab of the spin loop. If the grabs keep failing
+   * while the camera is not removed, longer than the configured window, the next recovery step is taken.
+   * @param frame_received true if the grab succeeded
+   */
+  void updateStreamWatchdog(const bool& frame_received);
+
+  /**
+   * @brief Takes the next step to recover a stalled stream: restart grabbing (with a
+   * reopened stream grabber), reopen the device and finally reset the device. Each step is timed and logged.
+   */
+  void recoverStream();
+
+  /**
+   * @brief Pre-faults the image message buffer and locks the process memory, including
+   * the pylon image buffers, into RAM.
+   */
+  void lockMemory();
+
+  /**
+   * @brief Records the duration of a startup phase, measured from the end of the previous one.
+   * @param phase name of the phase
+   */
+  void recordStartupPhase(const std::string& phase);
+
+  /**
+   * @brief Logs the durations of the recorded startup phases.
+   */
+  void logStartupTiming();
+
   /**
    * @brief Start the camera and initialize the messages
    * @return false if an error occured
@@ -518,6 +621,56 @@ protected:
    */
   uint32_t getNumSubscribersRectImagePub() const;
 
+  /**
+   * @brief Return the number of subscribers for the raw image topic
+   * @return The number of subscribers for the raw image topic
+   */
+  uint32_t getNumSubscribersRawImagePub() const;
+
+  /**
+   * @brief Get a buffer of the frame memory pool, not used by any published image
+   * @param size the size of the buffer in bytes
+   * @return the buffer, shared with the images wrapping it, or nullptr if the subscribers
+   * hold all the buffers of the pool
+   */
+  std::shared_ptr<std::vector<uint8_t>> acquireImageBuffer(const size_t& size);
+
+  /**
+   * @brief Check if the blaze metric depth image or its camera info is subscribed
+   * @return true if at least one of them is subscribed
+   */
+  bool isDepthImageSubscribed() const;
+
+  /**
+   * @brief Check if a blaze of the same process registers its point cloud with the frames of this camera
+   * @return true if the registration channel has a consumer
+   */
+  bool isRegistrationConsumed() const;
+
+  /**
+   * @brief Check if the compressed blaze output is enabled and subscribed
+   * @return true if the compressed blaze data has to be produced
+   */
+  bool isBlazeCompressedSubscribed() const;
+
+  /**
+   * @brief Check if the compressed image output is enabled and subscribed
+   * @return true if the frames have to be encoded
+   */
+  bool isEncodedImageSubscribed() const;
+
+  /**
+   * @brief Check if the video output is enabled and subscribed
+   * @return true if the frames have to be encoded as video
+   */
+  bool isVideoSubscribed() const;
+
+  /**
+   * @brief Check if one of the zones of the multiple ROI is subscribed
+   * @return true if the frames have to be split into zones
+   */
+  bool isZoneSubscribed() const;
+
   /**
    * @brief Service callback for getting the maximum number of buffers that can be used simultaneously for grabbing images - Applies to: BCON, GigE, USB and blaze.
    * @param req request
@@ -1420,6 +1573,14 @@ protected:
   void triggerDeviceResetCallback(const std::shared_ptr<TriggerSrv::Request> request,
                                   std::shared_ptr<TriggerSrv::Response> response);
 
+  /**
+   * @brief Service callback for dumping the per-stage latency histograms of the traced frames
+   * @param req request
+   * @param res response
+   */
+  void dumpFrameTracesCallback(const std::shared_ptr<TriggerSrv::Request> request,
+                               std::shared_ptr<TriggerSrv::Response> response);
+
   /**
    * @brief Service callback for starting camera aqcuisition
    * @param req request
@@ -1531,11 +1692,61 @@ protected:
    */
   void createCameraInfoDiagnostics(diagnostic_updater::DiagnosticStatusWrapper &stat);
 
+  /**
+   * @brief Create frame path diagnostics: dropped frames and per-stage processing times since the last update
+   * @param stat Diagnostic status wrapper
+   */
+  void createFramePathDiagnostics(diagnostic_updater::DiagnosticStatusWrapper &stat);
+
   /**
    * @brief Callback to diagnostics
    */
   void diagnosticsTimerCallback();
 
+  /**
+   * @brief Refreshes the camera info published with the images if the one of the camera
+   * info manager changed, e.g., due to a 'set_camera_info'-service call
+   */
+  void cameraInfoTimerCallback();
+
+  /**
+   * @brief Stores the camera info in the camera info manager and refreshes the one published with the images
+   * @param cam_info the new camera info
+   */
+  void updateCameraInfo(const sensor_msgs::msg::CameraInfo& cam_info);
+
+  /**
+   * @brief Refreshes the camera info published with the images from the camera info manager,
+   * after a change of the ROI or binning or a 'set_camera_info'-service call, and the camera
+   * infos of the zones of the multiple ROI
+   */
+  void refreshCameraInfo();
+
+  /**
+   * @brief Stores the latest target of the tracking window, applied before the next grab
+   * @param msg region to center the window on (e.g., the bounding box of the tracked target),
+   * or its top left corner if width and height are 0
+   */
+  void trackingROICallback(const sensor_msgs::msg::RegionOfInterest::SharedPtr msg);
+
+  /**
+   * @brief Moves the tracking window to the latest target, if a new one was received
+   */
+  void applyTrackingROI();
+
+  /**
+   * @brief Splits the compact frame of the multiple ROI into one image per zone, published with
+   * the camera info of the zone (principal point moved by the offsets of the zone)
+   */
+  void publishZones();
+
+  /**
+   * @brief Updates the rectification settings (target encoding, debayering)
+   * if the encoding of the raw image changed
+   * @return false if the raw image can't be rectified
+   */
+  bool updateRectificationCache();
+
   /**
    * @brief Check if service exists
    * @param service_name Service name
@@ -1622,6 +1833,7 @@ protected:
 protected:
 
   // camera
+  std::function<PylonROS2Camera*()> camera_factory_;
   PylonROS2Camera* pylon_camera_;
   image_geometry::PinholeCameraModel* pinhole_model_;
 
@@ -1632,9 +1844,54 @@ protected:
 
   cv_bridge::CvImage* cv_bridge_img_rect_;
 
+  // camera info published with the raw image, refreshed whenever the camera info manager is written
+  sensor_msgs::msg::CameraInfo cam_info_msg_;
+  // camera info of the manager the published one was computed from, compared outside of the frame loop
+  sensor_msgs::msg::CameraInfo managed_cam_info_msg_;
+  rclcpp::TimerBase::SharedPtr camera_info_timer_;
+
+  // rectification buffers, reused from frame to frame
+  sensor_msgs::msg::Image img_rect_msg_;
+  cv::Mat debayered_img_;
+  std::string rect_source_encoding_;
+  int rect_source_cv_type_;
+  int rect_bayer_code_;
+
   sensor_msgs::msg::PointCloud2 blaze_cloud_msg_;
   sensor_msgs::msg::Image intensity_map_msg_, depth_map_msg_, depth_map_color_msg_, confidence_map_msg_;
   sensor_msgs::msg::CameraInfo blaze_cam_info_msg_;
+  // metric depth image, only computed if subscribed
+  sensor_msgs::msg::Image depth_image_msg_;
+  // set by the grab which computed the depth image, reset by the next one
+  bool is_depth_image_computed_;
+  // in-process channel the frames are posted to for the RGB-D registration (area-scan cameras only)
+  std::shared_ptr<ColorFrameChannel> registration_channel_;
+  // compressed blaze output, compressed on worker threads
+  BlazeCompressor blaze_compressor_;
+  // compressed image output (area-scan cameras only), encoded on worker threads
+  ImageEncoderPool image_encoder_pool_;
+  // video output (area-scan cameras only), encoded on a thread of its own
+  VideoEncoder video_encoder_;
+  // shared-memory frame ring for the processes of the same host (area-scan cameras only)
+  ShmFrameWriter shm_writer_;
+  // dark-frame, flat-field and defective pixel correction, applied by the camera while copying the frames
+  SensorCorrection sensor_correction_;
+  // 12 to 8 bit tone mapping, applied by the camera while copying the frames
+  ToneMapping tone_mapping_;
+  // frame memory of the images published as cv::Mat, reused once the subscribers released it
+  std::vector<std::shared_ptr<std::vector<uint8_t>>> image_buffers_;
+  // tracking window, moved to the latest target received on the tracking_roi topic
+  rclcpp::Subscription<sensor_msgs::msg::RegionOfInterest>::SharedPtr tracking_roi_sub_;
+  std::mutex tracking_roi_mutex_;
+  sensor_msgs::msg::RegionOfInterest tracking_roi_target_;
+  bool is_tracking_roi_target_pending_;
+  // zones of the multiple ROI as read out by the camera, the frame is split into rows x columns images
+  std::vector<ROIZone> multi_roi_rows_;
+  std::vector<ROIZone> multi_roi_columns_;
+  std::vector<image_transport::CameraPublisher> zone_pubs_;
+  std::vector<sensor_msgs::msg::Image> zone_msgs_;
+  // camera infos of the zones, computed whenever the camera info changes
+  std::vector<sensor_msgs::msg::CameraInfo> zone_infos_;
 
   // topics
   rclcpp::Publisher<pylon_ros2_camera_interfaces::msg::CurrentParams>::SharedPtr current_params_pub_;
@@ -1644,6 +1901,12 @@ protected:
   // image transport publishers
   image_transport::CameraPublisher img_raw_pub_;
   image_transport::Publisher* img_rect_pub_;
+  rclcpp::Publisher<sensor_msgs::msg::CompressedImage>::SharedPtr img_encoded_pub_;
+  rclcpp::Publisher<pylon_ros2_camera_interfaces::msg::VideoPacket>::SharedPtr video_pub_;
+  // type adapted publishers replacing the image transport ones if intra_process_images is set
+  rclcpp::Publisher<CvMatImage>::SharedPtr img_raw_cv_pub_;
+  rclcpp::Publisher<sensor_msgs::msg::CameraInfo>::SharedPtr cam_info_pub_;
+  rclcpp::Publisher<CvMatImage>::SharedPtr img_rect_cv_pub_;
   // blaze related topics
   std::string blaze_cloud_topic_name_;
   std::string blaze_intensity_topic_name_;
@@ -1656,6 +1919,9 @@ protected:
   rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr blaze_depth_map_color_pub_;
   rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr blaze_confidence_pub_;
   rclcpp::Publisher<sensor_msgs::msg::CameraInfo>::SharedPtr blaze_cam_info_pub_;
+  rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr blaze_depth_image_pub_;
+  rclcpp::Publisher<sensor_msgs::msg::CameraInfo>::SharedPtr blaze_depth_cam_info_pub_;
+  rclcpp::Publisher<pylon_ros2_camera_interfaces::msg::CompressedBlazeData>::SharedPtr blaze_compressed_pub_;
 
   // services
   rclcpp::Service<GetIntegerSrv>::SharedPtr get_max_num_buffer_srv_;
@@ -1782,6 +2048,7 @@ protected:
   rclcpp::Service<TriggerSrv>::SharedPtr save_user_set_srv_;
   rclcpp::Service<TriggerSrv>::SharedPtr load_user_set_srv_;
   rclcpp::Service<TriggerSrv>::SharedPtr reset_device_srv_;
+  rclcpp::Service<TriggerSrv>::SharedPtr dump_frame_traces_srv_;
   rclcpp::Service<TriggerSrv>::SharedPtr start_grabbing_srv_;
   rclcpp::Service<TriggerSrv>::SharedPtr stop_grabbing_srv_;
   rclcpp::Service<TriggerSrv>::SharedPtr update_sync_free_run_timer_srv_;
@@ -1805,7 +2072,45 @@ protected:
 
   bool is_sleeping_;
 
+  // reconnection after a camera removal
+  bool is_reconnecting_;
+  bool is_waiting_for_camera_;
+  std::chrono::steady_clock::time_point reconnect_start_time_;
+  std::chrono::steady_clock::time_point last_reconnect_attempt_time_;
+
+  // stream watchdog
+  int grab_failures_;
+  int watchdog_recovery_step_;
+  std::chrono::steady_clock::time_point last_frame_time_;
+  std::chrono::steady_clock::time_point stream_stall_start_time_;
+
+  // real-time settings
+  std::unique_ptr<AcquisitionThreadScheduling> acquisition_scheduling_;
+  uint64_t reported_dropped_frames_;
+
+  // tracing of the frame path
+  FrameTracer frame_tracer_;
+
+  // processing times of the frame path stages since the last diagnostics update
+  StageStatistics grab_statistics_;
+  StageStatistics rectification_statistics_;
+  StageStatistics publish_statistics_;
+  uint64_t diagnostics_dropped_frames_;
+
+  // startup timing and fast startup
+  std::chrono::steady_clock::time_point startup_phase_start_;
+  std::vector<std::pair<std::string, double>> startup_phases_;
+  std::string startup_snapshot_file_;
+  bool is_startup_snapshot_restored_;
+
   // diagnostics
+  double min_publish_frequency_;
+  double max_publish_frequency_;
+  std::unique_ptr<diagnostic_updater::FrequencyStatus> frequency_status_;
+  std::unique_ptr<diagnostic_updater::TimeStampStatus> timestamp_status_;
+  // host time at which the last frame was received, the age of the published frames is measured from it
+  rclcpp::Time frame_receive_time_;
+  rclcpp::TimerBase::SharedPtr diagnostics_timer_;
   diagnostic_updater::Updater diagnostics_updater_;
 };
 
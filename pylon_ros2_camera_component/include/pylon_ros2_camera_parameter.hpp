@@ -59,7 +59,8 @@ public:
      * to the default values.
      * @param nh the ros::NodeHandle to use
      */
-    void readFromRosParameterServer(rclcpp::Node& nh);
+    template <typename NodeT>
+    void readFromRosParameterServer(NodeT& nh);
 
     /**
      * Getter for the device_user_id_ set from ros-parameter server
@@ -70,13 +71,22 @@ public:
      * Setter for the device_user_id_  to the class and as well
      * the ros-parameter server
      */
-    void setDeviceUserId(rclcpp::Node& nh, const std::string& device_user_id);
+    template <typename NodeT>
+    void setDeviceUserId(NodeT& nh, const std::string& device_user_id);
 
     /**
      * Getter for the string describing the shutter mode
      */
     std::string shutterModeString() const;
 
+    /**
+     * Stable hash (FNV-1a) over all parameters of the node, which may affect the startup
+     * configuration of the camera, except the ones rewritten by the node while running.
+     * Used to key the startup snapshot of a camera device.
+     */
+    template <typename NodeT>
+    std::string startupSettingsHash(NodeT& nh) const;
+
     /**
      * Getter for the camera_frame_ set from ros-parameter server
      */
@@ -95,13 +105,15 @@ public:
     /**
      * Setter for the image encoding
      */
-    void setimageEncodingParam(rclcpp::Node& nh, const std::string& format); 
+    template <typename NodeT>
+    void setimageEncodingParam(NodeT& nh, const std::string& format); 
 
     /**
      * Setter for the frame_rate_ initially set from ros-parameter server
      * The frame rate needs to be updated with the value the camera supports
      */
-    void setFrameRate(rclcpp::Node& nh, const double& frame_rate);
+    template <typename NodeT>
+    void setFrameRate(NodeT& nh, const double& frame_rate);
 
     /**
      * Getter for the camera_info_url set from ros-parameter server
@@ -112,7 +124,8 @@ public:
      * Setter for the camera_info_url_ if a new CameraInfo-Msgs Object is
      * provided via the SetCameraInfo-service from the CameraInfoManager
      */
-    void setCameraInfoURL(rclcpp::Node& nh, const std::string& camera_info_url);
+    template <typename NodeT>
+    void setCameraInfoURL(NodeT& nh, const std::string& camera_info_url);
 
 public:
     /** Binning factor to get downsampled images. It refers here to any camera
@@ -285,6 +298,338 @@ public:
      */
     int frame_transmission_delay_;
 
+    /**
+     * The heartbeat timeout in ms. Only used for GigE cameras.
+     * A shorter timeout leads to a faster detection of a camera removal.
+     * A value of 0 keeps the default timeout of the device.
+     */
+    int heartbeat_timeout_;
+
+    /**
+     * The interval in ms at which a removed camera is looked for again
+     * in order to reconnect to it.
+     */
+    int reconnect_poll_interval_;
+
+    /**
+     * The time in ms a removed camera is looked for by its serial number, before
+     * falling back to a complete reinitialization. A value of 0 keeps looking for it.
+     */
+    int reconnect_timeout_;
+
+    /**
+     * The number of consecutive failed grabs after which the stream watchdog
+     * starts its escalating recovery. A value of 0 disables this criterion.
+     */
+    int watchdog_max_failures_;
+
+    /**
+     * The time in ms without any grabbed frame, while grabs are failing, after which
+     * the stream watchdog starts its escalating recovery. A value of 0 disables this criterion.
+     */
+    int watchdog_timeout_;
+
+    /**
+     * The CPU cores the acquisition thread (the thread grabbing and publishing the images)
+     * is pinned to. If empty, the thread is not pinned.
+     */
+    std::vector<int64_t> acquisition_cpus_;
+
+    /**
+     * The SCHED_FIFO priority (1 - 99) of the acquisition thread.
+     * A value of 0 keeps the default scheduling policy.
+     */
+    int acquisition_priority_;
+
+    /**
+     * The nice value of the acquisition thread, only used if no SCHED_FIFO priority is given.
+     * A value of 0 keeps the current nice value.
+     */
+    int acquisition_nice_;
+
+    /**
+     * The CPU cores the processing worker threads (action execution) are pinned to.
+     * If empty, the threads are not pinned.
+     */
+    std::vector<int64_t> worker_cpus_;
+
+    /**
+     * The SCHED_FIFO priority (1 - 99) of the processing worker threads.
+     * A value of 0 keeps the default scheduling policy.
+     */
+    int worker_priority_;
+
+    /**
+     * The nice value of the processing worker threads, only used if no SCHED_FIFO priority is given.
+     * A value of 0 keeps the current nice value.
+     */
+    int worker_nice_;
+
+    /**
+     * The real-time priority (1 - 99) of the pylon internal threads (grab engine and GigE receive thread).
+     * A value of 0 keeps the pylon default.
+     */
+    int pylon_thread_priority_;
+
+    /**
+     * Flag that indicates if the process memory, including the image buffers, is
+     * pre-faulted and locked into RAM once the grabbing is started.
+     */
+    bool lock_memory_;
+
+    /**
+     * The number of frames whose per-stage timestamps are kept for the latency analysis.
+     * A value of 0 disables the tracing.
+     */
+    int trace_buffer_size_;
+
+    /**
+     * The tolerated relative deviation of the publish rate from the frame rate, reported by the diagnostics.
+     */
+    double diagnostics_frequency_tolerance_;
+
+    /**
+     * The maximum age in s of a frame at publish time (now - header stamp), reported by the diagnostics.
+     */
+    double diagnostics_max_frame_age_;
+
+    /**
+     * Flag that indicates if the blaze sends its range as 16 bit depth map (Coord3D_C16)
+     * instead of 32 bit float point cloud (Coord3D_ABC32f). The 3D points are then
+     * reconstructed by the driver. Only used for the blaze.
+     */
+    bool blaze_range_only_;
+
+    /**
+     * The encoding of the blaze metric depth image: 16UC1 (mm) or 32FC1 (m).
+     */
+    std::string blaze_depth_image_encoding_;
+
+    /**
+     * The content of the blaze metric depth image: z (distance along the optical axis) or range (radial distance).
+     */
+    std::string blaze_depth_image_content_;
+
+    /**
+     * The frame the blaze point cloud is published in. If empty, the point cloud
+     * is published in the camera frame and not transformed.
+     */
+    std::string blaze_cloud_frame_;
+
+    /**
+     * The static transform from the camera frame to the cloud frame (pose of the camera
+     * in the cloud frame) [x, y, z, qx, qy, qz, qw], translation in m. It is applied
+     * while converting the blaze data.
+     */
+    std::vector<double> blaze_cloud_transform_;
+
+    /**
+     * Flag that indicates if the surface normals and curvatures of the blaze point cloud
+     * are estimated and added to it (normal_x, normal_y, normal_z, curvature fields).
+     */
+    bool blaze_compute_normals_;
+
+    /**
+     * The minimum confidence (0 - 65535) of a blaze point to be used for the normal estimation.
+     */
+    int blaze_normals_min_confidence_;
+
+    /**
+     * The name of the in-process channel used for the RGB-D registration. An area-scan
+     * camera posts its frames to it, a blaze colors its point cloud with them.
+     * Both nodes must run in the same process. If empty, there is no registration.
+     */
+    std::string registration_channel_;
+
+    /**
+     * The static transform from the blaze camera frame to the color camera frame (pose of
+     * the blaze in the color camera frame) [x, y, z, qx, qy, qz, qw], translation in m.
+     */
+    std::vector<double> blaze_registration_transform_;
+
+    /**
+     * The maximum time offset in ms between the hardware timestamps of a blaze frame
+     * and of the color frame it is registered with.
+     */
+    double blaze_registration_max_time_offset_;
+
+    /**
+     * The codec of the compressed blaze output (blaze_compressed topic): lz4 or zstd.
+     * If empty, there is no compressed output.
+     */
+    std::string blaze_compression_;
+
+    /**
+     * The compression level for zstd (1 - 22), the acceleration for lz4 (1 = best compression).
+     */
+    int blaze_compression_level_;
+
+    /**
+     * The quantization step of the compressed point coordinates in mm.
+     * If 0, the float coordinates are compressed lossless.
+     */
+    double blaze_compression_quantization_;
+
+    /**
+     * The number of worker threads compressing the blaze data.
+     */
+    int blaze_compression_threads_;
+
+    /**
+     * The format of the compressed image output (image_encoded/compressed topic): jpeg or png.
+     * If empty, there is no compressed output. Not used for the blaze.
+     */
+    std::string compressed_format_;
+
+    /**
+     * The JPEG quality (1 - 100) of the compressed image output.
+     */
+    int compressed_jpeg_quality_;
+
+    /**
+     * The PNG compression level (0 - 9) of the compressed image output.
+     */
+    int compressed_png_level_;
+
+    /**
+     * The number of worker threads encoding the compressed image output.
+     */
+    int compressed_threads_;
+
+    /**
+     * The codec of the video output (video topic): h264 or h265.
+     * If empty, there is no video output. Not used for the blaze.
+     */
+    std::string video_codec_;
+
+    /**
+     * The target bitrate of the video output in kbit/s.
+     */
+    int video_bitrate_;
+
+    /**
+     * The distance between two key frames of the video output in frames.
+     */
+    int video_gop_;
+
+    /**
+     * The preset of the video encoder, from ultrafast to veryslow.
+     */
+    std::string video_preset_;
+
+    /**
+     * The downscale factor (0 - 1] of the frames before the video encoding.
+     */
+    double video_scale_;
+
+    /**
+     * The name of the POSIX shared-memory object the frames are written to, e.g., "/my_camera",
+     * for the processes of the same host that are not ROS nodes. If empty, there is no
+     * shared-memory output. Not used for the blaze.
+     */
+    std::string shm_name_;
+
+    /**
+     * The number of frame slots of the shared-memory ring.
+     */
+    int shm_slots_;
+
+    /**
+     * Flag that indicates if image_raw and image_rect are published as cv::Mat through
+     * an rclcpp type adapter (CvMatImage) instead of image_transport, so that the subscribers
+     * of the same process receive them without serialization nor conversion. Not used for the blaze.
+     */
+    bool intra_process_images_;
+
+    /**
+     * The root directory of the sensor correction maps (dark frame, flat field, defective pixels),
+     * organized by serial number and sensor geometry. If empty, there is no correction. Not used for the blaze.
+     */
+    std::string sensor_correction_dir_;
+
+    /**
+     * The curve mapping the 12 bit mono and bayer formats to 8 bit: gamma, log or file.
+     * If empty, the 12 bit formats are published as 16 bit. Not used for the blaze.
+     */
+    std::string tone_mapping_curve_;
+
+    /**
+     * The exponent of the gamma curve, e.g., 0.45 to brighten the shadows.
+     */
+    double tone_mapping_gamma_;
+
+    /**
+     * The file of the user-supplied curve: 4096 values (0 - 255), one per 12 bit pixel value.
+     */
+    std::string tone_mapping_lut_file_;
+
+    /**
+     * Flag that indicates if the curve is loaded into the LUT of the camera, if the camera has one.
+     */
+    bool tone_mapping_on_camera_;
+
+    /**
+     * The width of the tracking window: a small ROI moved while grabbing to the offsets received
+     * on the tracking_roi topic, for the higher frame rates of a small readout. If 0, there is
+     * no tracking. Not used for the blaze.
+     */
+    int tracking_roi_width_;
+
+    /**
+     * The height of the tracking window.
+     */
+    int tracking_roi_height_;
+
+    /**
+     * The row zones of the multiple ROI (ace 2 and boost): offset and height of each zone,
+     * e.g., [100, 64, 800, 64]. Only these rows are read out, the frame is split again into
+     * one image per zone. If empty, the full height. Not used for the blaze.
+     */
+    std::vector<int64_t> multi_roi_rows_;
+
+    /**
+     * The column zones of the multiple ROI: offset and width of each zone. If empty, the full width.
+     */
+    std::vector<int64_t> multi_roi_columns_;
+
+    /**
+     * The serial number of the camera to open. If set, the camera is opened
+     * without enumerating the devices of all transport layers.
+     */
+    std::string device_serial_number_;
+
+    /**
+     * The IP address of the camera to open (GigE and blaze only). If set, the
+     * camera is opened through a unicast discovery.
+     */
+    std::string device_ip_address_;
+
+    /**
+     * The pylon full name of the camera to open. If set, the camera device is
+     * created directly, without any enumeration.
+     */
+    std::string device_full_name_;
+
+    /**
+     * Flag that indicates if ROS is shut down when the camera cannot be
+     * initialized. Disabled when several cameras run in the same process.
+     */
+    bool shutdown_on_init_failure_;
+
+    /**
+     * Flag that indicates if the fast startup mode is used. In this mode, a
+     * snapshot of the camera configuration is stored after the first complete
+     * startup (keyed by serial number and startup settings). On later startups,
+     * only the features differing from this snapshot are written to the camera.
+     */
+    bool fast_startup_;
+
+    /**
+     * The directory where the startup snapshots are stored.
+     * If empty, '~/.ros/pylon_ros2_camera' is used.
+     */
+    std::string startup_snapshot_dir_;
+
     /**
       Shutter mode
     */
@@ -344,7 +689,8 @@ protected:
      * to the default values.
      * @param nh the ros::NodeHandle to use
      */
-    void validateParameterSet(rclcpp::Node& nh);
+    template <typename NodeT>
+    void validateParameterSet(NodeT& nh);
 
     /**
      * The tf frame under which the images were published
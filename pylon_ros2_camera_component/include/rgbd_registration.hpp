@@ -0,0 +1,243 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <rclcpp/clock.hpp>
+#include <sensor_msgs/msg/camera_info.hpp>
+#include <sensor_msgs/msg/image.hpp>
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Color frame with the intrinsics of the camera it comes from
+ */
+struct ColorFrame
+{
+    // hardware timestamp in ns, 0 if the slot was never written
+    int64_t stamp_ns = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t step = 0;
+    std::string encoding;
+    std::vector<uint8_t> data;
+    // plumb_bob intrinsics (k row-major, d = k1, k2, p1, p2, k3) and calibrated image size
+    std::array<double, 9> k;
+    std::array<double, 5> d;
+    uint32_t calibration_width = 0;
+    uint32_t calibration_height = 0;
+};
+
+/**
+ * Process-wide channel through which an area-scan camera node hands its latest frames
+ * to a blaze running in the same process, for the RGB-D registration.
+ * The frames are kept in a small ring of slots, each protected by its own mutex:
+ * the writer skips a slot being read, so that the color acquisition is never blocked.
+ */
+class ColorFrameChannel
+{
+
+public:
+    /**
+     * Returns the channel of the given name, created on first use
+     */
+    static std::shared_ptr<ColorFrameChannel> get(const std::string& name);
+
+    /**
+     * @param capacity number of frames kept
+     */
+    explicit ColorFrameChannel(const size_t& capacity = 4);
+
+    virtual ~ColorFrameChannel();
+
+    /**
+     * Registers or unregisters a consumer. Frames are only posted while there is a consumer.
+     */
+    void addConsumer();
+    void removeConsumer();
+    bool hasConsumers() const;
+
+    /**
+     * Copies a frame into the next free slot. The slot buffers keep their capacity,
+     * nothing is allocated once every slot has been written.
+     * @param image the color image, its stamp is used as hardware timestamp
+     * @param cam_info the camera info of the color camera
+     * @return false if all slots are being read
+     */
+    bool post(const sensor_msgs::msg::Image& image, const sensor_msgs::msg::CameraInfo& cam_info);
+
+    /**
+     * Calls visitor(const ColorFrame&) with the frame closest to the given timestamp,
+     * while its slot is locked.
+     * @param stamp_ns hardware timestamp in ns
+     * @param max_offset_ns maximum time offset between the timestamp and the frame
+     * @return false if no frame is within the maximum time offset
+     */
+    template <typename VisitorT>
+    bool visitClosest(const int64_t& stamp_ns, const int64_t& max_offset_ns, VisitorT visitor);
+
+private:
+    struct Slot
+    {
+        std::mutex mutex;
+        // copy of frame.stamp_ns, readable without locking the slot
+        std::atomic<int64_t> stamp_ns{0};
+        ColorFrame frame;
+    };
+
+    /**
+     * The ring of slots, not resized after construction
+     */
+    std::vector<Slot> slots_;
+
+    /**
+     * Index of the next slot to write
+     */
+    std::atomic<size_t> next_;
+
+    /**
+     * Number of registered consumers
+     */
+    std::atomic<int> consumers_;
+};
+
+template <typename VisitorT>
+bool ColorFrameChannel::visitClosest(const int64_t& stamp_ns, const int64_t& max_offset_ns, VisitorT visitor)
+{
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        size_t closest = slots_.size();
+        int64_t closest_offset = max_offset_ns;
+        for (size_t i = 0; i < slots_.size(); ++i)
+        {
+            const int64_t slot_stamp = slots_[i].stamp_ns.load();
+            const int64_t offset = slot_stamp > stamp_ns ? slot_stamp - stamp_ns : stamp_ns - slot_stamp;
+            if (slot_stamp != 0 && offset <= closest_offset)
+            {
+                closest = i;
+                closest_offset = offset;
+            }
+        }
+
+        if (closest == slots_.size())
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(slots_[closest].mutex);
+        const ColorFrame& frame = slots_[closest].frame;
+        // the slot may have been overwritten in between
+        const int64_t offset = frame.stamp_ns > stamp_ns ? frame.stamp_ns - stamp_ns : stamp_ns - frame.stamp_ns;
+        if (frame.stamp_ns != 0 && offset <= max_offset_ns)
+        {
+            visitor(frame);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Registration of the blaze point cloud with a color camera running in the same process.
+ * The blaze points are projected into the color image with the calibrated extrinsics and
+ * the intrinsics of the color camera, and the rgb field of the cloud is gathered from the
+ * color frame closest in time (hardware timestamps). There is no occlusion test.
+ */
+class RGBDRegistration
+{
+
+public:
+    RGBDRegistration();
+
+    virtual ~RGBDRegistration();
+
+    /**
+     * Enables the registration
+     * @param channel_name the channel the color camera posts its frames to
+     * @param transform the transform from the blaze camera frame to the color camera frame
+     *        (pose of the blaze in the color camera frame) [x, y, z, qx, qy, qz, qw], translation in m
+     * @param max_time_offset_ms maximum time offset between a blaze frame and its color frame
+     */
+    void enable(const std::string& channel_name, const std::vector<double>& transform, const double& max_time_offset_ms);
+
+    /**
+     * Disables the registration
+     */
+    void disable();
+
+    /**
+     * Returns true if the registration is enabled
+     */
+    bool isEnabled() const;
+
+    /**
+     * Colors the points with the color frame closest in time. Points outside the
+     * color image keep their color.
+     * @param xyz the points, x, y and z interleaved in mm in the blaze camera frame, NaN if invalid
+     * @param size the number of points
+     * @param stamp_ns the hardware timestamp of the blaze frame in ns
+     * @param prgba the rgba field (b, g, r, a bytes as in pcl) of the first point of the cloud
+     * @param point_step the distance between two points of the cloud in bytes
+     * @return false if no color frame could be used
+     */
+    bool colorize(const float* xyz, const size_t& size, const int64_t& stamp_ns, uint8_t* prgba, const size_t& point_step);
+
+private:
+    /**
+     * Projects the points into a color frame and gathers their colors
+     * @return false if the encoding or the intrinsics of the frame are not usable
+     */
+    bool gather(const ColorFrame& frame, const float* xyz, const size_t& size, uint8_t* prgba, const size_t& point_step);
+
+    std::shared_ptr<ColorFrameChannel> channel_;
+
+    // rotation (including the mm to m scale) and translation from the blaze to the color camera frame
+    float rotation_[9];
+    float translation_[3];
+
+    int64_t max_time_offset_ns_;
+
+    // byte offset of the color cell of each point, -1 if the point is not visible
+    std::vector<int64_t> pixel_offsets_;
+
+    // throttles the warnings about missing color frames
+    rclcpp::Clock clock_;
+};
+
+}  // namespace pylon_ros2_camera
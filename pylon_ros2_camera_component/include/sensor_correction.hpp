@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Sensor correction of the mono and bayer frames: dark-frame subtraction, flat-field gain and
+ * defective pixel replacement, applied while the frame is copied out of the pylon buffer.
+ *
+ * The calibration maps are loaded per device and sensor geometry, from
+ * <directory>/<serial number>/<width>x<height>+<offset x>+<offset y>_<binning x>x<binning y>/:
+ *  - dark.png: 8 or 16 bit dark frame, in the pixel values of the camera (e.g., 0 - 4095 for Mono12)
+ *  - flat.tiff: 32 bit float gains, applied after the dark-frame subtraction
+ *  - defects.png: 8 bit mask of the defective pixels (non zero), replaced by the mean of their
+ *    horizontal neighbours of the same color
+ * Each map is optional. Without any map for the current geometry, the frames are copied uncorrected.
+ */
+class SensorCorrection
+{
+
+public:
+    SensorCorrection();
+
+    /**
+     * @param directory root directory of the calibration maps, empty to disable the correction
+     */
+    void setDirectory(const std::string& directory);
+
+    bool isEnabled() const;
+
+    /**
+     * Loads the maps of a sensor geometry, if not loaded yet
+     * @return true if there is at least one map for this geometry
+     */
+    bool select(const std::string& serial_number, const size_t& width, const size_t& height,
+                const size_t& offset_x, const size_t& offset_y, const size_t& binning_x, const size_t& binning_y);
+
+    /**
+     * @return true if maps are loaded for the selected geometry
+     */
+    bool isActive() const;
+
+    /**
+     * @return the number of pixels of the selected geometry
+     */
+    size_t pixels() const;
+
+    /**
+     * Copies and corrects a frame of 8 bit pixels
+     * @param is_bayer true if the defective pixels are to be replaced by neighbours of the same bayer color
+     */
+    void apply(const uint8_t* src, uint8_t* dst, const bool& is_bayer) const;
+
+    /**
+     * Copies and corrects a frame of 16 bit pixels
+     * @param max_value maximum of the corrected pixel values, e.g., 4095 for a 12 bit format
+     * @param shift left shift of the corrected pixel values, e.g., 4 to publish a 12 bit format as 16 bit
+     */
+    void apply(const uint16_t* src, uint16_t* dst, const uint32_t& max_value, const int& shift, const bool& is_bayer) const;
+
+    /**
+     * Copies, corrects and tone maps a frame of 16 bit pixels to 8 bit
+     * @param max_value maximum of the corrected pixel values, e.g., 4095 for a 12 bit format
+     * @param lut table of max_value + 1 entries, mapping the corrected pixel values to 8 bit
+     */
+    void apply(const uint16_t* src, uint8_t* dst, const uint32_t& max_value, const uint8_t* lut, const bool& is_bayer) const;
+
+private:
+    void clear();
+
+    std::string directory_;
+    // geometry of the loaded maps
+    std::string geometry_;
+    size_t width_;
+    size_t height_;
+
+    // dark frame (pixel values), flat-field gains (fixed point, GAIN_ONE = 1.0), defective pixels (indices)
+    std::vector<uint8_t> dark8_;
+    std::vector<uint16_t> dark16_;
+    std::vector<uint16_t> gain_;
+    std::vector<uint32_t> defects_;
+};
+
+}  // namespace pylon_ros2_camera
@@ -0,0 +1,442 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Shared-memory frame ring, written by the camera node (shm/name parameter) and read by
+ * processes of the same host that are not ROS nodes. The ring is a POSIX shared-memory
+ * object with a header and a fixed number of frame slots, overwritten in turn. Each slot
+ * has a sequence counter (odd while the slot is written), so that the readers detect a
+ * frame overwritten while they read it. The writer never waits for the readers.
+ *
+ * This header is the whole client library: it only depends on the C++ standard library
+ * and on Linux, not on ROS or pylon.
+ */
+namespace shm_frame_ring
+{
+
+static const uint32_t MAGIC = 0x50595352;  // "PYSR"
+static const uint32_t VERSION = 1;
+
+// size of the ring header, the slots following it
+static const size_t HEADER_SIZE = 4096;
+static const size_t SLOT_ALIGNMENT = 64;
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "lock free atomics are required in shared memory");
+
+struct RingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t reserved;
+    // capacity of a slot in bytes, the slot header excluded
+    uint64_t slot_size;
+    // distance between two slots in bytes, the slot header included
+    uint64_t slot_stride;
+    // set when the writer stops or replaces the ring, the readers have to reopen it
+    std::atomic<uint32_t> is_closed;
+    // futex word, incremented with each frame
+    std::atomic<uint32_t> notification;
+    // number of readers waiting on the futex, the writer only wakes them if there are some
+    std::atomic<uint32_t> waiters;
+    uint32_t reserved2;
+    // number of frames written, frame i being in slot i % slot_count
+    std::atomic<uint64_t> frame_count;
+};
+
+struct alignas(SLOT_ALIGNMENT) SlotHeader
+{
+    // 0: empty, 2 * i + 1: frame i being written, 2 * i + 2: frame i complete
+    std::atomic<uint64_t> sequence;
+    // header stamp in ns
+    int64_t stamp_ns;
+    // camera frame counter, -1 if not available
+    int64_t frame_counter;
+    uint32_t width;
+    uint32_t height;
+    uint32_t step;
+    uint32_t data_size;
+    uint8_t is_bigendian;
+    // ROS image encoding, e.g., mono8 or bayer_rggb8
+    char encoding[31];
+    char frame_id[64];
+};
+
+static_assert(sizeof(RingHeader) <= HEADER_SIZE, "the ring header must fit into its page");
+
+inline size_t alignSize(const size_t& size, const size_t& alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+inline size_t slotStride(const size_t& slot_size)
+{
+    return alignSize(sizeof(SlotHeader) + slot_size, SLOT_ALIGNMENT);
+}
+
+inline size_t ringSize(const size_t& slot_count, const size_t& slot_size)
+{
+    return HEADER_SIZE + slot_count * slotStride(slot_size);
+}
+
+/**
+ * Wakes the processes waiting on a futex word of a shared mapping
+ */
+inline void futexWake(std::atomic<uint32_t>* word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+/**
+ * Waits on a futex word of a shared mapping as long as it has the given value
+ * @return false on timeout
+ */
+inline bool futexWait(std::atomic<uint32_t>* word, const uint32_t& value, const int& timeout_ms)
+{
+    timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    const long result = syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, value,
+                                (timeout_ms >= 0) ? &timeout : nullptr, nullptr, 0);
+    return result == 0 || errno != ETIMEDOUT;
+}
+
+/**
+ * A frame of the ring, mapped without copy. Its metadata is copied, its data is read in
+ * place and may be overwritten by the writer at any time: Reader::isValid() tells if the
+ * data read so far belongs to the frame.
+ */
+struct FrameView
+{
+    uint64_t index = 0;
+    int64_t stamp_ns = 0;
+    int64_t frame_counter = -1;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t step = 0;
+    uint32_t data_size = 0;
+    bool is_bigendian = false;
+    std::string encoding;
+    std::string frame_id;
+    const uint8_t* data = nullptr;
+
+    // slot and sequence of the frame when it was mapped
+    const SlotHeader* slot = nullptr;
+    uint64_t sequence = 0;
+};
+
+/**
+ * Reader of the ring. A reader only reads the slots and never holds up the writer:
+ * a reader which is too slow loses frames (lostFrames()), and a frame read in place
+ * can be overwritten while it is read (isValid()).
+ */
+class Reader
+{
+
+public:
+    Reader() :
+        header_(nullptr),
+        ring_(nullptr),
+        ring_size_(0),
+        last_index_(0),
+        has_read_(false),
+        lost_frames_(0)
+    {
+    }
+
+    ~Reader()
+    {
+        this->close();
+    }
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    /**
+     * Maps the ring
+     * @param name name of the shared-memory object, as given by the shm/name parameter, e.g., "/my_camera"
+     * @return false if there is no ring of this name (yet)
+     */
+    bool open(const std::string& name)
+    {
+        this->close();
+
+        const int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < HEADER_SIZE)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        // the header is mapped writable for the futex waiters, the whole ring read only
+        void* header = mmap(nullptr, HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (header == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+        header_ = static_cast<RingHeader*>(header);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header_->magic != MAGIC || header_->version != VERSION || header_->slot_count == 0 ||
+            header_->slot_stride != slotStride(header_->slot_size) ||
+            static_cast<size_t>(file_stat.st_size) < ringSize(header_->slot_count, header_->slot_size))
+        {
+            ::close(fd);
+            this->close();
+            return false;
+        }
+
+        ring_size_ = ringSize(header_->slot_count, header_->slot_size);
+        void* ring = mmap(nullptr, ring_size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (ring == MAP_FAILED)
+        {
+            this->close();
+            return false;
+        }
+        ring_ = static_cast<const uint8_t*>(ring);
+
+        has_read_ = false;
+        lost_frames_ = 0;
+        return true;
+    }
+
+    void close()
+    {
+        if (ring_ != nullptr)
+        {
+            munmap(const_cast<uint8_t*>(ring_), ring_size_);
+            ring_ = nullptr;
+        }
+        if (header_ != nullptr)
+        {
+            munmap(header_, HEADER_SIZE);
+            header_ = nullptr;
+        }
+    }
+
+    bool isOpen() const
+    {
+        return header_ != nullptr;
+    }
+
+    /**
+     * @return true if the writer stopped or replaced the ring (e.g., after a ROI change), it has to be reopened
+     */
+    bool isClosed() const
+    {
+        return header_ == nullptr || header_->is_closed.load(std::memory_order_acquire) != 0;
+    }
+
+    /**
+     * Waits for a frame newer than the last one read
+     * @param timeout_ms timeout in ms, -1 to wait without timeout
+     * @return false on timeout or if the ring is closed
+     */
+    bool waitForFrame(const int& timeout_ms)
+    {
+        while (!this->isClosed())
+        {
+            const uint32_t notification = header_->notification.load(std::memory_order_seq_cst);
+            if (this->hasNewFrame())
+            {
+                return true;
+            }
+
+            header_->waiters.fetch_add(1, std::memory_order_seq_cst);
+            const bool is_woken = futexWait(&header_->notification, notification, timeout_ms);
+            header_->waiters.fetch_sub(1, std::memory_order_seq_cst);
+            if (!is_woken)
+            {
+                return this->hasNewFrame();
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @return true if a frame newer than the last one read is available
+     */
+    bool hasNewFrame() const
+    {
+        if (header_ == nullptr)
+        {
+            return false;
+        }
+        const uint64_t frame_count = header_->frame_count.load(std::memory_order_acquire);
+        return frame_count > 0 && (!has_read_ || frame_count - 1 > last_index_);
+    }
+
+    /**
+     * Maps the latest frame, without copy
+     * @return false if there is no complete frame
+     */
+    bool latest(FrameView& view)
+    {
+        if (header_ == nullptr)
+        {
+            return false;
+        }
+
+        // the latest frame may be overwritten right away if the writer laps the reader, it is then retried
+        for (int attempt = 0; attempt < 3; ++attempt)
+        {
+            const uint64_t frame_count = header_->frame_count.load(std::memory_order_acquire);
+            if (frame_count == 0)
+            {
+                return false;
+            }
+
+            const uint64_t index = frame_count - 1;
+            const SlotHeader* slot = this->slot(index);
+            const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * index + 2)
+            {
+                continue;
+            }
+
+            view.index = index;
+            view.stamp_ns = slot->stamp_ns;
+            view.frame_counter = slot->frame_counter;
+            view.width = slot->width;
+            view.height = slot->height;
+            view.step = slot->step;
+            view.data_size = std::min<uint64_t>(slot->data_size, header_->slot_size);
+            view.is_bigendian = slot->is_bigendian != 0;
+            view.encoding.assign(slot->encoding, strnlen(slot->encoding, sizeof(slot->encoding)));
+            view.frame_id.assign(slot->frame_id, strnlen(slot->frame_id, sizeof(slot->frame_id)));
+            view.data = reinterpret_cast<const uint8_t*>(slot + 1);
+            view.slot = slot;
+            view.sequence = sequence;
+
+            if (!this->isValid(view))
+            {
+                continue;
+            }
+
+            if (has_read_ && index > last_index_ + 1)
+            {
+                lost_frames_ += index - last_index_ - 1;
+            }
+            last_index_ = index;
+            has_read_ = true;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @return true if the frame has not been overwritten so far, to be called after reading its data
+     */
+    bool isValid(const FrameView& view) const
+    {
+        if (view.slot == nullptr)
+        {
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return view.slot->sequence.load(std::memory_order_relaxed) == view.sequence;
+    }
+
+    /**
+     * Copies the latest frame
+     * @return false if there is no complete frame or if it was overwritten while copied
+     */
+    bool copyLatest(FrameView& view, std::vector<uint8_t>& data)
+    {
+        if (!this->latest(view))
+        {
+            return false;
+        }
+        data.resize(view.data_size);
+        std::memcpy(data.data(), view.data, view.data_size);
+        if (!this->isValid(view))
+        {
+            return false;
+        }
+        view.data = data.data();
+        view.slot = nullptr;
+        return true;
+    }
+
+    /**
+     * @return the number of frames the reader skipped because it was too slow
+     */
+    uint64_t lostFrames() const
+    {
+        return lost_frames_;
+    }
+
+private:
+    const SlotHeader* slot(const uint64_t& index) const
+    {
+        return reinterpret_cast<const SlotHeader*>(ring_ + HEADER_SIZE + (index % header_->slot_count) * header_->slot_stride);
+    }
+
+    RingHeader* header_;
+    const uint8_t* ring_;
+    size_t ring_size_;
+    uint64_t last_index_;
+    bool has_read_;
+    uint64_t lost_frames_;
+};
+
+}  // namespace shm_frame_ring
+
+}  // namespace pylon_ros2_camera
@@ -0,0 +1,90 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <sensor_msgs/msg/image.hpp>
+
+#include "shm_frame_ring.hpp"
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Writer of the shared-memory frame ring (see shm_frame_ring.hpp for the layout and the reader).
+ * The ring is created with the first frame, its slots fitting the frame size, and replaced
+ * if a larger frame comes. Writing a frame is one copy into the next slot, the writer never
+ * waits for the readers.
+ */
+class ShmFrameWriter
+{
+
+public:
+    ShmFrameWriter();
+
+    virtual ~ShmFrameWriter();
+
+    /**
+     * @param name name of the shared-memory object, e.g., "/my_camera"
+     * @param slots number of frame slots
+     */
+    bool start(const std::string& name, const int& slots);
+
+    /**
+     * Closes the ring and removes the shared-memory object, the readers mapping it are notified
+     */
+    void stop();
+
+    bool isStarted() const;
+
+    /**
+     * Writes a frame into the next slot and wakes the waiting readers
+     * @param frame_counter camera frame counter, -1 if not available
+     */
+    bool write(const sensor_msgs::msg::Image& image, const int64_t& frame_counter);
+
+private:
+    bool create(const size_t& slot_size);
+
+    void close();
+
+    std::string name_;
+    int slot_count_;
+
+    shm_frame_ring::RingHeader* header_;
+    uint8_t* ring_;
+    size_t ring_size_;
+    uint64_t frame_count_;
+};
+
+}  // namespace pylon_ros2_camera
@@ -0,0 +1,99 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Tone mapping of the 12 bit mono and bayer frames to 8 bit, through a table of 4096 entries
+ * applied while the frame is copied out of the pylon buffer. Compared to the 16 bit formats,
+ * the bandwidth is halved, and compared to the 8 bit formats of the camera, the shadows and
+ * the highlights are kept.
+ *
+ * The curves:
+ *  - gamma: 255 * (x / 4095)^gamma
+ *  - log: 255 * log(1 + x) / log(4096), the same number of values for each stop
+ *  - file: 4096 values (0 - 255) read from a text file, separated by spaces, commas or new lines
+ *
+ * The curve may also be loaded into the LUT of the camera, which applies it on the 12 bit values:
+ * the 12 bit frames are then only reduced to 8 bit, and the 8 bit formats of the camera are tone mapped.
+ */
+class ToneMapping
+{
+
+public:
+    static const size_t TABLE_SIZE = 4096;
+
+    ToneMapping();
+
+    /**
+     * Builds the table of a curve
+     * @param curve gamma, log or file, empty to disable the tone mapping
+     * @param gamma exponent of the gamma curve
+     * @param lut_file file of the user-supplied curve
+     * @return false if the curve is unknown or the file can't be read, the tone mapping is disabled then
+     */
+    bool configure(const std::string& curve, const double& gamma, const std::string& lut_file);
+
+    bool isEnabled() const;
+
+    /**
+     * @return the curve as 12 bit values, to be loaded into the LUT of the camera
+     */
+    std::vector<uint16_t> cameraTable() const;
+
+    /**
+     * @param on_camera true if the camera applies the curve, the 12 bit frames are then only reduced to 8 bit
+     */
+    void setAppliedOnCamera(const bool& on_camera);
+
+    /**
+     * @return the table of TABLE_SIZE entries mapping the 12 bit pixel values to 8 bit
+     */
+    const uint8_t* table() const;
+
+    /**
+     * Copies and tone maps a frame of 12 bit pixels (in 16 bit) to 8 bit
+     */
+    void apply(const uint16_t* src, uint8_t* dst, const size_t& pixels) const;
+
+private:
+    // the curve (0 - 1) for each 12 bit pixel value
+    std::vector<double> curve_;
+    std::vector<uint8_t> table_;
+};
+
+}  // namespace pylon_ros2_camera
@@ -0,0 +1,88 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sensor_msgs/msg/image.hpp>
+
+#include "pylon_ros2_camera_interfaces/msg/video_packet.hpp"
+
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Decoder of the encoded video output (VideoPacket messages). It is built as a small
+ * library of its own, so that consumers can decode the stream without depending on pylon.
+ */
+class VideoDecoder
+{
+
+public:
+    using VideoPacket = pylon_ros2_camera_interfaces::msg::VideoPacket;
+
+    VideoDecoder();
+
+    virtual ~VideoDecoder();
+
+    /**
+     * Decodes a packet. After the start or a change of the codec or size of the stream,
+     * the packets are skipped until the next key frame.
+     * @param image the decoded frame, the buffer keeps its capacity from frame to frame
+     * @param encoding encoding of the decoded frame: bgr8, rgb8 or mono8
+     * @return true if a frame is decoded
+     */
+    bool decode(const VideoPacket& packet, sensor_msgs::msg::Image& image, const std::string& encoding = "bgr8");
+
+private:
+    bool open(const VideoPacket& packet);
+
+    void close();
+
+    AVCodecContext* context_;
+    AVFrame* frame_;
+    AVPacket* packet_;
+    SwsContext* scaler_;
+    std::string codec_;
+    uint32_t width_;
+    uint32_t height_;
+
+    // the packet data, followed by the padding libavcodec reads over
+    std::vector<uint8_t> buffer_;
+};
+
+}  // namespace pylon_ros2_camera
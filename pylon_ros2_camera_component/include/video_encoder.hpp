@@ -0,0 +1,151 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <std_msgs/msg/header.hpp>
+#include <rclcpp/clock.hpp>
+#include <sensor_msgs/msg/image.hpp>
+
+#include "pylon_ros2_camera_interfaces/msg/video_packet.hpp"
+
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Encoded video output (H.264 or H.265) for a low bandwidth monitoring. The frames are
+ * downscaled, converted to YUV 4:2:0 and encoded with the libavcodec software encoders
+ * (libx264, libx265) on a thread of their own, only the latest frame waiting for it.
+ */
+class VideoEncoder
+{
+
+public:
+    using VideoPacket = pylon_ros2_camera_interfaces::msg::VideoPacket;
+    using PublishFunction = std::function<void(const VideoPacket&)>;
+
+    VideoEncoder();
+
+    virtual ~VideoEncoder();
+
+    /**
+     * Starts the encoder thread, the encoder itself is opened with the first frame
+     * @param codec "h264" or "h265"
+     * @param bitrate target bitrate in kbit/s
+     * @param gop distance between two key frames in frames
+     * @param preset encoder preset, e.g., "ultrafast"
+     * @param scale downscale factor of the frames, in ]0, 1]
+     * @param frame_rate expected frame rate, used by the rate control
+     * @param thread_setup called first in the encoder thread, e.g., to set its scheduling
+     * @param publish called with each packet, from the encoder thread
+     * @return false if the codec is unknown
+     */
+    bool start(const std::string& codec, const int& bitrate, const int& gop, const std::string& preset,
+               const double& scale, const double& frame_rate,
+               const std::function<void()>& thread_setup, const PublishFunction& publish);
+
+    /**
+     * Stops the encoder thread, the waiting frame is dropped
+     */
+    void stop();
+
+    bool isStarted() const;
+
+    /**
+     * Copies a frame for the encoder thread, without waiting for the encoding.
+     * A frame still waiting for the encoder is replaced, so that the acquisition is never blocked.
+     * @return false if a waiting frame is dropped
+     */
+    bool post(const sensor_msgs::msg::Image& image);
+
+private:
+    void work();
+
+    /**
+     * (Re)opens the encoder and the scaler for the size and encoding of the frame
+     */
+    bool open(const sensor_msgs::msg::Image& image);
+
+    void close();
+
+    /**
+     * Encodes a frame and publishes the packets the encoder returns
+     */
+    bool encode(const sensor_msgs::msg::Image& image);
+
+    std::string codec_;
+    int bitrate_;
+    int gop_;
+    std::string preset_;
+    double scale_;
+    double frame_rate_;
+    std::function<void()> thread_setup_;
+    PublishFunction publish_;
+
+    // frame waiting for the encoder, protected by mutex_
+    sensor_msgs::msg::Image pending_image_;
+    bool has_pending_image_;
+    bool is_stopping_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+
+    std::thread thread_;
+
+    // encoder state, only used by the encoder thread
+    sensor_msgs::msg::Image image_;
+    AVCodecContext* context_;
+    AVFrame* frame_;
+    AVPacket* packet_;
+    SwsContext* scaler_;
+    std::string input_encoding_;
+    uint32_t input_width_;
+    uint32_t input_height_;
+    int64_t pts_;
+    // stamps and frames of the frames being encoded, by pts
+    std::deque<std::pair<int64_t, std_msgs::msg::Header>> headers_;
+    VideoPacket msg_;
+
+    rclcpp::Clock clock_;
+};
+
+}  // namespace pylon_ros2_camera
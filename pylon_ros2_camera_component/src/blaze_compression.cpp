@@ -0,0 +1,322 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "blaze_compression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include <lz4.h>
+#include <zstd.h>
+
+#include <sensor_msgs/point_cloud2_iterator.hpp>
+
+
+namespace pylon_ros2_camera
+{
+
+namespace blaze_compression
+{
+
+namespace
+{
+    // The residual of a value is its difference to its left neighbour, or to its upper neighbour
+    // in the first column. It is zigzag encoded (small negative residuals become small values)
+    // and split into byte planes, the high bytes being mostly 0: this is what the codec compresses.
+    // read(u, v) returns the value of the pixel (u, v) as UnsignedT.
+    template <typename UnsignedT, typename ReadT>
+    void encodePlanes(size_t width, size_t height, ReadT read, uint8_t* planes)
+    {
+        using SignedT = typename std::make_signed<UnsignedT>::type;
+        const size_t size = width * height;
+        const int bits = 8 * sizeof(UnsignedT);
+
+        UnsignedT row_first = 0;
+        for (size_t v = 0; v < height; ++v)
+        {
+            UnsignedT prediction = row_first;
+            for (size_t u = 0; u < width; ++u)
+            {
+                const size_t i = v * width + u;
+                const UnsignedT value = read(u, v);
+                const SignedT residual = static_cast<SignedT>(static_cast<UnsignedT>(value - prediction));
+                const UnsignedT zigzag = static_cast<UnsignedT>(static_cast<UnsignedT>(residual) << 1) ^ static_cast<UnsignedT>(residual >> (bits - 1));
+                for (size_t b = 0; b < sizeof(UnsignedT); ++b)
+                {
+                    planes[b * size + i] = static_cast<uint8_t>(zigzag >> (8 * b));
+                }
+                prediction = value;
+                if (u == 0)
+                {
+                    row_first = value;
+                }
+            }
+        }
+    }
+
+    // Inverse of encodePlanes, write(u, v, value) stores the value of the pixel (u, v)
+    template <typename UnsignedT, typename WriteT>
+    void decodePlanes(const uint8_t* planes, size_t width, size_t height, WriteT write)
+    {
+        const size_t size = width * height;
+
+        UnsignedT row_first = 0;
+        for (size_t v = 0; v < height; ++v)
+        {
+            UnsignedT prediction = row_first;
+            for (size_t u = 0; u < width; ++u)
+            {
+                const size_t i = v * width + u;
+                UnsignedT zigzag = 0;
+                for (size_t b = 0; b < sizeof(UnsignedT); ++b)
+                {
+                    zigzag |= static_cast<UnsignedT>(static_cast<UnsignedT>(planes[b * size + i]) << (8 * b));
+                }
+                const UnsignedT residual = static_cast<UnsignedT>((zigzag >> 1) ^ static_cast<UnsignedT>(-static_cast<UnsignedT>(zigzag & 1)));
+                const UnsignedT value = static_cast<UnsignedT>(prediction + residual);
+                write(u, v, value);
+                prediction = value;
+                if (u == 0)
+                {
+                    row_first = value;
+                }
+            }
+        }
+    }
+}
+
+void encodeCoordinate(const uint8_t* coordinates, size_t point_step, size_t width, size_t height,
+                      float quantization, uint8_t* planes)
+{
+    const float scale = 1000.0f / quantization;
+    encodePlanes<uint16_t>(width, height, [&](const size_t u, const size_t v) -> uint16_t
+    {
+        const float coordinate = *reinterpret_cast<const float*>(coordinates + (v * width + u) * point_step);
+        // the invalid value is not reachable
+        const float quantized = std::min(std::max(coordinate * scale, -32767.0f), 32767.0f);
+        const int16_t rounded = static_cast<int16_t>(std::lrint(quantized));
+        return static_cast<uint16_t>(std::isnan(coordinate) ? INVALID_COORDINATE : rounded);
+    }, planes);
+}
+
+void encodeCoordinate(const uint8_t* coordinates, size_t point_step, size_t width, size_t height, uint8_t* planes)
+{
+    // the bit patterns are predicted, which keeps the NaNs and is lossless
+    encodePlanes<uint32_t>(width, height, [&](const size_t u, const size_t v) -> uint32_t
+    {
+        return *reinterpret_cast<const uint32_t*>(coordinates + (v * width + u) * point_step);
+    }, planes);
+}
+
+void encodeValues(const uint8_t* values, size_t step, size_t width, size_t height, uint8_t* planes)
+{
+    encodePlanes<uint16_t>(width, height, [&](const size_t u, const size_t v) -> uint16_t
+    {
+        return reinterpret_cast<const uint16_t*>(values + v * step)[u];
+    }, planes);
+}
+
+void decodeCoordinate(const uint8_t* planes, size_t width, size_t height, float quantization,
+                      uint8_t* coordinates, size_t point_step)
+{
+    if (quantization > 0.0f)
+    {
+        const float scale = quantization * 0.001f;
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        decodePlanes<uint16_t>(planes, width, height, [&](const size_t u, const size_t v, const uint16_t value)
+        {
+            const int16_t quantized = static_cast<int16_t>(value);
+            *reinterpret_cast<float*>(coordinates + (v * width + u) * point_step) = quantized == INVALID_COORDINATE ? nan : quantized * scale;
+        });
+    }
+    else
+    {
+        decodePlanes<uint32_t>(planes, width, height, [&](const size_t u, const size_t v, const uint32_t value)
+        {
+            *reinterpret_cast<uint32_t*>(coordinates + (v * width + u) * point_step) = value;
+        });
+    }
+}
+
+void decodeValues(const uint8_t* planes, size_t width, size_t height, uint8_t* values, size_t step, size_t pixel_step)
+{
+    decodePlanes<uint16_t>(planes, width, height, [&](const size_t u, const size_t v, const uint16_t value)
+    {
+        *reinterpret_cast<uint16_t*>(values + v * step + u * pixel_step) = value;
+    });
+}
+
+size_t planesSize(const CompressedBlazeData& msg, const bool& is_coordinate)
+{
+    const size_t bytes = (is_coordinate && msg.quantization <= 0.0f) ? sizeof(float) : sizeof(uint16_t);
+    return static_cast<size_t>(msg.width) * msg.height * bytes;
+}
+
+Codec::Codec() :
+    zstd_cctx_(nullptr),
+    zstd_dctx_(nullptr)
+{
+}
+
+Codec::~Codec()
+{
+    ZSTD_freeCCtx(zstd_cctx_);
+    ZSTD_freeDCtx(zstd_dctx_);
+}
+
+bool Codec::compress(const uint8_t& codec, const int& level, const uint8_t* src, const size_t& size, std::vector<uint8_t>& dst)
+{
+    if (codec == CompressedBlazeData::CODEC_ZSTD)
+    {
+        if (zstd_cctx_ == nullptr)
+        {
+            zstd_cctx_ = ZSTD_createCCtx();
+        }
+        dst.resize(ZSTD_compressBound(size));
+        const size_t compressed_size = ZSTD_compressCCtx(zstd_cctx_, dst.data(), dst.size(), src, size, level);
+        if (ZSTD_isError(compressed_size))
+        {
+            dst.clear();
+            return false;
+        }
+        dst.resize(compressed_size);
+        return true;
+    }
+    else if (codec == CompressedBlazeData::CODEC_LZ4)
+    {
+        dst.resize(LZ4_compressBound(static_cast<int>(size)));
+        const int compressed_size = LZ4_compress_fast(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst.data()),
+                                                      static_cast<int>(size), static_cast<int>(dst.size()), std::max(level, 1));
+        if (compressed_size <= 0)
+        {
+            dst.clear();
+            return false;
+        }
+        dst.resize(compressed_size);
+        return true;
+    }
+
+    return false;
+}
+
+bool Codec::decompress(const uint8_t& codec, const std::vector<uint8_t>& src, uint8_t* dst, const size_t& size)
+{
+    if (codec == CompressedBlazeData::CODEC_ZSTD)
+    {
+        if (zstd_dctx_ == nullptr)
+        {
+            zstd_dctx_ = ZSTD_createDCtx();
+        }
+        const size_t decompressed_size = ZSTD_decompressDCtx(zstd_dctx_, dst, size, src.data(), src.size());
+        return !ZSTD_isError(decompressed_size) && decompressed_size == size;
+    }
+    else if (codec == CompressedBlazeData::CODEC_LZ4)
+    {
+        const int decompressed_size = LZ4_decompress_safe(reinterpret_cast<const char*>(src.data()), reinterpret_cast<char*>(dst),
+                                                          static_cast<int>(src.size()), static_cast<int>(size));
+        return decompressed_size >= 0 && static_cast<size_t>(decompressed_size) == size;
+    }
+
+    return false;
+}
+
+bool Decoder::decompressChannel(const CompressedBlazeData& msg, const std::vector<uint8_t>& channel, const bool& is_coordinate)
+{
+    const size_t size = planesSize(msg, is_coordinate);
+    planes_.resize(size);
+    return size > 0 && codec_.decompress(msg.codec, channel, planes_.data(), size);
+}
+
+bool Decoder::decodePoints(const CompressedBlazeData& msg, uint8_t* points, const size_t& point_step)
+{
+    const std::vector<uint8_t>* channels[3] = {&msg.x, &msg.y, &msg.z};
+    for (size_t c = 0; c < 3; ++c)
+    {
+        if (!this->decompressChannel(msg, *channels[c], true))
+        {
+            return false;
+        }
+        decodeCoordinate(planes_.data(), msg.width, msg.height, msg.quantization, points + c * sizeof(float), point_step);
+    }
+
+    return true;
+}
+
+bool Decoder::decodeIntensity(const CompressedBlazeData& msg, uint8_t* intensity, const size_t& step, const size_t& pixel_step)
+{
+    if (!this->decompressChannel(msg, msg.intensity, false))
+    {
+        return false;
+    }
+    decodeValues(planes_.data(), msg.width, msg.height, intensity, step, pixel_step);
+
+    return true;
+}
+
+bool Decoder::decodeConfidence(const CompressedBlazeData& msg, uint8_t* confidence, const size_t& step, const size_t& pixel_step)
+{
+    if (!this->decompressChannel(msg, msg.confidence, false))
+    {
+        return false;
+    }
+    decodeValues(planes_.data(), msg.width, msg.height, confidence, step, pixel_step);
+
+    return true;
+}
+
+bool Decoder::decode(const CompressedBlazeData& msg, sensor_msgs::msg::PointCloud2& cloud)
+{
+    // the fields are only set up when the cloud size changes
+    if (cloud.width != msg.width || cloud.height != msg.height || cloud.fields.size() != 5)
+    {
+        sensor_msgs::PointCloud2Modifier modifier(cloud);
+        modifier.setPointCloud2Fields(5,
+                                      "x", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                      "y", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                      "z", 1, sensor_msgs::msg::PointField::FLOAT32,
+                                      "intensity", 1, sensor_msgs::msg::PointField::UINT16,
+                                      "confidence", 1, sensor_msgs::msg::PointField::UINT16);
+        modifier.resize(static_cast<size_t>(msg.width) * msg.height);
+        cloud.width = msg.width;
+        cloud.height = msg.height;
+        cloud.row_step = cloud.point_step * msg.width;
+        cloud.is_dense = false;
+    }
+    cloud.header = msg.header;
+
+    uint8_t* data = cloud.data.data();
+    return this->decodePoints(msg, data + cloud.fields[0].offset, cloud.point_step) &&
+           this->decodeIntensity(msg, data + cloud.fields[3].offset, cloud.row_step, cloud.point_step) &&
+           this->decodeConfidence(msg, data + cloud.fields[4].offset, cloud.row_step, cloud.point_step);
+}
+
+}  // namespace blaze_compression
+
+}  // namespace pylon_ros2_camera
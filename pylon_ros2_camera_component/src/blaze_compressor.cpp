@@ -0,0 +1,226 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "blaze_compressor.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <rclcpp/logging.hpp>
+#include <sensor_msgs/image_encodings.hpp>
+
+
+namespace pylon_ros2_camera
+{
+
+namespace
+{
+    static const rclcpp::Logger LOGGER_COMPRESSION = rclcpp::get_logger("basler.pylon.ros2.blaze_compression");
+}
+
+const int BlazeCompressor::NR_CHANNELS;
+
+BlazeCompressor::BlazeCompressor() :
+    codec_(blaze_compression::CompressedBlazeData::CODEC_LZ4),
+    level_(1),
+    quantization_(1.0f),
+    publish_(),
+    pool_(),
+    clock_(RCL_STEADY_TIME)
+{
+}
+
+BlazeCompressor::~BlazeCompressor()
+{
+    this->stop();
+}
+
+bool BlazeCompressor::start(const std::string& codec, const int& level, const float& quantization, const int& threads,
+                            const std::function<void()>& thread_setup, const PublishFunction& publish)
+{
+    this->stop();
+
+    if (codec == "lz4")
+    {
+        codec_ = blaze_compression::CompressedBlazeData::CODEC_LZ4;
+    }
+    else if (codec == "zstd")
+    {
+        codec_ = blaze_compression::CompressedBlazeData::CODEC_ZSTD;
+    }
+    else
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_COMPRESSION, "Unknown blaze compression codec: " << codec << " (lz4 or zstd expected)");
+        return false;
+    }
+
+    level_ = level;
+    quantization_ = std::max(quantization, 0.0f);
+    publish_ = publish;
+
+    const int nr_threads = pool_.start(threads, NR_CHANNELS, thread_setup,
+                                       [this](Frame& frame, const int& channel, blaze_compression::Codec& codec)
+                                       {
+                                           return this->compress(frame, channel, codec);
+                                       },
+                                       [this](Frame& frame, const bool& is_failed)
+                                       {
+                                           if (is_failed)
+                                           {
+                                               RCLCPP_WARN_STREAM_THROTTLE(LOGGER_COMPRESSION, clock_, 5000, "The compression of a blaze data set failed");
+                                           }
+                                           else
+                                           {
+                                               publish_(frame.msg);
+                                           }
+                                       });
+
+    RCLCPP_INFO_STREAM(LOGGER_COMPRESSION, "Blaze data compressed with " << codec << " (level " << level_ << ") on " << nr_threads
+                       << " thread(s), " << (quantization_ > 0.0f ? "coordinates quantized to " + std::to_string(quantization_) + " mm"
+                                                                  : std::string("lossless coordinates")));
+    return true;
+}
+
+void BlazeCompressor::stop()
+{
+    pool_.stop();
+}
+
+bool BlazeCompressor::isStarted() const
+{
+    return pool_.isStarted();
+}
+
+bool BlazeCompressor::post(const sensor_msgs::msg::PointCloud2& cloud,
+                           const sensor_msgs::msg::Image& intensity_map,
+                           const sensor_msgs::msg::Image& confidence_map)
+{
+    if (!this->isStarted())
+    {
+        return false;
+    }
+
+    const size_t width = cloud.width;
+    const size_t height = cloud.height;
+    if (width * height == 0 || cloud.fields.size() < 3 ||
+        cloud.fields[0].name != "x" || cloud.fields[1].name != "y" || cloud.fields[2].name != "z" ||
+        intensity_map.width != width || intensity_map.height != height || intensity_map.encoding != sensor_msgs::image_encodings::MONO16 ||
+        confidence_map.width != width || confidence_map.height != height || confidence_map.encoding != sensor_msgs::image_encodings::MONO16)
+    {
+        RCLCPP_WARN_STREAM_THROTTLE(LOGGER_COMPRESSION, clock_, 5000, "The blaze data set does not match the expected layout, it is not compressed");
+        return false;
+    }
+
+    OrderedWorkerPool<Frame, blaze_compression::Codec>::Slot* slot = pool_.acquire();
+    if (slot == nullptr)
+    {
+        RCLCPP_WARN_STREAM_THROTTLE(LOGGER_COMPRESSION, clock_, 5000, "The blaze data compression is too slow, frames are dropped");
+        return false;
+    }
+    Frame* frame = &slot->frame;
+
+    blaze_compression::CompressedBlazeData& msg = frame->msg;
+    msg.header = cloud.header;
+    msg.width = width;
+    msg.height = height;
+    msg.codec = codec_;
+    msg.quantization = quantization_;
+
+    // only a compact copy of the channels is made here, the quantization, the prediction
+    // and the compression are left to the workers
+    const size_t size = width * height;
+    float* coordinates[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        frame->channels[c].resize(size * sizeof(float));
+        coordinates[c] = reinterpret_cast<float*>(frame->channels[c].data());
+    }
+    const uint8_t* src = cloud.data.data();
+    const size_t offsets[3] = {cloud.fields[0].offset, cloud.fields[1].offset, cloud.fields[2].offset};
+    for (size_t i = 0; i < size; ++i, src += cloud.point_step)
+    {
+        coordinates[0][i] = *reinterpret_cast<const float*>(src + offsets[0]);
+        coordinates[1][i] = *reinterpret_cast<const float*>(src + offsets[1]);
+        coordinates[2][i] = *reinterpret_cast<const float*>(src + offsets[2]);
+    }
+
+    const sensor_msgs::msg::Image* maps[2] = {&intensity_map, &confidence_map};
+    for (int m = 0; m < 2; ++m)
+    {
+        std::vector<uint8_t>& values = frame->channels[3 + m];
+        values.resize(size * sizeof(uint16_t));
+        for (size_t v = 0; v < height; ++v)
+        {
+            std::memcpy(values.data() + v * width * sizeof(uint16_t), maps[m]->data.data() + v * maps[m]->step, width * sizeof(uint16_t));
+        }
+    }
+
+    pool_.submit(slot);
+    return true;
+}
+
+bool BlazeCompressor::compress(Frame& frame, const int& channel, blaze_compression::Codec& codec)
+{
+    const size_t width = frame.msg.width;
+    const size_t height = frame.msg.height;
+    const std::vector<uint8_t>& values = frame.channels[channel];
+    std::vector<uint8_t>& planes = frame.planes[channel];
+    if (channel < 3)
+    {
+        planes.resize(blaze_compression::planesSize(frame.msg, true));
+        if (quantization_ > 0.0f)
+        {
+            blaze_compression::encodeCoordinate(values.data(), sizeof(float), width, height, quantization_, planes.data());
+        }
+        else
+        {
+            blaze_compression::encodeCoordinate(values.data(), sizeof(float), width, height, planes.data());
+        }
+    }
+    else
+    {
+        planes.resize(blaze_compression::planesSize(frame.msg, false));
+        blaze_compression::encodeValues(values.data(), width * sizeof(uint16_t), width, height, planes.data());
+    }
+
+    return codec.compress(codec_, level_, planes.data(), planes.size(), this->compressedChannel(frame, channel));
+}
+
+std::vector<uint8_t>& BlazeCompressor::compressedChannel(Frame& frame, const int& index)
+{
+    switch (index)
+    {
+        case 0: return frame.msg.x;
+        case 1: return frame.msg.y;
+        case 2: return frame.msg.z;
+        case 3: return frame.msg.intensity;
+        default: return frame.msg.confidence;
+    }
+}
+
+}  // namespace pylon_ros2_camera
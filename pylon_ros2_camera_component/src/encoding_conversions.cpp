@@ -26,6 +26,7 @@
  * POSSIBILITY OF SUCH DAMAGE.
  *****************************************************************************/
 
+#include <opencv2/imgproc/imgproc.hpp>
 #include <sensor_msgs/image_encodings.hpp>
 
 #include "encoding_conversions.hpp"
@@ -263,5 +264,27 @@ bool is_12_bit_ros_enc(const std::string& ros_enc){
     }
 }
 
+int bayer2OpenCVCode(const std::string& ros_enc)
+{
+    // OpenCV names the bayer patterns after the second row
+    if ( ros_enc.find("rggb") != std::string::npos )
+    {
+        return cv::COLOR_BayerBG2BGR;
+    }
+    else if ( ros_enc.find("bggr") != std::string::npos )
+    {
+        return cv::COLOR_BayerRG2BGR;
+    }
+    else if ( ros_enc.find("gbrg") != std::string::npos )
+    {
+        return cv::COLOR_BayerGR2BGR;
+    }
+    else if ( ros_enc.find("grbg") != std::string::npos )
+    {
+        return cv::COLOR_BayerGB2BGR;
+    }
+    return -1;
+}
+
 }  // namespace encodingconversions
 }  // namespace pylon_ros2_camera
@@ -0,0 +1,229 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "frame_tracer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+
+namespace pylon_ros2_camera
+{
+
+namespace
+{
+    const char* STAGE_NAMES[TS_COUNT + 1] = {"trigger issued",
+                                             "result retrieved",
+                                             "conversion start",
+                                             "conversion end",
+                                             "rectification start",
+                                             "rectification end",
+                                             "published",
+                                             "total"};
+
+    // log2 buckets in us: bucket 0 holds the latencies below 1 us, bucket k the ones in [2^(k-1), 2^k)
+    const size_t HISTOGRAM_BUCKETS = 32;
+}
+
+FrameTracer::FrameTracer(const size_t& capacity)
+    : current_()
+    , is_in_progress_(false)
+    , owner_()
+    , ring_()
+    , next_(0)
+    , size_(0)
+    , mutex_()
+{
+    current_.frame_counter = -1;
+    current_.stamps.fill(0);
+    setCapacity(capacity);
+}
+
+FrameTracer::~FrameTracer()
+{}
+
+void FrameTracer::setCapacity(const size_t& capacity)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ring_.assign(capacity, current_);
+    next_ = 0;
+    size_ = 0;
+}
+
+bool FrameTracer::isEnabled() const
+{
+    return !ring_.empty();
+}
+
+void FrameTracer::begin()
+{
+    if (ring_.empty())
+    {
+        return;
+    }
+
+    owner_ = std::this_thread::get_id();
+    current_.stamps.fill(0);
+    is_in_progress_ = true;
+}
+
+void FrameTracer::mark(const TRACE_STAGE& stage)
+{
+    if (!is_in_progress_ || owner_ != std::this_thread::get_id())
+    {
+        return;
+    }
+
+    current_.stamps[stage] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FrameTracer::commit(const int64_t& frame_counter)
+{
+    if (!is_in_progress_ || owner_ != std::this_thread::get_id())
+    {
+        return;
+    }
+
+    current_.frame_counter = frame_counter;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ring_[next_] = current_;
+        next_ = (next_ + 1) % ring_.size();
+        size_ = std::min(size_ + 1, ring_.size());
+    }
+    is_in_progress_ = false;
+}
+
+std::string FrameTracer::dumpHistograms()
+{
+    std::vector<FrameTrace> frames;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frames.assign(ring_.begin(), ring_.begin() + size_);
+    }
+
+    if (frames.empty())
+    {
+        return "No frame traced";
+    }
+
+    // latencies in us, measured from the previous stage reached; the last entry holds the total latency
+    std::vector<std::vector<double>> latencies(TS_COUNT + 1);
+    int64_t min_counter = frames.front().frame_counter;
+    int64_t max_counter = frames.front().frame_counter;
+    for (const auto& frame : frames)
+    {
+        min_counter = std::min(min_counter, frame.frame_counter);
+        max_counter = std::max(max_counter, frame.frame_counter);
+
+        int64_t first = 0;
+        int64_t previous = 0;
+        for (size_t stage = 0; stage < TS_COUNT; ++stage)
+        {
+            const int64_t stamp = frame.stamps[stage];
+            if (stamp == 0)
+            {
+                continue;
+            }
+
+            if (previous == 0)
+            {
+                first = stamp;
+            }
+            else
+            {
+                latencies[stage].push_back((stamp - previous) / 1000.0);
+            }
+            previous = stamp;
+        }
+
+        if (previous != first)
+        {
+            latencies[TS_COUNT].push_back((previous - first) / 1000.0);
+        }
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << frames.size() << " frames traced (frame counter " << min_counter << " to " << max_counter << "), latencies in us";
+
+    for (size_t stage = 0; stage <= TS_COUNT; ++stage)
+    {
+        std::vector<double>& values = latencies[stage];
+        if (values.empty())
+        {
+            continue;
+        }
+
+        std::sort(values.begin(), values.end());
+        const double mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+
+        out << "\n" << (stage < TS_COUNT ? "-> " : "") << STAGE_NAMES[stage] << ": count " << values.size()
+            << ", min " << values.front()
+            << ", mean " << mean
+            << ", p50 " << values[values.size() / 2]
+            << ", p99 " << values[std::min(values.size() - 1, values.size() * 99 / 100)]
+            << ", max " << values.back();
+
+        std::array<size_t, HISTOGRAM_BUCKETS> buckets;
+        buckets.fill(0);
+        for (const double value : values)
+        {
+            const size_t bucket = value < 1.0 ? 0 : static_cast<size_t>(std::log2(value)) + 1;
+            buckets[std::min(bucket, HISTOGRAM_BUCKETS - 1)]++;
+        }
+
+        out << "\n   ";
+        for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket)
+        {
+            if (buckets[bucket] == 0)
+            {
+                continue;
+            }
+
+            if (bucket == 0)
+            {
+                out << " [0, 1): ";
+            }
+            else
+            {
+                out << " [" << (1ull << (bucket - 1)) << ", " << (1ull << bucket) << "): ";
+            }
+            out << buckets[bucket];
+        }
+    }
+
+    return out.str();
+}
+
+}  // namespace pylon_ros2_camera
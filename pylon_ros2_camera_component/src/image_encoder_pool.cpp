@@ -0,0 +1,241 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "image_encoder_pool.hpp"
+#include "encoding_conversions.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <rclcpp/logging.hpp>
+#include <sensor_msgs/image_encodings.hpp>
+#include <turbojpeg.h>
+
+
+namespace pylon_ros2_camera
+{
+
+namespace
+{
+    static const rclcpp::Logger LOGGER_ENCODER = rclcpp::get_logger("basler.pylon.ros2.image_encoder");
+}
+
+// compression contexts of a worker thread
+struct ImageEncoderPool::Worker
+{
+    Worker() : jpeg_compressor(tjInitCompress()), png_params() {}
+
+    ~Worker()
+    {
+        if (jpeg_compressor != nullptr)
+        {
+            tjDestroy(jpeg_compressor);
+        }
+    }
+
+    tjhandle jpeg_compressor;
+    std::vector<int> png_params;
+};
+
+ImageEncoderPool::ImageEncoderPool() :
+    is_jpeg_(true),
+    jpeg_quality_(90),
+    png_level_(1),
+    publish_(),
+    pool_(),
+    clock_(RCL_STEADY_TIME)
+{
+}
+
+ImageEncoderPool::~ImageEncoderPool()
+{
+    this->stop();
+}
+
+bool ImageEncoderPool::start(const std::string& format, const int& jpeg_quality, const int& png_level, const int& threads,
+                             const std::function<void()>& thread_setup, const PublishFunction& publish)
+{
+    this->stop();
+
+    if (format != "jpeg" && format != "png")
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_ENCODER, "Unknown compressed image format: " << format << " (jpeg or png expected)");
+        return false;
+    }
+
+    is_jpeg_ = (format == "jpeg");
+    jpeg_quality_ = std::min(std::max(jpeg_quality, 1), 100);
+    png_level_ = std::min(std::max(png_level, 0), 9);
+    publish_ = publish;
+
+    const int nr_threads = pool_.start(threads, 1, thread_setup,
+                                       [this](Frame& frame, const int&, Worker& worker)
+                                       {
+                                           return this->encode(frame, worker);
+                                       },
+                                       [this](Frame& frame, const bool& is_failed)
+                                       {
+                                           if (!is_failed)
+                                           {
+                                               publish_(frame.msg);
+                                           }
+                                       });
+
+    RCLCPP_INFO_STREAM(LOGGER_ENCODER, "Images compressed as " << format << " on " << nr_threads << " thread(s)");
+    return true;
+}
+
+void ImageEncoderPool::stop()
+{
+    pool_.stop();
+}
+
+bool ImageEncoderPool::isStarted() const
+{
+    return pool_.isStarted();
+}
+
+bool ImageEncoderPool::post(const sensor_msgs::msg::Image& image)
+{
+    if (!this->isStarted())
+    {
+        return false;
+    }
+
+    OrderedWorkerPool<Frame, Worker>::Slot* slot = pool_.acquire();
+    if (slot == nullptr)
+    {
+        RCLCPP_WARN_STREAM_THROTTLE(LOGGER_ENCODER, clock_, 5000, "The image compression is too slow, images are dropped");
+        return false;
+    }
+
+    // the copy keeps the capacity of the slot buffer
+    Frame* frame = &slot->frame;
+    frame->image.header = image.header;
+    frame->image.height = image.height;
+    frame->image.width = image.width;
+    frame->image.encoding = image.encoding;
+    frame->image.is_bigendian = image.is_bigendian;
+    frame->image.step = image.step;
+    frame->image.data.resize(image.data.size());
+    std::memcpy(frame->image.data.data(), image.data.data(), image.data.size());
+
+    pool_.submit(slot);
+    return true;
+}
+
+bool ImageEncoderPool::encode(Frame& frame, Worker& worker)
+{
+    namespace enc = sensor_msgs::image_encodings;
+
+    const sensor_msgs::msg::Image& image = frame.image;
+    std::string source_encoding = image.encoding;
+    int bit_depth = 0;
+    int channels = 0;
+    try
+    {
+        bit_depth = enc::bitDepth(source_encoding);
+        channels = enc::numChannels(source_encoding);
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+
+    if ((bit_depth != 8 && bit_depth != 16) || (channels != 1 && channels != 3))
+    {
+        RCLCPP_WARN_STREAM_THROTTLE(LOGGER_ENCODER, clock_, 5000, "Images of encoding " << source_encoding << " can't be compressed");
+        return false;
+    }
+
+    const int depth = (bit_depth == 16) ? CV_16U : CV_8U;
+    cv::Mat src(image.height, image.width, CV_MAKETYPE(depth, channels), const_cast<uint8_t*>(image.data.data()), image.step);
+    bool is_rgb = (source_encoding == enc::RGB8 || source_encoding == enc::RGB16);
+
+    // the bayer images are compressed as color images
+    const int bayer_code = encodingconversions::bayer2OpenCVCode(source_encoding);
+    if (bayer_code >= 0)
+    {
+        cv::cvtColor(src, frame.converted, bayer_code);
+        src = frame.converted;
+        source_encoding = (bit_depth == 16) ? enc::BGR16 : enc::BGR8;
+        channels = 3;
+    }
+
+    sensor_msgs::msg::CompressedImage& msg = frame.msg;
+    msg.header = image.header;
+
+    if (is_jpeg_)
+    {
+        if (bit_depth == 16)
+        {
+            src.convertTo(frame.converted, CV_MAKETYPE(CV_8U, channels), 1.0 / 256.0);
+            src = frame.converted;
+        }
+
+        // libjpeg-turbo reads the rgb and bgr layouts directly, the message buffer is written in place
+        const int pixel_format = (channels == 1) ? TJPF_GRAY : (is_rgb ? TJPF_RGB : TJPF_BGR);
+        const int subsampling = (channels == 1) ? TJSAMP_GRAY : TJSAMP_420;
+        msg.data.resize(tjBufSize(src.cols, src.rows, subsampling));
+        unsigned char* jpeg_buffer = msg.data.data();
+        unsigned long jpeg_size = msg.data.size();
+        if (worker.jpeg_compressor == nullptr ||
+            tjCompress2(worker.jpeg_compressor, src.data, src.cols, static_cast<int>(src.step), src.rows, pixel_format,
+                        &jpeg_buffer, &jpeg_size, subsampling, jpeg_quality_, TJFLAG_FASTDCT | TJFLAG_NOREALLOC) != 0)
+        {
+            return false;
+        }
+        msg.data.resize(jpeg_size);
+        msg.format = source_encoding + "; jpeg compressed " + ((channels == 1) ? enc::MONO8 : enc::BGR8);
+    }
+    else
+    {
+        if (is_rgb)
+        {
+            cv::cvtColor(src, frame.converted, cv::COLOR_RGB2BGR);
+            src = frame.converted;
+        }
+
+        if (worker.png_params.empty())
+        {
+            worker.png_params = {cv::IMWRITE_PNG_COMPRESSION, png_level_};
+        }
+        if (!cv::imencode(".png", src, msg.data, worker.png_params))
+        {
+            return false;
+        }
+        const std::string target_encoding = (channels == 1) ? ((bit_depth == 16) ? enc::MONO16 : enc::MONO8)
+                                                             : ((bit_depth == 16) ? enc::BGR16 : enc::BGR8);
+        msg.format = source_encoding + "; png compressed " + target_encoding;
+    }
+
+    return true;
+}
+
+}  // namespace pylon_ros2_camera
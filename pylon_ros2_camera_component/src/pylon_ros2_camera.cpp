@@ -28,6 +28,8 @@
 
 #include "internal/pylon_ros2_camera_impl.hpp"
 
+#include <chrono>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -37,6 +39,11 @@ namespace pylon_ros2_camera
 namespace
 {
     static const rclcpp::Logger LOGGER = rclcpp::get_logger("basler.pylon.ros2.pylon_ros2_camera");
+
+    static const char* BLAZE_DEVICE_CLASS = "BaslerGTC/Basler/GenTL_Producer_for_Basler_blaze_101_cameras";
+
+    // time during which a device enumeration is reused by other camera instances
+    static const std::chrono::milliseconds SHARED_ENUMERATION_VALIDITY(1000);
 }
 
 enum PYLON_CAM_TYPE
@@ -57,6 +64,18 @@ PylonROS2Camera::PylonROS2Camera()
     , img_size_byte_(0)
     , grab_timeout_(-1.0)
     , is_ready_(false)
+    , device_serial_number_("")
+    , device_class_("")
+    , is_device_removed_(false)
+    , dropped_frames_(0)
+    , last_chunk_frame_counter_(-1)
+    , last_frame_counter_(-1)
+    , last_offset_x_(0)
+    , last_offset_y_(0)
+    , frame_tracer_(nullptr)
+    , sensor_correction_(nullptr)
+    , is_sensor_geometry_changed_(true)
+    , tone_mapping_(nullptr)
     , is_binary_exposure_search_running_(false)
     , max_brightness_tolerance_(2.5)
 {}
@@ -128,7 +147,7 @@ PYLON_CAM_TYPE detectPylonCamType(const Pylon::CDeviceInfo& device_info)
                 return UNKNOWN;
             }
         }
-        else if (device_class == "BaslerGTC/Basler/GenTL_Producer_for_Basler_blaze_101_cameras")
+        else if (device_class == BLAZE_DEVICE_CLASS)
         {
             if (device_info.IsModelNameAvailable())
             {
@@ -177,6 +196,56 @@ PylonROS2Camera* createFromDevice(PYLON_CAM_TYPE cam_type, Pylon::IPylonDevice*
     }
 }
 
+// Looks for a device matching the filter on the transport layer of the given device class only
+bool findDeviceOnTl(Pylon::CTlFactory& tl_factory,
+                    const Pylon::String_t& device_class,
+                    const Pylon::CDeviceInfo& filter_info,
+                    Pylon::CDeviceInfo& device_info)
+{
+    Pylon::ITransportLayer* tl = tl_factory.CreateTl(device_class);
+    if (!tl)
+    {
+        // transport layer not installed
+        return false;
+    }
+
+    Pylon::DeviceInfoList_t filter;
+    filter.push_back(filter_info);
+
+    Pylon::DeviceInfoList_t device_list;
+    tl->EnumerateDevices(device_list, filter);
+    tl_factory.ReleaseTl(tl);
+
+    if (device_list.empty())
+    {
+        return false;
+    }
+
+    device_info = device_list.front();
+    return true;
+}
+
+// Device enumeration shared by all camera instances of a process: cameras started
+// concurrently reuse the same enumeration instead of each running their own discovery
+size_t enumerateDevicesShared(Pylon::CTlFactory& tl_factory, Pylon::DeviceInfoList_t& device_list)
+{
+    static std::mutex enumeration_mutex;
+    static Pylon::DeviceInfoList_t shared_device_list;
+    static std::chrono::steady_clock::time_point last_enumeration;
+
+    std::lock_guard<std::mutex> lock(enumeration_mutex);
+    const auto now = std::chrono::steady_clock::now();
+    if (shared_device_list.empty() || now - last_enumeration > SHARED_ENUMERATION_VALIDITY)
+    {
+        shared_device_list.clear();
+        tl_factory.EnumerateDevices(shared_device_list);
+        last_enumeration = now;
+    }
+
+    device_list = shared_device_list;
+    return device_list.size();
+}
+
 PylonROS2Camera* PylonROS2Camera::create(const std::string& device_user_id_to_open)
 {
     try
@@ -188,7 +257,7 @@ PylonROS2Camera* PylonROS2Camera::create(const std::string& device_user_id_to_op
         Pylon::DeviceInfoList_t device_list;
         
         // EnumerateDevices() returns the number of devices found
-        if (0 == tl_factory.EnumerateDevices(device_list))
+        if (0 == enumerateDevicesShared(tl_factory, device_list))
         {
             Pylon::PylonTerminate();
             RCLCPP_ERROR_ONCE(LOGGER, "No available camera device");
@@ -211,6 +280,8 @@ PylonROS2Camera* PylonROS2Camera::create(const std::string& device_user_id_to_op
                         //RCLCPP_ERROR_STREAM(LOGGER, "CAM TYPE: " << cam_type);
                         PylonROS2Camera* new_cam_ptr = createFromDevice(cam_type, tl_factory.CreateDevice(*it));
                         new_cam_ptr->device_user_id_ = it->GetUserDefinedName();
+                        new_cam_ptr->device_serial_number_ = it->GetSerialNumber();
+                        new_cam_ptr->device_class_ = it->GetDeviceClass();
                         
                         return new_cam_ptr;
                     }
@@ -247,7 +318,14 @@ PylonROS2Camera* PylonROS2Camera::create(const std::string& device_user_id_to_op
                                             << " with Device User Id: " << device_user_id_to_open);
 
                 PYLON_CAM_TYPE cam_type = detectPylonCamType(*it);
-                return createFromDevice(cam_type, tl_factory.CreateDevice(*it));
+                PylonROS2Camera* new_cam_ptr = createFromDevice(cam_type, tl_factory.CreateDevice(*it));
+                if (new_cam_ptr)
+                {
+                    new_cam_ptr->device_serial_number_ = it->GetSerialNumber();
+                    new_cam_ptr->device_class_ = it->GetDeviceClass();
+                }
+
+                return new_cam_ptr;
             }
             else
             {
@@ -269,11 +347,222 @@ PylonROS2Camera* PylonROS2Camera::create(const std::string& device_user_id_to_op
     }
 }
 
+PylonROS2Camera* PylonROS2Camera::recreate(const PylonROS2Camera& removed_camera)
+{
+    if (removed_camera.device_serial_number_.empty() || removed_camera.device_class_.empty())
+    {
+        return nullptr;
+    }
+
+    // The removed camera instance still holds the pylon runtime, so this only increments its reference counter.
+    Pylon::PylonInitialize();
+
+    try
+    {
+        Pylon::CTlFactory& tl_factory = Pylon::CTlFactory::GetInstance();
+
+        Pylon::CDeviceInfo device_info_filter;
+        device_info_filter.SetSerialNumber(removed_camera.device_serial_number_.c_str());
+        device_info_filter.SetDeviceClass(removed_camera.device_class_.c_str());
+
+        // Only the transport layer the camera was found on the first time is enumerated
+        Pylon::CDeviceInfo device_info;
+        if (!findDeviceOnTl(tl_factory, removed_camera.device_class_.c_str(), device_info_filter, device_info))
+        {
+            Pylon::PylonTerminate();
+            return nullptr;
+        }
+
+        PYLON_CAM_TYPE cam_type = detectPylonCamType(device_info);
+        PylonROS2Camera* new_cam_ptr = createFromDevice(cam_type, tl_factory.CreateDevice(device_info));
+        if (!new_cam_ptr)
+        {
+            Pylon::PylonTerminate();
+            return nullptr;
+        }
+
+        new_cam_ptr->device_user_id_ = device_info.GetUserDefinedName();
+        new_cam_ptr->device_serial_number_ = removed_camera.device_serial_number_;
+        new_cam_ptr->device_class_ = removed_camera.device_class_;
+
+        RCLCPP_INFO_STREAM(LOGGER, "Found camera device again!"
+                                    << " Device Model: " << device_info.GetModelName()
+                                    << " with Serial Number: " << removed_camera.device_serial_number_);
+
+        return new_cam_ptr;
+    }
+    catch (GenICam::GenericException &e)
+    {
+        Pylon::PylonTerminate();
+        RCLCPP_DEBUG_STREAM(LOGGER, "Camera device with Serial Number: " << removed_camera.device_serial_number_
+            << " could not be reopened (yet): " << e.GetDescription());
+
+        return nullptr;
+    }
+}
+
+bool PylonROS2Camera::convertBlazeRaw(const BlazeConversionSettings& settings,
+                                      const BlazeRawData& raw,
+                                      const int& products,
+                                      sensor_msgs::msg::PointCloud2& cloud_msg,
+                                      sensor_msgs::msg::Image& intensity_map_msg,
+                                      sensor_msgs::msg::Image& depth_map_msg,
+                                      sensor_msgs::msg::Image& depth_map_color_msg,
+                                      sensor_msgs::msg::Image& confidence_map_msg)
+{
+    return PylonROS2BlazeCamera::convertBlazeRaw(settings, raw, products,
+                                                 cloud_msg, intensity_map_msg, depth_map_msg, depth_map_color_msg, confidence_map_msg);
+}
+
+PylonROS2Camera* PylonROS2Camera::createDirect(const std::string& serial_number,
+                                               const std::string& ip_address,
+                                               const std::string& full_name)
+{
+    // Before using any pylon methods, the pylon runtime must be initialized.
+    Pylon::PylonInitialize();
+
+    try
+    {
+        Pylon::CTlFactory& tl_factory = Pylon::CTlFactory::GetInstance();
+        Pylon::IPylonDevice* device = nullptr;
+
+        if (!full_name.empty())
+        {
+            // the full name identifies the transport layer and the device, no enumeration is needed
+            Pylon::CDeviceInfo device_info;
+            device_info.SetFullName(full_name.c_str());
+            device = tl_factory.CreateDevice(device_info);
+        }
+        else
+        {
+            Pylon::CDeviceInfo filter_info;
+            if (!serial_number.empty())
+            {
+                filter_info.SetSerialNumber(serial_number.c_str());
+            }
+            if (!ip_address.empty())
+            {
+                filter_info.SetIpAddress(ip_address.c_str());
+
+                // GigE devices with a known IP address are found through a unicast discovery
+                try
+                {
+                    Pylon::CDeviceInfo gige_info(filter_info);
+                    gige_info.SetDeviceClass(Pylon::BaslerGigEDeviceClass);
+                    device = tl_factory.CreateDevice(gige_info);
+                }
+                catch (GenICam::GenericException &e)
+                {
+                    RCLCPP_DEBUG_STREAM(LOGGER, "No GigE camera device found with IP address " << ip_address
+                        << ": " << e.GetDescription());
+                }
+            }
+
+            // USB devices have no IP address
+            std::vector<Pylon::String_t> device_classes;
+            if (ip_address.empty())
+            {
+                device_classes.push_back(Pylon::BaslerUsbDeviceClass);
+                device_classes.push_back(Pylon::BaslerGigEDeviceClass);
+            }
+            device_classes.push_back(BLAZE_DEVICE_CLASS);
+
+            for (auto it = device_classes.begin(); device == nullptr && it != device_classes.end(); ++it)
+            {
+                Pylon::CDeviceInfo device_info;
+                if (findDeviceOnTl(tl_factory, *it, filter_info, device_info))
+                {
+                    device = tl_factory.CreateDevice(device_info);
+                }
+            }
+        }
+
+        if (device == nullptr)
+        {
+            Pylon::PylonTerminate();
+            RCLCPP_ERROR_STREAM(LOGGER, "Couldn't find the camera with Serial Number: '" << serial_number
+                << "', IP Address: '" << ip_address << "', Full Name: '" << full_name << "'! "
+                << "Either the identification is wrong or the camera device is not connected (yet)");
+            return nullptr;
+        }
+
+        const Pylon::CDeviceInfo& device_info = device->GetDeviceInfo();
+        PYLON_CAM_TYPE cam_type = detectPylonCamType(device_info);
+        PylonROS2Camera* new_cam_ptr = createFromDevice(cam_type, device);
+        if (!new_cam_ptr)
+        {
+            tl_factory.DestroyDevice(device);
+            Pylon::PylonTerminate();
+            return nullptr;
+        }
+
+        RCLCPP_INFO_STREAM(LOGGER, "Found camera device!"
+                                    << " Device Model: " << device_info.GetModelName()
+                                    << " with Serial Number: " << device_info.GetSerialNumber());
+
+        new_cam_ptr->device_user_id_ = device_info.GetUserDefinedName();
+        new_cam_ptr->device_serial_number_ = device_info.GetSerialNumber();
+        new_cam_ptr->device_class_ = device_info.GetDeviceClass();
+
+        return new_cam_ptr;
+    }
+    catch (GenICam::GenericException &e)
+    {
+        Pylon::PylonTerminate();
+        RCLCPP_ERROR_STREAM(LOGGER, "An exception occurred while opening the camera device with "
+            << "Serial Number: '" << serial_number << "', IP Address: '" << ip_address
+            << "', Full Name: '" << full_name << "': \r\n" << e.GetDescription());
+
+        return nullptr;
+    }
+}
+
 const std::string& PylonROS2Camera::deviceUserID() const
 {
     return device_user_id_;
 }
 
+const std::string& PylonROS2Camera::deviceSerialNumber() const
+{
+    return device_serial_number_;
+}
+
+uint64_t PylonROS2Camera::droppedFrames() const
+{
+    return dropped_frames_;
+}
+
+int64_t PylonROS2Camera::frameCounter() const
+{
+    return last_frame_counter_;
+}
+
+size_t PylonROS2Camera::frameOffsetX() const
+{
+    return last_offset_x_;
+}
+
+size_t PylonROS2Camera::frameOffsetY() const
+{
+    return last_offset_y_;
+}
+
+void PylonROS2Camera::setFrameTracer(FrameTracer* tracer)
+{
+    frame_tracer_ = tracer;
+}
+
+void PylonROS2Camera::setSensorCorrection(SensorCorrection* correction)
+{
+    sensor_correction_ = correction;
+    is_sensor_geometry_changed_ = true;
+}
+
+void PylonROS2Camera::setToneMapping(ToneMapping* tone_mapping)
+{
+    tone_mapping_ = tone_mapping;
+}
+
 const size_t& PylonROS2Camera::imageRows() const
 {
     return img_rows_;
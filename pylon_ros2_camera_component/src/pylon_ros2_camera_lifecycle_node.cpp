@@ -0,0 +1,324 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "pylon_ros2_camera_lifecycle_node.hpp"
+
+#include <chrono>
+
+
+namespace pylon_ros2_camera
+{
+
+namespace
+{
+    static const rclcpp::Logger LOGGER = rclcpp::get_logger("basler.pylon.ros2.pylon_ros2_camera_lifecycle_node");
+}
+
+PylonROS2CameraLifecycleNode::PylonROS2CameraLifecycleNode(const rclcpp::NodeOptions& options)
+  : rclcpp_lifecycle::LifecycleNode("pylon_ros2_camera_node", options)
+  , pylon_camera_(nullptr)
+  , pylon_camera_parameter_set_()
+  , camera_info_manager_(nullptr)
+  , img_raw_pub_(nullptr)
+  , camera_info_pub_(nullptr)
+  , timer_(nullptr)
+{}
+
+PylonROS2CameraLifecycleNode::~PylonROS2CameraLifecycleNode()
+{
+  this->releaseResources();
+}
+
+CallbackReturn PylonROS2CameraLifecycleNode::on_configure(const rclcpp_lifecycle::State& /*previous_state*/)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  this->pylon_camera_parameter_set_.readFromRosParameterServer(*this);
+
+  if (!this->openAndConfigureCamera())
+  {
+    this->releaseResources();
+    return CallbackReturn::FAILURE;
+  }
+
+  this->img_raw_pub_ = this->create_publisher<sensor_msgs::msg::Image>("~/image_raw", 10);
+  this->camera_info_pub_ = this->create_publisher<sensor_msgs::msg::CameraInfo>("~/camera_info", 10);
+
+  RCLCPP_INFO_STREAM(LOGGER, "Camera configured in "
+                     << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+                     << " ms, ready to be activated");
+
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn PylonROS2CameraLifecycleNode::on_activate(const rclcpp_lifecycle::State& /*previous_state*/)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(this->grab_mutex_);
+    const std::string result = this->pylon_camera_->grabbingStarting();
+    if (result.find("done") == std::string::npos)
+    {
+      RCLCPP_ERROR_STREAM(LOGGER, "Error while starting the image acquisition: " << result);
+      return CallbackReturn::FAILURE;
+    }
+  }
+
+  this->img_raw_pub_->on_activate();
+  this->camera_info_pub_->on_activate();
+
+  this->timer_ = this->create_wall_timer(
+            std::chrono::duration<double>(1. / this->pylon_camera_parameter_set_.frameRate()),
+            std::bind(&PylonROS2CameraLifecycleNode::spin, this));
+
+  RCLCPP_INFO_STREAM(LOGGER, "Camera activated in "
+                     << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+                     << " ms");
+
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn PylonROS2CameraLifecycleNode::on_deactivate(const rclcpp_lifecycle::State& /*previous_state*/)
+{
+  if (this->timer_)
+  {
+    this->timer_->cancel();
+    this->timer_.reset();
+  }
+
+  this->img_raw_pub_->on_deactivate();
+  this->camera_info_pub_->on_deactivate();
+
+  // the camera stays open and configured
+  std::lock_guard<std::recursive_mutex> lock(this->grab_mutex_);
+  this->pylon_camera_->grabbingStopping();
+
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn PylonROS2CameraLifecycleNode::on_cleanup(const rclcpp_lifecycle::State& /*previous_state*/)
+{
+  this->releaseResources();
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn PylonROS2CameraLifecycleNode::on_shutdown(const rclcpp_lifecycle::State& /*previous_state*/)
+{
+  this->releaseResources();
+  return CallbackReturn::SUCCESS;
+}
+
+bool PylonROS2CameraLifecycleNode::openAndConfigureCamera()
+{
+  if (!this->pylon_camera_parameter_set_.device_serial_number_.empty() ||
+      !this->pylon_camera_parameter_set_.device_ip_address_.empty() ||
+      !this->pylon_camera_parameter_set_.device_full_name_.empty())
+  {
+    this->pylon_camera_ = PylonROS2Camera::createDirect(this->pylon_camera_parameter_set_.device_serial_number_,
+                                                        this->pylon_camera_parameter_set_.device_ip_address_,
+                                                        this->pylon_camera_parameter_set_.device_full_name_);
+  }
+  else
+  {
+    this->pylon_camera_ = PylonROS2Camera::create(this->pylon_camera_parameter_set_.deviceUserID());
+  }
+
+  if (this->pylon_camera_ == nullptr)
+  {
+    RCLCPP_ERROR(LOGGER, "No available camera");
+    return false;
+  }
+
+  if (this->pylon_camera_->isBlaze())
+  {
+    RCLCPP_ERROR(LOGGER, "The blaze camera is not supported by the lifecycle node");
+    return false;
+  }
+
+  if (!this->pylon_camera_->registerCameraConfiguration())
+  {
+    RCLCPP_ERROR(LOGGER, "Error while registering the camera configuration to software-trigger mode!");
+    return false;
+  }
+
+  if (!this->pylon_camera_->openCamera())
+  {
+    RCLCPP_ERROR(LOGGER, "Error while trying to open the user-specified camera!");
+    return false;
+  }
+
+  if (this->pylon_camera_parameter_set_.heartbeat_timeout_ > 0)
+  {
+    this->pylon_camera_->setHeartbeatTimeout(this->pylon_camera_parameter_set_.heartbeat_timeout_);
+  }
+
+  if (!this->pylon_camera_->applyCamSpecificStartupSettings(this->pylon_camera_parameter_set_))
+  {
+    RCLCPP_ERROR(LOGGER, "Error while applying the user-specified startup settings to the camera!");
+    return false;
+  }
+
+  // starts the acquisition once, to detect the image encoding and validate the configuration with a test grab
+  if (!this->pylon_camera_->startGrabbing(this->pylon_camera_parameter_set_))
+  {
+    RCLCPP_ERROR(LOGGER, "Error while starting the camera!");
+    return false;
+  }
+
+  this->applyImageSettings();
+
+  // warm standby: configured but not streaming
+  this->pylon_camera_->grabbingStopping();
+
+  if (this->pylon_camera_->maxPossibleFramerate() < this->pylon_camera_parameter_set_.frameRate() ||
+      this->pylon_camera_parameter_set_.frameRate() == -1)
+  {
+    this->pylon_camera_parameter_set_.setFrameRate(*this, this->pylon_camera_->maxPossibleFramerate());
+  }
+
+  this->img_raw_msg_.header.frame_id = this->pylon_camera_parameter_set_.cameraFrame();
+  this->img_raw_msg_.encoding = this->pylon_camera_->currentROSEncoding();
+  this->img_raw_msg_.height = this->pylon_camera_->imageRows();
+  this->img_raw_msg_.width = this->pylon_camera_->imageCols();
+  // step = full row length in bytes, imagePixelDepth already contains the number of channels
+  this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->imagePixelDepth();
+  this->img_raw_msg_.data.resize(this->pylon_camera_->imageSize());
+
+  this->camera_info_manager_ = std::make_shared<camera_info_manager::CameraInfoManager>(this, this->pylon_camera_->deviceUserID());
+
+  sensor_msgs::msg::CameraInfo initial_cam_info;
+  this->pylon_camera_->getInitialCameraInfo(initial_cam_info);
+  initial_cam_info.header.frame_id = this->pylon_camera_parameter_set_.cameraFrame();
+  this->camera_info_manager_->setCameraInfo(initial_cam_info);
+
+  if (!this->pylon_camera_parameter_set_.cameraInfoURL().empty() &&
+      this->camera_info_manager_->validateURL(this->pylon_camera_parameter_set_.cameraInfoURL()) &&
+      this->camera_info_manager_->loadCameraInfo(this->pylon_camera_parameter_set_.cameraInfoURL()))
+  {
+    sensor_msgs::msg::CameraInfo cam_info = this->camera_info_manager_->getCameraInfo();
+    cam_info.header.frame_id = this->pylon_camera_parameter_set_.cameraFrame();
+    this->camera_info_manager_->setCameraInfo(cam_info);
+  }
+
+  return true;
+}
+
+void PylonROS2CameraLifecycleNode::applyImageSettings()
+{
+  if (this->pylon_camera_parameter_set_.binning_x_given_)
+  {
+    size_t reached_binning_x;
+    this->pylon_camera_->setBinningX(this->pylon_camera_parameter_set_.binning_x_, reached_binning_x);
+  }
+
+  if (this->pylon_camera_parameter_set_.binning_y_given_)
+  {
+    size_t reached_binning_y;
+    this->pylon_camera_->setBinningY(this->pylon_camera_parameter_set_.binning_y_, reached_binning_y);
+  }
+
+  if (this->pylon_camera_parameter_set_.exposure_given_)
+  {
+    float reached_exposure;
+    this->pylon_camera_->setExposure(this->pylon_camera_parameter_set_.exposure_, reached_exposure);
+  }
+
+  if (this->pylon_camera_parameter_set_.gain_given_)
+  {
+    float reached_gain;
+    this->pylon_camera_->setGain(this->pylon_camera_parameter_set_.gain_, reached_gain);
+  }
+
+  if (this->pylon_camera_parameter_set_.gamma_given_)
+  {
+    float reached_gamma;
+    this->pylon_camera_->setGamma(this->pylon_camera_parameter_set_.gamma_, reached_gamma);
+  }
+
+  RCLCPP_INFO_STREAM(LOGGER, "Startup settings: "
+    << "encoding = '" << this->pylon_camera_->currentROSEncoding() << "', "
+    << "binning = [" << this->pylon_camera_->currentBinningX() << ", "
+                     << this->pylon_camera_->currentBinningY() << "], "
+    << "exposure = " << this->pylon_camera_->currentExposure() << ", "
+    << "gain = " << this->pylon_camera_->currentGain() << ", "
+    << "gamma = " <<  this->pylon_camera_->currentGamma());
+}
+
+void PylonROS2CameraLifecycleNode::releaseResources()
+{
+  if (this->timer_)
+  {
+    this->timer_->cancel();
+    this->timer_.reset();
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(this->grab_mutex_);
+
+  this->img_raw_pub_.reset();
+  this->camera_info_pub_.reset();
+  this->camera_info_manager_.reset();
+
+  if (this->pylon_camera_)
+  {
+    delete this->pylon_camera_;
+    this->pylon_camera_ = nullptr;
+  }
+}
+
+void PylonROS2CameraLifecycleNode::spin()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->grab_mutex_);
+
+  if (this->pylon_camera_->isCamRemoved())
+  {
+    RCLCPP_ERROR_THROTTLE(LOGGER, *this->get_clock(), 5000, "Pylon camera has been removed, the node has to be reconfigured");
+    return;
+  }
+
+  // Store current time before the image is transmitted for a more accurate grab time estimation.
+  // If chunk timestamp is enabled, grab will overwrite it with the acquisition timestamp.
+  auto stamp = this->now();
+  if (!this->pylon_camera_->grab(this->img_raw_msg_.data, stamp))
+  {
+    return;
+  }
+  this->img_raw_msg_.header.stamp = stamp;
+
+  // get actual cam_info-object in every frame, because it might have
+  // changed due to a 'set_camera_info'-service call
+  sensor_msgs::msg::CameraInfo cam_info = this->camera_info_manager_->getCameraInfo();
+  cam_info.header.stamp = this->img_raw_msg_.header.stamp;
+
+  this->img_raw_pub_->publish(this->img_raw_msg_);
+  this->camera_info_pub_->publish(cam_info);
+}
+
+} // namespace pylon_ros2_camera
+
+RCLCPP_COMPONENTS_REGISTER_NODE(pylon_ros2_camera::PylonROS2CameraLifecycleNode)
@@ -27,8 +27,23 @@
  *****************************************************************************/
 
 #include <GenApi/GenApi.h>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
 
 #include "pylon_ros2_camera_node.hpp"
+#include "encoding_conversions.hpp"
 
 
 namespace pylon_ros2_camera
@@ -37,21 +52,274 @@ namespace pylon_ros2_camera
 namespace
 {
     static const rclcpp::Logger LOGGER = rclcpp::get_logger("basler.pylon.ros2.pylon_ros2_camera_node");
+
+    // creates the given directory including all its missing parents
+    bool createDirectories(const std::string& path)
+    {
+        for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1))
+        {
+            const std::string dir = path.substr(0, pos);
+            if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+            {
+                return false;
+            }
+
+            if (pos == std::string::npos)
+            {
+                return true;
+            }
+        }
+    }
+
+    // converts the (offset, size) pairs of a parameter into zones
+    std::vector<ROIZone> toROIZones(const std::vector<int64_t>& pairs)
+    {
+        std::vector<ROIZone> zones;
+        for (size_t i = 0; i + 1 < pairs.size(); i += 2)
+        {
+            zones.push_back(ROIZone(static_cast<size_t>(pairs[i]), static_cast<size_t>(pairs[i + 1])));
+        }
+        return zones;
+    }
+
+    // adds the time elapsed since start to the statistics of a frame path stage
+    void addStageTime(PylonROS2CameraNode::StageStatistics& statistics, const std::chrono::steady_clock::time_point& start)
+    {
+        const double duration_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        statistics.sum_ms += duration_ms;
+        statistics.max_ms = std::max(statistics.max_ms, duration_ms);
+        statistics.count++;
+    }
+
+    // pins the calling thread to the given cores and sets its real-time priority or nice value,
+    // the outcome is only logged if verbose
+    void applyThreadScheduling(const std::string& thread_name, const std::vector<int64_t>& cpus, const int& priority, const int& nice,
+                               const bool& is_verbose = true)
+    {
+        if (!cpus.empty())
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            for (const int64_t cpu : cpus)
+            {
+                CPU_SET(static_cast<int>(cpu), &cpu_set);
+            }
+
+            const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+            if (error != 0 && is_verbose)
+            {
+                RCLCPP_WARN_STREAM(LOGGER, "Could not pin the " << thread_name << " thread: " << std::strerror(error));
+            }
+            else if (is_verbose)
+            {
+                RCLCPP_INFO_STREAM(LOGGER, "The " << thread_name << " thread is pinned to " << cpus.size() << " core(s)");
+            }
+        }
+
+        if (priority > 0)
+        {
+            sched_param param;
+            param.sched_priority = priority;
+            const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+            if (error != 0 && is_verbose)
+            {
+                RCLCPP_WARN_STREAM(LOGGER, "Could not set the SCHED_FIFO priority of the " << thread_name << " thread: " << std::strerror(error));
+            }
+            else if (is_verbose)
+            {
+                RCLCPP_INFO_STREAM(LOGGER, "The " << thread_name << " thread runs with SCHED_FIFO priority " << priority);
+            }
+        }
+        else if (nice != 0)
+        {
+            // on Linux, the nice value is an attribute of each thread
+            if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), nice) != 0 && is_verbose)
+            {
+                RCLCPP_WARN_STREAM(LOGGER, "Could not set the nice value of the " << thread_name << " thread: " << std::strerror(errno));
+            }
+            else if (is_verbose)
+            {
+                RCLCPP_INFO_STREAM(LOGGER, "The " << thread_name << " thread runs with nice value " << nice);
+            }
+        }
+    }
 }
 
+/**
+ * Scheduling of the thread running the acquisition. The executor may run the acquisition on any of its
+ * threads: the settings are applied once to the thread running it, and the previous ones of that thread are
+ * restored once the acquisition moves to another thread. The scheduling syscalls are only made when the
+ * thread changes, the check for each frame is a thread local read.
+ */
+class AcquisitionThreadScheduling
+{
+public:
+  AcquisitionThreadScheduling()
+    : token_(0)
+    , tid_(0)
+    , is_logged_(false)
+    , is_affinity_saved_(false)
+    , is_policy_saved_(false)
+    , is_nice_saved_(false)
+    , saved_cpu_set_()
+    , saved_policy_(SCHED_OTHER)
+    , saved_param_()
+    , saved_nice_(0)
+  {}
+
+  ~AcquisitionThreadScheduling()
+  {
+    this->restore();
+  }
+
+  // nothing is changed (nor saved) for the settings left to their defaults
+  void apply(const std::vector<int64_t>& cpus, const int& priority, const int& nice)
+  {
+    if (cpus.empty() && priority <= 0 && nice == 0)
+    {
+      return;
+    }
+    // the token of the scheduling the calling thread got last, unique over all the nodes and threads
+    static thread_local uint64_t thread_token = 0;
+    if (this->token_ != 0 && thread_token == this->token_)
+    {
+      return;
+    }
+
+    this->restore();
+
+    // the thread is identified by its id for the restore, which may be called from another thread
+    this->tid_ = static_cast<pid_t>(syscall(SYS_gettid));
+    if (!cpus.empty())
+    {
+      this->is_affinity_saved_ = sched_getaffinity(this->tid_, sizeof(this->saved_cpu_set_), &this->saved_cpu_set_) == 0;
+    }
+    if (priority > 0)
+    {
+      this->saved_policy_ = sched_getscheduler(this->tid_);
+      this->is_policy_saved_ = this->saved_policy_ >= 0 && sched_getparam(this->tid_, &this->saved_param_) == 0;
+    }
+    else if (nice != 0)
+    {
+      // -1 is a valid nice value
+      errno = 0;
+      this->saved_nice_ = getpriority(PRIO_PROCESS, static_cast<id_t>(this->tid_));
+      this->is_nice_saved_ = errno == 0;
+    }
+
+    applyThreadScheduling("acquisition", cpus, priority, nice, !this->is_logged_);
+    this->is_logged_ = true;
+
+    static std::atomic<uint64_t> last_token(0);
+    this->token_ = ++last_token;
+    thread_token = this->token_;
+  }
+
+private:
+  // restores the settings of the thread which ran the acquisition last, if it still exists
+  void restore()
+  {
+    // the priority is dropped first, the thread may then be moved to its former cores
+    if (this->is_policy_saved_)
+    {
+      sched_setscheduler(this->tid_, this->saved_policy_, &this->saved_param_);
+    }
+    if (this->is_nice_saved_)
+    {
+      setpriority(PRIO_PROCESS, static_cast<id_t>(this->tid_), this->saved_nice_);
+    }
+    if (this->is_affinity_saved_)
+    {
+      sched_setaffinity(this->tid_, sizeof(this->saved_cpu_set_), &this->saved_cpu_set_);
+    }
+    this->is_policy_saved_ = false;
+    this->is_nice_saved_ = false;
+    this->is_affinity_saved_ = false;
+    this->token_ = 0;
+  }
+
+  uint64_t token_;
+  pid_t tid_;
+  bool is_logged_;
+  bool is_affinity_saved_;
+  bool is_policy_saved_;
+  bool is_nice_saved_;
+  cpu_set_t saved_cpu_set_;
+  int saved_policy_;
+  sched_param saved_param_;
+  int saved_nice_;
+};
+
 PylonROS2CameraNode::PylonROS2CameraNode(const rclcpp::NodeOptions& options)
+  : PylonROS2CameraNode(options, std::function<PylonROS2Camera*()>())
+{}
+
+PylonROS2CameraNode::PylonROS2CameraNode(const rclcpp::NodeOptions& options,
+                                         const std::function<PylonROS2Camera*()>& camera_factory)
   : Node("pylon_ros2_camera_node", options)
+  , camera_factory_(camera_factory)
   , pylon_camera_(nullptr)
   , pinhole_model_(nullptr)
   , pylon_camera_parameter_set_()
   , camera_info_manager_(new camera_info_manager::CameraInfoManager(this))
   , cv_bridge_img_rect_(nullptr)
+  , cam_info_msg_()
+  , managed_cam_info_msg_()
+  , camera_info_timer_(nullptr)
+  , img_rect_msg_()
+  , debayered_img_()
+  , rect_source_encoding_("")
+  , rect_source_cv_type_(-1)
+  , rect_bayer_code_(-1)
+  , is_depth_image_computed_(false)
+  , registration_channel_(nullptr)
+  , blaze_compressor_()
+  , image_encoder_pool_()
+  , video_encoder_()
+  , shm_writer_()
+  , sensor_correction_()
+  , tone_mapping_()
+  , image_buffers_()
+  , tracking_roi_sub_(nullptr)
+  , tracking_roi_mutex_()
+  , tracking_roi_target_()
+  , is_tracking_roi_target_pending_(false)
+  , multi_roi_rows_()
+  , multi_roi_columns_()
+  , zone_pubs_()
+  , zone_msgs_()
+  , zone_infos_()
   , img_rect_pub_(nullptr)
   , set_user_output_srvs_()
   , grab_imgs_rect_as_(nullptr)
   , sampling_indices_()
   , brightness_exp_lut_()
   , is_sleeping_(false)
+  , is_reconnecting_(false)
+  , is_waiting_for_camera_(false)
+  , reconnect_start_time_()
+  , last_reconnect_attempt_time_()
+  , grab_failures_(0)
+  , watchdog_recovery_step_(0)
+  , last_frame_time_(std::chrono::steady_clock::now())
+  , stream_stall_start_time_()
+  , acquisition_scheduling_(new AcquisitionThreadScheduling())
+  , reported_dropped_frames_(0)
+  , frame_tracer_()
+  , grab_statistics_()
+  , rectification_statistics_()
+  , publish_statistics_()
+  , diagnostics_dropped_frames_(0)
+  , startup_phase_start_()
+  , startup_phases_()
+  , startup_snapshot_file_("")
+  , is_startup_snapshot_restored_(false)
+  , min_publish_frequency_(0.0)
+  , max_publish_frequency_(0.0)
+  , frequency_status_(nullptr)
+  , timestamp_status_(nullptr)
+  , frame_receive_time_()
+  , diagnostics_timer_(nullptr)
   , diagnostics_updater_(this)
 {
   // information logging severity mode
@@ -74,10 +342,22 @@ PylonROS2CameraNode::PylonROS2CameraNode(const rclcpp::NodeOptions& options)
   timer_ = this->create_wall_timer(
             std::chrono::duration<double>(1. / this->frameRate()),
             std::bind(&PylonROS2CameraNode::spin, this));
+
+  // a 'set_camera_info'-service call is picked up outside of the frame loop, once per second
+  this->camera_info_timer_ = this->create_wall_timer(
+            std::chrono::seconds(1),
+            std::bind(&PylonROS2CameraNode::cameraInfoTimerCallback, this));
 }
 
 PylonROS2CameraNode::~PylonROS2CameraNode()
 {
+  // the workers publish the compressed frames
+  this->blaze_compressor_.stop();
+  this->image_encoder_pool_.stop();
+  this->video_encoder_.stop();
+  // the readers are notified that the ring is closed
+  this->shm_writer_.stop();
+
   if (this->pylon_camera_)
   {
     delete this->pylon_camera_;
@@ -113,36 +393,216 @@ const std::string& PylonROS2CameraNode::cameraFrame() const
   return this->pylon_camera_parameter_set_.cameraFrame();
 }
 
+const std::string& PylonROS2CameraNode::blazeCloudFrame() const
+{
+  // the transform into the cloud frame is applied by the camera while converting the data
+  return this->pylon_camera_parameter_set_.blaze_cloud_frame_.empty() ? this->cameraFrame() : this->pylon_camera_parameter_set_.blaze_cloud_frame_;
+}
+
+bool PylonROS2CameraNode::isInitialized() const
+{
+  return this->timer_ != nullptr;
+}
+
 bool PylonROS2CameraNode::init()
 {
+  this->startup_phases_.clear();
+  this->startup_phase_start_ = std::chrono::steady_clock::now();
+
   // reading all necessary parameter to open the desired camera from the
   // ros-parameter-server. In case that invalid parameter values can be
   // detected, the interface will reset them to the default values.
   // These parameters furthermore contain the intrinsic calibration matrices,
   // in case they are provided
   this->pylon_camera_parameter_set_.readFromRosParameterServer(*this);
+  this->frame_tracer_.setCapacity(std::max(0, this->pylon_camera_parameter_set_.trace_buffer_size_));
+  this->initFramePathDiagnostics();
+  this->recordStartupPhase("read parameters");
   
   // creating the target PylonCamera-Object with the specified
   // device_user_id, registering the Software-Trigger-Mode, starting the
   // communication with the device and enabling the desired startup-settings
   if (!this->initAndRegister())
   {
-    RCLCPP_ERROR(LOGGER, "Error when trying to init and register. Shutting down now.");
-    rclcpp::shutdown();
+    RCLCPP_ERROR(LOGGER, "Error when trying to init and register.");
+    if (this->pylon_camera_parameter_set_.shutdown_on_init_failure_)
+    {
+      rclcpp::shutdown();
+    }
     return false;
   }
 
   // starting the grabbing procedure with the desired image-settings
   if (!this->startGrabbing())
   {
-    RCLCPP_ERROR(LOGGER, "Error when trying to start grabbing. Shutting down now.");
-    rclcpp::shutdown();
+    RCLCPP_ERROR(LOGGER, "Error when trying to start grabbing.");
+    if (this->pylon_camera_parameter_set_.shutdown_on_init_failure_)
+    {
+      rclcpp::shutdown();
+    }
     return false;
   }
 
+  // the frames are handed to a blaze of the same process, which does the registration
+  if (!this->pylon_camera_->isBlaze() && !this->pylon_camera_parameter_set_.registration_channel_.empty())
+  {
+    this->registration_channel_ = ColorFrameChannel::get(this->pylon_camera_parameter_set_.registration_channel_);
+    RCLCPP_INFO_STREAM(LOGGER, "The frames are posted to the registration channel " << this->pylon_camera_parameter_set_.registration_channel_);
+  }
+
+  // the compressed output keeps its workers over a reinitialization
+  if (this->pylon_camera_->isBlaze() && !this->pylon_camera_parameter_set_.blaze_compression_.empty() && !this->blaze_compressor_.isStarted())
+  {
+    const PylonROS2CameraParameter& parameters = this->pylon_camera_parameter_set_;
+    this->blaze_compressor_.start(parameters.blaze_compression_,
+                                  parameters.blaze_compression_level_,
+                                  static_cast<float>(parameters.blaze_compression_quantization_),
+                                  parameters.blaze_compression_threads_,
+                                  [&parameters]()
+                                  {
+                                    applyThreadScheduling("worker", parameters.worker_cpus_, parameters.worker_priority_, parameters.worker_nice_);
+                                  },
+                                  [this](const pylon_ros2_camera_interfaces::msg::CompressedBlazeData& msg)
+                                  {
+                                    this->blaze_compressed_pub_->publish(msg);
+                                  });
+  }
+
+  if (!this->pylon_camera_->isBlaze() && !this->pylon_camera_parameter_set_.compressed_format_.empty() && !this->image_encoder_pool_.isStarted())
+  {
+    const PylonROS2CameraParameter& parameters = this->pylon_camera_parameter_set_;
+    this->image_encoder_pool_.start(parameters.compressed_format_,
+                                    parameters.compressed_jpeg_quality_,
+                                    parameters.compressed_png_level_,
+                                    parameters.compressed_threads_,
+                                    [&parameters]()
+                                    {
+                                      applyThreadScheduling("worker", parameters.worker_cpus_, parameters.worker_priority_, parameters.worker_nice_);
+                                    },
+                                    [this](const sensor_msgs::msg::CompressedImage& msg)
+                                    {
+                                      this->img_encoded_pub_->publish(msg);
+                                    });
+  }
+
+  if (!this->pylon_camera_->isBlaze() && !this->pylon_camera_parameter_set_.video_codec_.empty() && !this->video_encoder_.isStarted())
+  {
+    const PylonROS2CameraParameter& parameters = this->pylon_camera_parameter_set_;
+    this->video_encoder_.start(parameters.video_codec_,
+                               parameters.video_bitrate_,
+                               parameters.video_gop_,
+                               parameters.video_preset_,
+                               parameters.video_scale_,
+                               parameters.frameRate(),
+                               [&parameters]()
+                               {
+                                 applyThreadScheduling("worker", parameters.worker_cpus_, parameters.worker_priority_, parameters.worker_nice_);
+                               },
+                               [this](const pylon_ros2_camera_interfaces::msg::VideoPacket& msg)
+                               {
+                                 this->video_pub_->publish(msg);
+                               });
+  }
+
+  // the image publishers are created with the interfaces, before the parameters are read
+  if (!this->pylon_camera_->isBlaze() && this->pylon_camera_parameter_set_.intra_process_images_ && !this->img_raw_cv_pub_)
+  {
+    this->img_raw_pub_.shutdown();
+    this->img_raw_cv_pub_ = this->create_publisher<CvMatImage>("~/image_raw", 10);
+    // a camera info published intra-process would be copied into a new message for each frame
+    rclcpp::PublisherOptions cam_info_options;
+    cam_info_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Disable;
+    this->cam_info_pub_ = this->create_publisher<sensor_msgs::msg::CameraInfo>("~/camera_info", 10, cam_info_options);
+    RCLCPP_INFO(LOGGER, "The images are published as cv::Mat through a type adapter, without image transport");
+  }
+
+  if (!this->pylon_camera_->isBlaze() && !this->pylon_camera_parameter_set_.shm_name_.empty() && !this->shm_writer_.isStarted())
+  {
+    this->shm_writer_.start(this->pylon_camera_parameter_set_.shm_name_, this->pylon_camera_parameter_set_.shm_slots_);
+  }
+
+  // one camera publisher per zone, the zones are kept over a reinitialization
+  if (this->zone_pubs_.empty() && !this->multi_roi_rows_.empty() && !this->multi_roi_columns_.empty())
+  {
+    const size_t zones = this->multi_roi_rows_.size() * this->multi_roi_columns_.size();
+    for (size_t i = 0; i < zones; ++i)
+    {
+      this->zone_pubs_.push_back(image_transport::create_camera_publisher(this, "~/zone_" + std::to_string(i) + "/image_raw"));
+    }
+    this->zone_msgs_.resize(zones);
+  }
+
+  // only the latest target matters, the window is moved once per frame
+  if (!this->pylon_camera_->isBlaze() && this->pylon_camera_parameter_set_.tracking_roi_width_ > 0 && !this->tracking_roi_sub_)
+  {
+    this->tracking_roi_sub_ = this->create_subscription<sensor_msgs::msg::RegionOfInterest>(
+      "~/tracking_roi", 1, std::bind(&PylonROS2CameraNode::trackingROICallback, this, std::placeholders::_1));
+    RCLCPP_INFO_STREAM(LOGGER, "Tracking window of " << this->pylon_camera_parameter_set_.tracking_roi_width_ << "x"
+                       << this->pylon_camera_parameter_set_.tracking_roi_height_ << ", moved by the tracking_roi topic");
+  }
+
+  // the image buffers are allocated once the grabbing is started
+  if (this->pylon_camera_parameter_set_.lock_memory_)
+  {
+    this->lockMemory();
+  }
+
+  // the snapshot is taken once the complete startup configuration is applied
+  if (!this->startup_snapshot_file_.empty() && !this->is_startup_snapshot_restored_)
+  {
+    if (this->pylon_camera_->savePfs(this->startup_snapshot_file_).find("done") != std::string::npos)
+    {
+      RCLCPP_INFO_STREAM(LOGGER, "Startup snapshot saved to " << this->startup_snapshot_file_);
+    }
+    this->recordStartupPhase("save startup snapshot");
+  }
+
+  this->logStartupTiming();
+
   return true;
 }
 
+void PylonROS2CameraNode::lockMemory()
+{
+  if (!this->pylon_camera_->isBlaze())
+  {
+    // the image message buffer is reused by every grab, it is faulted in now
+    this->img_raw_msg_.data.resize(this->img_raw_msg_.height * this->img_raw_msg_.step);
+  }
+
+  // MCL_CURRENT faults in and locks the pages already mapped, MCL_FUTURE the ones
+  // mapped later on (e.g. the buffers of a reconnected camera)
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    RCLCPP_WARN_STREAM(LOGGER, "Could not lock the process memory: " << std::strerror(errno));
+    return;
+  }
+
+  this->recordStartupPhase("lock memory");
+  RCLCPP_INFO(LOGGER, "Process memory locked");
+}
+
+void PylonROS2CameraNode::recordStartupPhase(const std::string& phase)
+{
+  const auto now = std::chrono::steady_clock::now();
+  this->startup_phases_.emplace_back(phase, std::chrono::duration<double, std::milli>(now - this->startup_phase_start_).count());
+  this->startup_phase_start_ = now;
+}
+
+void PylonROS2CameraNode::logStartupTiming()
+{
+  std::ostringstream timing;
+  double total = 0.0;
+  for (const auto& phase : this->startup_phases_)
+  {
+    timing << phase.first << " = " << phase.second << ", ";
+    total += phase.second;
+  }
+
+  RCLCPP_INFO_STREAM(LOGGER, "Startup timing [ms]: " << timing.str() << "total = " << total);
+  this->startup_phases_.clear();
+}
+
 void PylonROS2CameraNode::initInterfaces()
 {
   this->initPublishers();
@@ -166,6 +626,12 @@ void PylonROS2CameraNode::initPublishers()
 
   msg_name = msg_prefix + "image_raw";
   this->img_raw_pub_ = image_transport::create_camera_publisher(this, msg_name);
+  // frames encoded by the driver, if enabled, readable by the compressed image_transport subscribers
+  msg_name = msg_prefix + "image_encoded/compressed";
+  this->img_encoded_pub_ = this->create_publisher<sensor_msgs::msg::CompressedImage>(msg_name, 10);
+  // H.264 / H.265 packets, if enabled
+  msg_name = msg_prefix + "video";
+  this->video_pub_ = this->create_publisher<pylon_ros2_camera_interfaces::msg::VideoPacket>(msg_name, 10);
 
   // blaze related topics
   msg_name = msg_prefix + "blaze_cloud"; this->blaze_cloud_topic_name_ = msg_name;
@@ -180,6 +646,14 @@ void PylonROS2CameraNode::initPublishers()
   this->blaze_confidence_pub_ = this->create_publisher<sensor_msgs::msg::Image>(msg_name, 10);
   msg_name = msg_prefix + "blaze_camera_info";
   this->blaze_cam_info_pub_ = this->create_publisher<sensor_msgs::msg::CameraInfo>(msg_name, 10);
+  // metric depth image, following the depth_image_proc naming
+  msg_name = msg_prefix + "depth/image_raw";
+  this->blaze_depth_image_pub_ = this->create_publisher<sensor_msgs::msg::Image>(msg_name, 10);
+  msg_name = msg_prefix + "depth/camera_info";
+  this->blaze_depth_cam_info_pub_ = this->create_publisher<sensor_msgs::msg::CameraInfo>(msg_name, 10);
+  // compressed point coordinates, intensity and confidence, if enabled
+  msg_name = msg_prefix + "blaze_compressed";
+  this->blaze_compressed_pub_ = this->create_publisher<pylon_ros2_camera_interfaces::msg::CompressedBlazeData>(msg_name, 10);
 }
 
 void PylonROS2CameraNode::initServices()
@@ -536,6 +1010,9 @@ void PylonROS2CameraNode::initServices()
 
   srv_name = srv_prefix + "update_sync_free_run_timer";
   this->update_sync_free_run_timer_srv_ = this->create_service<TriggerSrv>(srv_name, std::bind(&PylonROS2CameraNode::updateSyncFreeRunTimerCallback, this, _1, _2));
+
+  srv_name = srv_prefix + "dump_frame_traces";
+  this->dump_frame_traces_srv_ = this->create_service<TriggerSrv>(srv_name, std::bind(&PylonROS2CameraNode::dumpFrameTracesCallback, this, _1, _2));
 }
 
 void PylonROS2CameraNode::initActions()
@@ -558,12 +1035,59 @@ void PylonROS2CameraNode::initDiagnostics()
   this->diagnostics_updater_.add("camera_availability", this, &PylonROS2CameraNode::createDiagnostics);
   this->diagnostics_updater_.add("intrinsic_calibration", this, &PylonROS2CameraNode::createCameraInfoDiagnostics);
 
-  auto diagnostics_trigger = this->create_wall_timer(2000ms, std::bind(&PylonROS2CameraNode::diagnosticsTimerCallback, this));
+  // the timer has to be kept, the diagnostics would not be updated otherwise
+  this->diagnostics_timer_ = this->create_wall_timer(2000ms, std::bind(&PylonROS2CameraNode::diagnosticsTimerCallback, this));
+}
+
+void PylonROS2CameraNode::initFramePathDiagnostics()
+{
+  // the frame path diagnostics depend on the parameters, they are only added once
+  if (this->frequency_status_)
+  {
+    return;
+  }
+
+  // the expected rate is set by startGrabbing, once the frame rate is final
+  this->frequency_status_.reset(new diagnostic_updater::FrequencyStatus(
+    diagnostic_updater::FrequencyStatusParam(&this->min_publish_frequency_,
+                                             &this->max_publish_frequency_,
+                                             this->pylon_camera_parameter_set_.diagnostics_frequency_tolerance_,
+                                             10),
+    "publish_rate"));
+  this->timestamp_status_.reset(new diagnostic_updater::TimeStampStatus(
+    diagnostic_updater::TimeStampStatusParam(-1.0, this->pylon_camera_parameter_set_.diagnostics_max_frame_age_),
+    "frame_age",
+    this->get_clock()));
+
+  this->diagnostics_updater_.add(*this->frequency_status_);
+  this->diagnostics_updater_.add(*this->timestamp_status_);
+  this->diagnostics_updater_.add("frame_path", this, &PylonROS2CameraNode::createFramePathDiagnostics);
+}
+
+PylonROS2Camera* PylonROS2CameraNode::createCamera()
+{
+  if (this->camera_factory_)
+  {
+    return this->camera_factory_();
+  }
+
+  // a camera identified by serial number, IP address or full name is opened
+  // without enumerating the devices of all transport layers
+  if (!this->pylon_camera_parameter_set_.device_serial_number_.empty() ||
+      !this->pylon_camera_parameter_set_.device_ip_address_.empty() ||
+      !this->pylon_camera_parameter_set_.device_full_name_.empty())
+  {
+    return PylonROS2Camera::createDirect(this->pylon_camera_parameter_set_.device_serial_number_,
+                                         this->pylon_camera_parameter_set_.device_ip_address_,
+                                         this->pylon_camera_parameter_set_.device_full_name_);
+  }
+
+  return PylonROS2Camera::create(this->pylon_camera_parameter_set_.deviceUserID());
 }
 
 bool PylonROS2CameraNode::initAndRegister()
 {
-  this->pylon_camera_ = PylonROS2Camera::create(this->pylon_camera_parameter_set_.deviceUserID());
+  this->pylon_camera_ = this->createCamera();
   if (this->pylon_camera_parameter_set_.deviceUserID() != "")
     RCLCPP_DEBUG_STREAM(LOGGER, "Pylon camera instance created with the following user id: " << this->pylon_camera_parameter_set_.deviceUserID());
   else
@@ -587,7 +1111,7 @@ bool PylonROS2CameraNode::initAndRegister()
     rclcpp::Rate r(0.5);
     while (rclcpp::ok() && this->pylon_camera_ == nullptr)
     {
-      this->pylon_camera_ = PylonROS2Camera::create(this->pylon_camera_parameter_set_.deviceUserID());
+      this->pylon_camera_ = this->createCamera();
       if (this->pylon_camera_ == nullptr)
       {
         RCLCPP_WARN_STREAM(LOGGER, "Failed to connect camera device with device user id: "<< this->pylon_camera_parameter_set_.deviceUserID() << ". "
@@ -628,6 +1152,13 @@ bool PylonROS2CameraNode::initAndRegister()
     return false;
   }
 
+  this->recordStartupPhase("create camera");
+
+  return this->setupCamera();
+}
+
+bool PylonROS2CameraNode::setupCamera()
+{
   if (!this->pylon_camera_->registerCameraConfiguration())
   {
     RCLCPP_ERROR_STREAM(LOGGER, "Error while registering the camera configuration to software-trigger mode!");
@@ -639,6 +1170,7 @@ bool PylonROS2CameraNode::initAndRegister()
     }
     return false;
   }
+  this->recordStartupPhase("register configuration");
 
   if (!this->pylon_camera_->openCamera())
   {
@@ -652,7 +1184,60 @@ bool PylonROS2CameraNode::initAndRegister()
     return false;
   }
 
-  if (!this->pylon_camera_->applyCamSpecificStartupSettings(this->pylon_camera_parameter_set_))
+  if (this->pylon_camera_parameter_set_.heartbeat_timeout_ > 0)
+  {
+    this->pylon_camera_->setHeartbeatTimeout(this->pylon_camera_parameter_set_.heartbeat_timeout_);
+  }
+
+  this->pylon_camera_->setFrameTracer(&this->frame_tracer_);
+
+  if (!this->pylon_camera_->isBlaze())
+  {
+    this->sensor_correction_.setDirectory(this->pylon_camera_parameter_set_.sensor_correction_dir_);
+    this->pylon_camera_->setSensorCorrection(&this->sensor_correction_);
+
+    this->tone_mapping_.configure(this->pylon_camera_parameter_set_.tone_mapping_curve_,
+                                  this->pylon_camera_parameter_set_.tone_mapping_gamma_,
+                                  this->pylon_camera_parameter_set_.tone_mapping_lut_file_);
+    this->pylon_camera_->setToneMapping(&this->tone_mapping_);
+  }
+
+  if (this->pylon_camera_parameter_set_.pylon_thread_priority_ > 0)
+  {
+    this->pylon_camera_->setInternalThreadPriority(this->pylon_camera_parameter_set_.pylon_thread_priority_);
+  }
+  this->recordStartupPhase("open camera");
+
+  // fast startup: only the features differing from the snapshot of a previous startup are written
+  this->startup_snapshot_file_ = "";
+  this->is_startup_snapshot_restored_ = false;
+  if (this->pylon_camera_parameter_set_.fast_startup_ && !this->pylon_camera_->isBlaze() &&
+      !this->pylon_camera_->deviceSerialNumber().empty())
+  {
+    std::string snapshot_dir = this->pylon_camera_parameter_set_.startup_snapshot_dir_;
+    if (snapshot_dir.empty())
+    {
+      const char* home = std::getenv("HOME");
+      snapshot_dir = std::string(home ? home : "/tmp") + "/.ros/pylon_ros2_camera";
+    }
+
+    if (createDirectories(snapshot_dir))
+    {
+      this->startup_snapshot_file_ = snapshot_dir + "/" + this->pylon_camera_->deviceSerialNumber() + "_"
+                                   + this->pylon_camera_parameter_set_.startupSettingsHash(*this) + ".pfs";
+      this->is_startup_snapshot_restored_ = this->pylon_camera_->applyStartupSnapshot(this->startup_snapshot_file_);
+    }
+    else
+    {
+      RCLCPP_WARN_STREAM(LOGGER, "Could not create the startup snapshot directory " << snapshot_dir);
+    }
+  }
+
+  if (this->is_startup_snapshot_restored_)
+  {
+    this->recordStartupPhase("restore startup snapshot");
+  }
+  else if (!this->pylon_camera_->applyCamSpecificStartupSettings(this->pylon_camera_parameter_set_))
   {
     RCLCPP_ERROR_STREAM(LOGGER, "Error while applying the user-specified startup settings " << "(e.g., mtu size for GigE, ...) to the camera!");
     this->cm_status_.status_id = pylon_ros2_camera_interfaces::msg::ComponentStatus::ERROR;
@@ -663,6 +1248,23 @@ bool PylonROS2CameraNode::initAndRegister()
     }
     return false;
   }
+  else
+  {
+    this->recordStartupPhase("apply startup settings");
+  }
+
+  // written last: loading a user set or a snapshot resets the LUT of the camera
+  if (!this->pylon_camera_->isBlaze() && this->tone_mapping_.isEnabled() && this->pylon_camera_parameter_set_.tone_mapping_on_camera_)
+  {
+    // the camera applies the curve before the 8 bit formats drop the lower bits, the host
+    // then only reduces the 12 bit formats to 8 bit
+    const std::string result = this->pylon_camera_->setLookupTable(this->tone_mapping_.cameraTable());
+    this->tone_mapping_.setAppliedOnCamera(result == "done");
+    if (result != "done")
+    {
+      RCLCPP_WARN_STREAM(LOGGER, "The tone mapping curve can't be loaded into the camera (" << result << "), it is applied by the host");
+    }
+  }
 
   return true;
 }
@@ -673,6 +1275,41 @@ bool PylonROS2CameraNode::startGrabbing()
   {
     return false;
   }
+  this->recordStartupPhase("start grabbing");
+
+  // the tracking window starts in the center of the configured roi, until a target is received
+  if (!this->pylon_camera_->isBlaze() && this->pylon_camera_parameter_set_.tracking_roi_width_ > 0)
+  {
+    const sensor_msgs::msg::RegionOfInterest startup_roi = this->pylon_camera_->currentROI();
+    sensor_msgs::msg::RegionOfInterest target_roi;
+    target_roi.width = static_cast<uint32_t>(this->pylon_camera_parameter_set_.tracking_roi_width_);
+    target_roi.height = static_cast<uint32_t>(this->pylon_camera_parameter_set_.tracking_roi_height_);
+    target_roi.x_offset = startup_roi.x_offset + (startup_roi.width > target_roi.width ? (startup_roi.width - target_roi.width) / 2 : 0);
+    target_roi.y_offset = startup_roi.y_offset + (startup_roi.height > target_roi.height ? (startup_roi.height - target_roi.height) / 2 : 0);
+    sensor_msgs::msg::RegionOfInterest reached_roi;
+    if (!this->pylon_camera_->setROI(target_roi, reached_roi))
+    {
+      RCLCPP_WARN(LOGGER, "The tracking window can't be set, the configured roi is kept");
+    }
+  }
+
+  // multiple ROI: only the zones are read out, the compact frame is split again before publishing
+  if (!this->pylon_camera_->isBlaze() &&
+      (!this->pylon_camera_parameter_set_.multi_roi_rows_.empty() || !this->pylon_camera_parameter_set_.multi_roi_columns_.empty()))
+  {
+    if (this->pylon_camera_->setMultipleROI(toROIZones(this->pylon_camera_parameter_set_.multi_roi_rows_),
+                                            toROIZones(this->pylon_camera_parameter_set_.multi_roi_columns_),
+                                            this->multi_roi_rows_, this->multi_roi_columns_))
+    {
+      RCLCPP_INFO_STREAM(LOGGER, "Multiple ROI of " << this->multi_roi_rows_.size() << " row zone(s) and "
+                         << this->multi_roi_columns_.size() << " column zone(s), frame of "
+                         << this->pylon_camera_->imageCols() << "x" << this->pylon_camera_->imageRows());
+    }
+    else
+    {
+      RCLCPP_WARN(LOGGER, "The multiple ROI can't be set, the full frame is read out");
+    }
+  }
 
   size_t num_user_outputs = this->pylon_camera_->numUserOutputs();
   this->set_user_output_srvs_.resize(2 * num_user_outputs);
@@ -705,12 +1342,12 @@ bool PylonROS2CameraNode::startGrabbing()
   this->img_raw_msg_.header.frame_id = this->pylon_camera_parameter_set_.cameraFrame();
   // Encoding of pixels -- channel meaning, ordering, size
   // taken from the list of strings in include/sensor_msgs/image_encodings.h
-  this->img_raw_msg_.encoding = this->pylon_camera_->currentROSEncoding();
+  this->img_raw_msg_.encoding = this->pylon_camera_->outputROSEncoding();
   this->img_raw_msg_.height = this->pylon_camera_->imageRows();
   this->img_raw_msg_.width = this->pylon_camera_->imageCols();
-  // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
+  // step = full row length in bytes, img_size = (step * rows), outputPixelDepth
   // already contains the number of channels
-  this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->imagePixelDepth();
+  this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->outputPixelDepth();
 
   if (!this->camera_info_manager_->setCameraName(this->pylon_camera_->deviceUserID()))
   { 
@@ -726,7 +1363,7 @@ bool PylonROS2CameraNode::startGrabbing()
   // Initial setting of the camera info
   sensor_msgs::msg::CameraInfo initial_cam_info;
   this->setupInitialCameraInfo(initial_cam_info);
-  this->camera_info_manager_->setCameraInfo(initial_cam_info);
+  this->updateCameraInfo(initial_cam_info);
 
   if (!this->pylon_camera_->isBlaze())
   {
@@ -750,7 +1387,7 @@ bool PylonROS2CameraNode::startGrabbing()
         // set the correct tf frame_id
         sensor_msgs::msg::CameraInfo cam_info = this->camera_info_manager_->getCameraInfo();
         cam_info.header.frame_id = this->img_raw_msg_.header.frame_id;
-        this->camera_info_manager_->setCameraInfo(cam_info);
+        this->updateCameraInfo(cam_info);
       }
       else
       { 
@@ -770,7 +1407,7 @@ bool PylonROS2CameraNode::startGrabbing()
         std::bind(&PylonROS2CameraNode::handleGrabBlazeDataActionGoalAccepted, this, _1));
   }
 
-  if (!this->pylon_camera_->isBlaze() && this->pylon_camera_parameter_set_.binning_x_given_)
+  if (!this->pylon_camera_->isBlaze() && !this->is_startup_snapshot_restored_ && this->pylon_camera_parameter_set_.binning_x_given_)
   {   
     size_t reached_binning_x;
     this->setBinningX(this->pylon_camera_parameter_set_.binning_x_, reached_binning_x);
@@ -780,7 +1417,7 @@ bool PylonROS2CameraNode::startGrabbing()
             << "be adapted, so that the binning_x value in this msg remains 1");
   }
 
-  if (!this->pylon_camera_->isBlaze() && this->pylon_camera_parameter_set_.binning_y_given_)
+  if (!this->pylon_camera_->isBlaze() && !this->is_startup_snapshot_restored_ && this->pylon_camera_parameter_set_.binning_y_given_)
   {   
     size_t reached_binning_y;
     this->setBinningY(this->pylon_camera_parameter_set_.binning_y_, reached_binning_y);
@@ -790,7 +1427,7 @@ bool PylonROS2CameraNode::startGrabbing()
             << "be adapted, so that the binning_y value in this msg remains 1");
   }
 
-  if (this->pylon_camera_parameter_set_.exposure_given_)
+  if (!this->is_startup_snapshot_restored_ && this->pylon_camera_parameter_set_.exposure_given_)
   {   
     float reached_exposure;
     this->setExposure(this->pylon_camera_parameter_set_.exposure_, reached_exposure);
@@ -799,7 +1436,7 @@ bool PylonROS2CameraNode::startGrabbing()
             << reached_exposure);
   }
   
-  if (!this->pylon_camera_->isBlaze() && this->pylon_camera_parameter_set_.gain_given_)
+  if (!this->pylon_camera_->isBlaze() && !this->is_startup_snapshot_restored_ && this->pylon_camera_parameter_set_.gain_given_)
   {   
     float reached_gain;
     this->setGain(this->pylon_camera_parameter_set_.gain_, reached_gain);
@@ -808,7 +1445,7 @@ bool PylonROS2CameraNode::startGrabbing()
             << reached_gain);
   }
 
-  if (!this->pylon_camera_->isBlaze() && pylon_camera_parameter_set_.gamma_given_)
+  if (!this->pylon_camera_->isBlaze() && !this->is_startup_snapshot_restored_ && pylon_camera_parameter_set_.gamma_given_)
   {   
     float reached_gamma;
     this->setGamma(pylon_camera_parameter_set_.gamma_, reached_gamma);
@@ -875,12 +1512,21 @@ bool PylonROS2CameraNode::startGrabbing()
     this->pylon_camera_parameter_set_.setFrameRate(*this, this->pylon_camera_->maxPossibleFramerate());
     RCLCPP_INFO(LOGGER, "Max possible framerate is %.2f Hz", this->pylon_camera_->maxPossibleFramerate());
   }
+  // the expected publish rate follows the final frame rate
+  this->min_publish_frequency_ = this->frameRate();
+  this->max_publish_frequency_ = this->frameRate();
+  this->recordStartupPhase("apply image settings");
   
   return true;
 }
 
 void PylonROS2CameraNode::spin()
 {
+  // only applied when the executor runs the timer on another thread than the last time
+  this->acquisition_scheduling_->apply(this->pylon_camera_parameter_set_.acquisition_cpus_,
+                                       this->pylon_camera_parameter_set_.acquisition_priority_,
+                                       this->pylon_camera_parameter_set_.acquisition_nice_);
+
   if (this->camera_info_manager_->isCalibrated())
   {
     RCLCPP_INFO_ONCE(LOGGER, "Camera is calibrated");
@@ -890,17 +1536,44 @@ void PylonROS2CameraNode::spin()
     RCLCPP_INFO_ONCE(LOGGER, "Camera not calibrated");
   }
 
-  if (this->pylon_camera_->isCamRemoved())
+  if (this->is_waiting_for_camera_ || this->pylon_camera_->isCamRemoved())
   {
-    RCLCPP_ERROR(LOGGER, "Pylon camera has been removed, trying to reset");
-    
-    this->cm_status_.status_id = pylon_ros2_camera_interfaces::msg::ComponentStatus::ERROR;;
-    this->cm_status_.status_msg = "Pylon camera has been removed, trying to reset";
-      
-    if (this->pylon_camera_parameter_set_.enable_status_publisher_)
+    if (!this->is_waiting_for_camera_)
     {
-      this->component_status_pub_->publish(this->cm_status_);
+      RCLCPP_ERROR(LOGGER, "Pylon camera has been removed, trying to reconnect");
+
+      this->cm_status_.status_id = pylon_ros2_camera_interfaces::msg::ComponentStatus::ERROR;;
+      this->cm_status_.status_msg = "Pylon camera has been removed, trying to reconnect";
+
+      if (this->pylon_camera_parameter_set_.enable_status_publisher_)
+      {
+        this->component_status_pub_->publish(this->cm_status_);
+      }
+
+      // the removed device is released, but the camera instance is kept until the
+      // new one exists: it holds the cached device identity and the pylon runtime
+      this->pylon_camera_->releaseDevice();
+      this->is_waiting_for_camera_ = true;
+      this->reconnect_start_time_ = std::chrono::steady_clock::now();
+      this->last_reconnect_attempt_time_ = std::chrono::steady_clock::time_point();
+    }
+
+    // one attempt per tick at most, the executor keeps serving the other callbacks in between
+    if (this->reconnect())
+    {
+      return;
+    }
+
+    // a camera found again but failing its setup falls back right away
+    const int timeout = this->pylon_camera_parameter_set_.reconnect_timeout_;
+    if (this->is_waiting_for_camera_ &&
+        (timeout <= 0 || std::chrono::steady_clock::now() - this->reconnect_start_time_ < std::chrono::milliseconds(timeout)))
+    {
+      return;
     }
+
+    RCLCPP_WARN(LOGGER, "Fast reconnect failed, falling back to a complete reinitialization");
+    this->is_waiting_for_camera_ = false;
       
     if (this->pylon_camera_)
     {
@@ -912,9 +1585,8 @@ void PylonROS2CameraNode::spin()
     // Services are shutdown in the ROS 1 pylon version at this level
     this->set_user_output_srvs_.clear();
 
-    rclcpp::Rate r(0.5);
-    r.sleep();
-
+    // no extra wait: the fallback is only reached once reconnect_timeout is over,
+    // the attempts before it being spaced by reconnect_poll_interval
     this->init();
     
     return;
@@ -922,56 +1594,147 @@ void PylonROS2CameraNode::spin()
 
   if (!this->pylon_camera_->isBlaze())
   {
-    if (!this->isSleeping() && (this->img_raw_pub_.getNumSubscribers() || this->getNumSubscribersRectImagePub()))
+    if (!this->isSleeping() && (this->getNumSubscribersRawImagePub() || this->getNumSubscribersRectImagePub() || this->isRegistrationConsumed() ||
+                                this->isEncodedImageSubscribed() || this->isVideoSubscribed() || this->shm_writer_.isStarted() ||
+          this->isZoneSubscribed()))
     {
-      if (this->img_raw_pub_.getNumSubscribers() || this->getNumSubscribersRectImagePub())
+      if (this->getNumSubscribersRawImagePub() || this->getNumSubscribersRectImagePub() || this->isRegistrationConsumed() ||
+          this->isEncodedImageSubscribed() || this->isVideoSubscribed() || this->shm_writer_.isStarted() ||
+          this->isZoneSubscribed())
       {
-        if (!this->grabImage())
+        // a frame which is not published is dropped by the next begin
+        this->frame_tracer_.begin();
+        const auto grab_start = std::chrono::steady_clock::now();
+        const bool grabbed = this->grabImage();
+        this->updateStreamWatchdog(grabbed);
+        if (!grabbed)
         {
           return;
         }
+        addStageTime(this->grab_statistics_, grab_start);
+      }
+
+      if (this->isRegistrationConsumed())
+      {
+        // one copy into the channel, instead of the whole stream crossing a process boundary
+        this->registration_channel_->post(this->img_raw_msg_, this->cam_info_msg_);
+      }
+
+      if (this->shm_writer_.isStarted())
+      {
+        // the readers are not waited for, a slow reader loses frames
+        this->shm_writer_.write(this->img_raw_msg_, this->pylon_camera_->frameCounter());
+      }
+
+      if (this->isEncodedImageSubscribed())
+      {
+        // copied into a free slot, the encoding does not hold up the acquisition
+        this->image_encoder_pool_.post(this->img_raw_msg_);
+      }
+
+      if (this->isVideoSubscribed())
+      {
+        // only the latest frame waits for the encoder
+        this->video_encoder_.post(this->img_raw_msg_);
+      }
+
+      if (this->isZoneSubscribed())
+      {
+        this->publishZones();
       }
 
       if (this->img_raw_pub_.getNumSubscribers() > 0)
       {
-        // get actual cam_info-object in every frame, because it might have
-        // changed due to a 'set_camera_info'-service call
-        sensor_msgs::msg::CameraInfo cam_info = this->camera_info_manager_->getCameraInfo();
-        cam_info.header.stamp = this->img_raw_msg_.header.stamp;
+        const auto publish_start = std::chrono::steady_clock::now();
+        // the camera info is refreshed whenever it is written
+        this->cam_info_msg_.header.stamp = this->img_raw_msg_.header.stamp;
         // publish via image_transport
-        this->img_raw_pub_.publish(this->img_raw_msg_, cam_info);
+        this->img_raw_pub_.publish(this->img_raw_msg_, this->cam_info_msg_);
+        addStageTime(this->publish_statistics_, publish_start);
       }
 
       // this->getNumSubscribersRectImagePub() involves that this->camera_info_manager_->isCalibrated() == true
       if (this->getNumSubscribersRectImagePub() > 0)
       {
+        const auto rectification_start = std::chrono::steady_clock::now();
         this->cv_bridge_img_rect_->header.stamp = this->img_raw_msg_.header.stamp;
         assert(this->pinhole_model_->initialized());
 
-        const int bit_depth = sensor_msgs::image_encodings::bitDepth(img_raw_msg_.encoding);
-        std::string rect_encoding = img_raw_msg_.encoding;
-        if (bit_depth == 8 && sensor_msgs::image_encodings::isBayer(rect_encoding))
-        {
-          rect_encoding = "bgr8";
-        }
-        else if (bit_depth == 16 && sensor_msgs::image_encodings::isBayer(rect_encoding))
-        {
-          rect_encoding ="bgr16";
-        }
-        this->cv_bridge_img_rect_->encoding = rect_encoding;
-        
-        cv_bridge::CvImagePtr cv_img_raw = cv_bridge::toCvCopy(this->img_raw_msg_, rect_encoding);
-        if (cv_img_raw == nullptr)
+        this->frame_tracer_.mark(TS_RECTIFICATION_START);
+        if (!this->updateRectificationCache())
         {
           RCLCPP_ERROR(LOGGER, "Failed to initialize rectified image, not publishing it");
         }
         else
         {
-          this->pinhole_model_->fromCameraInfo(this->camera_info_manager_->getCameraInfo());
-          this->pinhole_model_->rectifyImage(cv_img_raw->image, this->cv_bridge_img_rect_->image);
-          this->img_rect_pub_->publish(this->cv_bridge_img_rect_->toImageMsg());
+          // the raw image is wrapped, not copied
+          const cv::Mat raw_img(this->img_raw_msg_.height, this->img_raw_msg_.width, this->rect_source_cv_type_,
+                                this->img_raw_msg_.data.data(), this->img_raw_msg_.step);
+          if (this->rect_bayer_code_ >= 0)
+          {
+            cv::cvtColor(raw_img, this->debayered_img_, this->rect_bayer_code_);
+          }
+          const cv::Mat& rect_source = (this->rect_bayer_code_ >= 0) ? this->debayered_img_ : raw_img;
+
+          if (this->img_rect_cv_pub_)
+          {
+            // rectified into pooled memory, handed over to the subscribers without conversion
+            std::shared_ptr<std::vector<uint8_t>> buffer = this->acquireImageBuffer(rect_source.total() * rect_source.elemSize());
+            if (buffer)
+            {
+              // the image object is recycled by CvMatImage once the subscribers delete it
+              auto image = std::make_unique<CvMatImage>();
+              image->header = this->cv_bridge_img_rect_->header;
+              image->encoding = this->cv_bridge_img_rect_->encoding;
+              image->image = cv::Mat(rect_source.rows, rect_source.cols, rect_source.type(), buffer->data());
+              image->memory = buffer;
+              this->pinhole_model_->rectifyImage(rect_source, image->image);
+              this->frame_tracer_.mark(TS_RECTIFICATION_END);
+              this->img_rect_cv_pub_->publish(std::move(image));
+            }
+          }
+          else
+          {
+            this->pinhole_model_->rectifyImage(rect_source, this->cv_bridge_img_rect_->image);
+            this->frame_tracer_.mark(TS_RECTIFICATION_END);
+            // the message buffer keeps its capacity from frame to frame
+            this->cv_bridge_img_rect_->toImageMsg(this->img_rect_msg_);
+            this->img_rect_pub_->publish(this->img_rect_msg_);
+          }
+        }
+        addStageTime(this->rectification_statistics_, rectification_start);
+      }
+
+      // last user of the frame: its buffer is handed over to the subscribers, and replaced by a pooled one for the next grab
+      if (this->img_raw_cv_pub_ && this->img_raw_cv_pub_->get_subscription_count() > 0)
+      {
+        const auto publish_start = std::chrono::steady_clock::now();
+        std::shared_ptr<std::vector<uint8_t>> buffer = this->acquireImageBuffer(this->img_raw_msg_.data.size());
+        if (buffer)
+        {
+          buffer->swap(this->img_raw_msg_.data);
+
+          // the image object is recycled by CvMatImage once the subscribers delete it
+          auto image = std::make_unique<CvMatImage>();
+          image->header = this->img_raw_msg_.header;
+          image->encoding = this->img_raw_msg_.encoding;
+          image->image = cv::Mat(this->img_raw_msg_.height, this->img_raw_msg_.width, cv_bridge::getCvType(this->img_raw_msg_.encoding),
+                                 buffer->data(), this->img_raw_msg_.step);
+          image->memory = buffer;
+          this->img_raw_cv_pub_->publish(std::move(image));
+
+          // the camera info is refreshed whenever it is written
+          this->cam_info_msg_.header.stamp = this->img_raw_msg_.header.stamp;
+          this->cam_info_pub_->publish(this->cam_info_msg_);
         }
+        addStageTime(this->publish_statistics_, publish_start);
       }
+
+      this->frame_tracer_.mark(TS_PUBLISHED);
+      this->frame_tracer_.commit(this->pylon_camera_->frameCounter());
+
+      this->frequency_status_->tick();
+      this->timestamp_status_->tick(this->frame_receive_time_);
     }
   }
   else
@@ -980,49 +1743,234 @@ void PylonROS2CameraNode::spin()
                                 this->blaze_intensity_pub_->get_subscription_count() ||
                                 this->blaze_depth_map_pub_->get_subscription_count() ||
                                 this->blaze_depth_map_color_pub_->get_subscription_count() ||
-                                this->blaze_cam_info_pub_->get_subscription_count()))
+                                this->blaze_cam_info_pub_->get_subscription_count() ||
+                                this->isDepthImageSubscribed() ||
+                                this->isBlazeCompressedSubscribed()))
     {
       this->pylon_camera_->getInitialCameraInfo(this->blaze_cam_info_msg_);
 
-      if (!this->grabImage())
+      this->frame_tracer_.begin();
+      const auto grab_start = std::chrono::steady_clock::now();
+      const bool grabbed = this->grabImage();
+      this->updateStreamWatchdog(grabbed);
+      if (!grabbed)
       {
         return;
       }
+      addStageTime(this->grab_statistics_, grab_start);
 
       RCLCPP_DEBUG_STREAM_ONCE(LOGGER, "Camera frame from parameter server: " << this->pylon_camera_parameter_set_.cameraFrame());
       
-      this->blaze_cloud_msg_.header.frame_id = cameraFrame();
+      this->blaze_cloud_msg_.header.frame_id = blazeCloudFrame();
       this->intensity_map_msg_.header.frame_id = cameraFrame();
       this->depth_map_msg_.header.frame_id = cameraFrame();
       this->depth_map_color_msg_.header.frame_id = cameraFrame();
       this->confidence_map_msg_.header.frame_id = cameraFrame();
       this->blaze_cam_info_msg_.header.frame_id = cameraFrame();
+      this->depth_image_msg_.header.frame_id = cameraFrame();
       
+      const auto publish_start = std::chrono::steady_clock::now();
       this->blaze_cloud_pub_->publish(this->blaze_cloud_msg_);
       this->blaze_intensity_pub_->publish(this->intensity_map_msg_);
       this->blaze_depth_map_pub_->publish(this->depth_map_msg_);
       this->blaze_depth_map_color_pub_->publish(this->depth_map_color_msg_);
       this->blaze_confidence_pub_->publish(this->confidence_map_msg_);
       this->blaze_cam_info_pub_->publish(this->blaze_cam_info_msg_);
+      // only if the depth image has been computed for this frame
+      if (this->is_depth_image_computed_)
+      {
+        this->blaze_depth_image_pub_->publish(this->depth_image_msg_);
+        this->blaze_depth_cam_info_pub_->publish(this->blaze_cam_info_msg_);
+      }
+      if (this->isBlazeCompressedSubscribed())
+      {
+        // only copied here, the compressed frame is published by a worker
+        this->blaze_compressor_.post(this->blaze_cloud_msg_, this->intensity_map_msg_, this->confidence_map_msg_);
+      }
+      addStageTime(this->publish_statistics_, publish_start);
+
+      this->frame_tracer_.mark(TS_PUBLISHED);
+      this->frame_tracer_.commit(this->pylon_camera_->frameCounter());
+
+      this->frequency_status_->tick();
+      this->timestamp_status_->tick(this->frame_receive_time_);
+    }
+  }
+
+  // Check if the image encoding changed , then save the new image encoding and restart the image grabbing to fix the ros sensor message type issue.
+  if (this->pylon_camera_parameter_set_.imageEncoding() != this->pylon_camera_->currentROSEncoding()) 
+  {
+    this->pylon_camera_parameter_set_.setimageEncodingParam(*this, this->pylon_camera_->currentROSEncoding());
+    this->grabbingStopping();
+    this->grabbingStarting();
+  }
+  
+  if (this->pylon_camera_parameter_set_.enable_status_publisher_)
+  {
+    this->component_status_pub_->publish(this->cm_status_);
+  }
+
+  if (this->pylon_camera_parameter_set_.enable_current_params_publisher_)
+  {
+    this->publishCurrentParams();
+  }
+}
+
+bool PylonROS2CameraNode::reconnect()
+{
+  const auto now = std::chrono::steady_clock::now();
+  if (now - this->last_reconnect_attempt_time_ <
+      std::chrono::milliseconds(std::max(1, this->pylon_camera_parameter_set_.reconnect_poll_interval_)))
+  {
+    return false;
+  }
+  this->last_reconnect_attempt_time_ = now;
+
+  std::lock_guard<std::recursive_mutex> lock(this->grab_mutex_);
+
+  PylonROS2Camera* new_camera = PylonROS2Camera::recreate(*this->pylon_camera_);
+  if (new_camera == nullptr)
+  {
+    RCLCPP_WARN_STREAM_THROTTLE(LOGGER, *this->get_clock(), 15000, "Camera device with serial number "
+                                << this->pylon_camera_->deviceSerialNumber() << " not available yet. Keep waiting and trying...");
+    return false;
+  }
+
+  this->is_waiting_for_camera_ = false;
+  this->startup_phases_.clear();
+  this->startup_phase_start_ = now;
+
+  delete this->pylon_camera_;
+  this->pylon_camera_ = new_camera;
+  this->recordStartupPhase("reopen camera");
+
+  // the camera is reconfigured with the parameter set already in use,
+  // publishers and services are kept
+  if (!this->setupCamera() || !this->startGrabbing())
+  {
+    return false;
+  }
+
+  RCLCPP_INFO(LOGGER, "Camera reconnected");
+  this->logStartupTiming();
+
+  this->is_reconnecting_ = true;
+
+  this->cm_status_.status_id = pylon_ros2_camera_interfaces::msg::ComponentStatus::RUNNING;
+  this->cm_status_.status_msg = "running";
+  if (this->pylon_camera_parameter_set_.enable_status_publisher_)
+  {
+    this->component_status_pub_->publish(this->cm_status_);
+  }
+
+  return true;
+}
+
+void PylonROS2CameraNode::updateStreamWatchdog(const bool& frame_received)
+{
+  const int max_failures = this->pylon_camera_parameter_set_.watchdog_max_failures_;
+  const int timeout = this->pylon_camera_parameter_set_.watchdog_timeout_;
+  if (max_failures <= 0 && timeout <= 0)
+  {
+    return;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+
+  if (frame_received)
+  {
+    if (this->watchdog_recovery_step_ > 0)
+    {
+      RCLCPP_INFO_STREAM(LOGGER, "Stream watchdog: stream recovered after recovery step " << this->watchdog_recovery_step_ << ", "
+                         << std::chrono::duration_cast<std::chrono::milliseconds>(now - this->stream_stall_start_time_).count()
+                         << " ms after the stall detection");
+
+      this->cm_status_.status_id = pylon_ros2_camera_interfaces::msg::ComponentStatus::RUNNING;
+      this->cm_status_.status_msg = "running";
+      if (this->pylon_camera_parameter_set_.enable_status_publisher_)
+      {
+        this->component_status_pub_->publish(this->cm_status_);
+      }
     }
+
+    this->grab_failures_ = 0;
+    this->watchdog_recovery_step_ = 0;
+    this->last_frame_time_ = now;
+    return;
+  }
+
+  if (this->grab_failures_ == 0 && this->watchdog_recovery_step_ == 0)
+  {
+    // the window without frames starts with the first failure after a good frame
+    this->last_frame_time_ = now;
+  }
+  this->grab_failures_++;
+
+  const bool too_many_failures = max_failures > 0 && this->grab_failures_ >= max_failures;
+  const bool timed_out = timeout > 0 && now - this->last_frame_time_ >= std::chrono::milliseconds(timeout);
+  if (!too_many_failures && !timed_out)
+  {
+    return;
+  }
+
+  if (this->watchdog_recovery_step_ == 0)
+  {
+    this->stream_stall_start_time_ = now;
+    RCLCPP_WARN_STREAM(LOGGER, "Stream watchdog: stream stalled (" << this->grab_failures_ << " consecutive failed grabs, "
+                       << std::chrono::duration_cast<std::chrono::milliseconds>(now - this->last_frame_time_).count()
+                       << " ms without frame)");
+  }
+
+  this->recoverStream();
+
+  // the next step is taken only if the stream is still stalled after a full window
+  this->grab_failures_ = 0;
+  this->last_frame_time_ = std::chrono::steady_clock::now();
+}
+
+void PylonROS2CameraNode::recoverStream()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->grab_mutex_);
+
+  this->watchdog_recovery_step_++;
+
+  std::string step_name;
+  bool success = false;
+  const auto step_start = std::chrono::steady_clock::now();
+
+  switch (this->watchdog_recovery_step_)
+  {
+    case SRS_RESTART_GRABBING:
+      step_name = "restart grabbing";
+      success = this->pylon_camera_->restartStream(SRS_RESTART_GRABBING);
+      break;
+    case SRS_REOPEN_DEVICE:
+      step_name = "reopen device";
+      success = this->pylon_camera_->restartStream(SRS_REOPEN_DEVICE);
+      break;
+    default:
+      // the device reboots and is reported as removed, the reconnection takes over from here
+      step_name = "reset device";
+      success = this->pylon_camera_->triggerDeviceReset() == "done";
+      this->watchdog_recovery_step_ = 0;
+      break;
   }
 
-  // Check if the image encoding changed , then save the new image encoding and restart the image grabbing to fix the ros sensor message type issue.
-  if (this->pylon_camera_parameter_set_.imageEncoding() != this->pylon_camera_->currentROSEncoding()) 
+  const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - step_start);
+  if (success)
   {
-    this->pylon_camera_parameter_set_.setimageEncodingParam(*this, this->pylon_camera_->currentROSEncoding());
-    this->grabbingStopping();
-    this->grabbingStarting();
+    RCLCPP_WARN_STREAM(LOGGER, "Stream watchdog: recovery step '" << step_name << "' done in " << duration.count() << " ms");
   }
-  
-  if (this->pylon_camera_parameter_set_.enable_status_publisher_)
+  else
   {
-    this->component_status_pub_->publish(this->cm_status_);
+    RCLCPP_ERROR_STREAM(LOGGER, "Stream watchdog: recovery step '" << step_name << "' failed after " << duration.count() << " ms");
   }
 
-  if (this->pylon_camera_parameter_set_.enable_current_params_publisher_)
+  this->cm_status_.status_id = pylon_ros2_camera_interfaces::msg::ComponentStatus::ERROR;
+  this->cm_status_.status_msg = "Image stream stalled, recovery step '" + step_name + "' applied";
+  if (this->pylon_camera_parameter_set_.enable_status_publisher_)
   {
-    this->publishCurrentParams();
+    this->component_status_pub_->publish(this->cm_status_);
   }
 }
 
@@ -1036,25 +1984,69 @@ bool PylonROS2CameraNode::grabImage()
   {
     // Store current time before the image is transmitted for a more accurate grab time estimation.
     // If chunk timestamp is enabled, grab will overwrite it with the acquisition timestamp.
+    if (this->tracking_roi_sub_)
+    {
+      // the frames already exposed keep their offsets, the move shows up some frames later
+      this->applyTrackingROI();
+    }
+
     auto stamp = rclcpp::Node::now();
     if (!this->pylon_camera_->grab(this->img_raw_msg_.data, stamp))
     {
       return false;
     }
     this->img_raw_msg_.header.stamp = stamp;
+    // the stamp may be on the camera clock, the age of the frame is measured from its reception
+    this->frame_receive_time_ = rclcpp::Node::now();
+
+    if (this->tracking_roi_sub_)
+    {
+      // each frame is published with the offsets it was read out with
+      const sensor_msgs::msg::RegionOfInterest previous_roi = this->cam_info_msg_.roi;
+      this->cam_info_msg_.roi.x_offset = static_cast<uint32_t>(this->pylon_camera_->frameOffsetX());
+      this->cam_info_msg_.roi.y_offset = static_cast<uint32_t>(this->pylon_camera_->frameOffsetY());
+      this->cam_info_msg_.roi.width = this->img_raw_msg_.width;
+      this->cam_info_msg_.roi.height = this->img_raw_msg_.height;
+      if (this->pinhole_model_ && this->cam_info_msg_.roi != previous_roi)
+      {
+        // the rectification of the window follows it, only the maps of the new ROI are recomputed
+        this->pinhole_model_->fromCameraInfo(this->cam_info_msg_);
+      }
+    }
+
+    const uint64_t dropped_frames = this->pylon_camera_->droppedFrames();
+    if (dropped_frames > this->reported_dropped_frames_)
+    {
+      RCLCPP_WARN_STREAM(LOGGER, dropped_frames - this->reported_dropped_frames_ << " frame(s) dropped according to the chunk frame counter ("
+                         << dropped_frames << " in total)");
+    }
+    // the counting restarts with a new camera instance
+    this->reported_dropped_frames_ = dropped_frames;
   }
   else
   {
     auto grab_time = rclcpp::Node::now();
-    if (!this->pylon_camera_->grabBlaze(this->blaze_cloud_msg_, 
-                                        this->intensity_map_msg_, 
-                                        this->depth_map_msg_, 
-                                        this->depth_map_color_msg_, 
-                                        this->confidence_map_msg_))
+    // the metric depth image is computed in the same pass as the other data, if it is subscribed
+    const bool is_depth_image_requested = this->isDepthImageSubscribed();
+    this->is_depth_image_computed_ = false;
+    const bool grabbed = is_depth_image_requested ?
+                         this->pylon_camera_->grabBlaze(this->blaze_cloud_msg_, 
+                                                        this->intensity_map_msg_, 
+                                                        this->depth_map_msg_, 
+                                                        this->depth_map_color_msg_, 
+                                                        this->confidence_map_msg_,
+                                                        this->depth_image_msg_) :
+                         this->pylon_camera_->grabBlaze(this->blaze_cloud_msg_, 
+                                                        this->intensity_map_msg_, 
+                                                        this->depth_map_msg_, 
+                                                        this->depth_map_color_msg_, 
+                                                        this->confidence_map_msg_);
+    if (!grabbed)
     {
      
       return false;
     }
+    this->frame_receive_time_ = rclcpp::Node::now();
 
     // acquisition time
     this->blaze_cloud_msg_.header.stamp = grab_time;
@@ -1062,9 +2054,22 @@ bool PylonROS2CameraNode::grabImage()
     this->depth_map_msg_.header.stamp = grab_time;
     this->depth_map_color_msg_.header.stamp = grab_time;
     this->confidence_map_msg_.header.stamp = grab_time;
+    if (is_depth_image_requested)
+    {
+      this->depth_image_msg_.header.stamp = grab_time;
+      this->is_depth_image_computed_ = true;
+    }
 
     this->blaze_cam_info_msg_.header.stamp = grab_time;
   }
+
+  if (this->is_reconnecting_)
+  {
+    this->is_reconnecting_ = false;
+    RCLCPP_INFO_STREAM(LOGGER, "First frame after the camera removal grabbed after "
+                       << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - this->reconnect_start_time_).count()
+                       << " ms");
+  }
   
   return true;
 }
@@ -1450,12 +2455,12 @@ bool PylonROS2CameraNode::setROI(const sensor_msgs::msg::RegionOfInterest target
         RCLCPP_ERROR_STREAM(LOGGER, "Error in setROI(): Unable to set target roi before timeout");
         sensor_msgs::msg::CameraInfo cam_info = this->camera_info_manager_->getCameraInfo();
         cam_info.roi = this->pylon_camera_->currentROI();
-        this->camera_info_manager_->setCameraInfo(cam_info);
+        this->updateCameraInfo(cam_info);
         this->img_raw_msg_.width = this->pylon_camera_->imageCols();
         this->img_raw_msg_.height = this->pylon_camera_->imageRows();
-        // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
+        // step = full row length in bytes, img_size = (step * rows), outputPixelDepth
         // already contains the number of channels
-        this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->imagePixelDepth();
+        this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->outputPixelDepth();
         return false;
       }
       r.sleep();
@@ -1464,12 +2469,12 @@ bool PylonROS2CameraNode::setROI(const sensor_msgs::msg::RegionOfInterest target
 
   sensor_msgs::msg::CameraInfo cam_info = this->camera_info_manager_->getCameraInfo();
   cam_info.roi = this->pylon_camera_->currentROI();
-  this->camera_info_manager_->setCameraInfo(cam_info);
+  this->updateCameraInfo(cam_info);
   this->img_raw_msg_.height = this->pylon_camera_->imageRows();
   this->img_raw_msg_.width = this->pylon_camera_->imageCols();
-  // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
+  // step = full row length in bytes, img_size = (step * rows), outputPixelDepth
   // already contains the number of channels
-  this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->imagePixelDepth();
+  this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->outputPixelDepth();
   this->setupSamplingIndices(this->sampling_indices_,
                              this->pylon_camera_->imageRows(),
                              this->pylon_camera_->imageCols(),
@@ -1500,11 +2505,11 @@ bool PylonROS2CameraNode::setBinningX(const size_t& target_binning_x,
                 << "binning_x factor before timeout");
         sensor_msgs::msg::CameraInfo cam_info = this->camera_info_manager_->getCameraInfo();
         cam_info.binning_x = this->pylon_camera_->currentBinningX();
-        this->camera_info_manager_->setCameraInfo(cam_info);
+        this->updateCameraInfo(cam_info);
         this->img_raw_msg_.width = this->pylon_camera_->imageCols();
-        // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
+        // step = full row length in bytes, img_size = (step * rows), outputPixelDepth
         // already contains the number of channels
-        this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->imagePixelDepth();
+        this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->outputPixelDepth();
         return false;
       }
 
@@ -1514,11 +2519,11 @@ bool PylonROS2CameraNode::setBinningX(const size_t& target_binning_x,
   
   sensor_msgs::msg::CameraInfo cam_info = this->camera_info_manager_->getCameraInfo();
   cam_info.binning_x = this->pylon_camera_->currentBinningX();
-  this->camera_info_manager_->setCameraInfo(cam_info);
+  this->updateCameraInfo(cam_info);
   this->img_raw_msg_.width = this->pylon_camera_->imageCols();
-  // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
+  // step = full row length in bytes, img_size = (step * rows), outputPixelDepth
   // already contains the number of channels
-  this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->imagePixelDepth();
+  this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->outputPixelDepth();
   this->setupSamplingIndices(this->sampling_indices_,
                              this->pylon_camera_->imageRows(),
                              this->pylon_camera_->imageCols(),
@@ -1548,11 +2553,11 @@ bool PylonROS2CameraNode::setBinningY(const size_t& target_binning_y,
                 << "binning_y factor before timeout");
         sensor_msgs::msg::CameraInfo cam_info = this->camera_info_manager_->getCameraInfo();
         cam_info.binning_y = this->pylon_camera_->currentBinningY();
-        this->camera_info_manager_->setCameraInfo(cam_info);
+        this->updateCameraInfo(cam_info);
         this->img_raw_msg_.height = this->pylon_camera_->imageRows();
-        // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
+        // step = full row length in bytes, img_size = (step * rows), outputPixelDepth
         // already contains the number of channels
-        this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->imagePixelDepth();
+        this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->outputPixelDepth();
         return false;
       }
       r.sleep();
@@ -1561,11 +2566,11 @@ bool PylonROS2CameraNode::setBinningY(const size_t& target_binning_y,
 
   sensor_msgs::msg::CameraInfo cam_info = this->camera_info_manager_->getCameraInfo();
   cam_info.binning_y = this->pylon_camera_->currentBinningY();
-  this->camera_info_manager_->setCameraInfo(cam_info);
+  this->updateCameraInfo(cam_info);
   this->img_raw_msg_.height = this->pylon_camera_->imageRows();
-  // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
+  // step = full row length in bytes, img_size = (step * rows), outputPixelDepth
   // already contains the number of channels
-  this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->imagePixelDepth();
+  this->img_raw_msg_.step = this->img_raw_msg_.width * this->pylon_camera_->outputPixelDepth();
   this->setupSamplingIndices(this->sampling_indices_,
                              this->pylon_camera_->imageRows(),
                              this->pylon_camera_->imageCols(),
@@ -2177,7 +3182,76 @@ std::string PylonROS2CameraNode::gammaEnable(const int& enable)
 
 uint32_t PylonROS2CameraNode::getNumSubscribersRectImagePub() const
 {
-  return this->camera_info_manager_->isCalibrated() ? this->img_rect_pub_->getNumSubscribers() : 0;
+  if (!this->camera_info_manager_->isCalibrated())
+  {
+    return 0;
+  }
+  return this->img_rect_cv_pub_ ? this->img_rect_cv_pub_->get_subscription_count() : this->img_rect_pub_->getNumSubscribers();
+}
+
+uint32_t PylonROS2CameraNode::getNumSubscribersRawImagePub() const
+{
+  return this->img_raw_cv_pub_ ? this->img_raw_cv_pub_->get_subscription_count() : this->img_raw_pub_.getNumSubscribers();
+}
+
+std::shared_ptr<std::vector<uint8_t>> PylonROS2CameraNode::acquireImageBuffer(const size_t& size)
+{
+  // a buffer only referenced by the pool is not used by any image anymore
+  for (std::shared_ptr<std::vector<uint8_t>>& buffer : this->image_buffers_)
+  {
+    if (buffer.use_count() == 1)
+    {
+      buffer->resize(size);
+      return buffer;
+    }
+  }
+
+  // the pool grows with the number of images held by the subscribers, up to a limit
+  if (this->image_buffers_.size() >= 16)
+  {
+    RCLCPP_WARN_STREAM_THROTTLE(LOGGER, *this->get_clock(), 5000, "The subscribers hold too many images, the frame memory pool is exhausted: "
+                                << "the images are dropped until they release some");
+    return nullptr;
+  }
+  this->image_buffers_.push_back(std::make_shared<std::vector<uint8_t>>(size));
+  return this->image_buffers_.back();
+}
+
+bool PylonROS2CameraNode::isDepthImageSubscribed() const
+{
+  return this->blaze_depth_image_pub_->get_subscription_count() > 0 || this->blaze_depth_cam_info_pub_->get_subscription_count() > 0;
+}
+
+bool PylonROS2CameraNode::isRegistrationConsumed() const
+{
+  return this->registration_channel_ && this->registration_channel_->hasConsumers();
+}
+
+bool PylonROS2CameraNode::isBlazeCompressedSubscribed() const
+{
+  return this->blaze_compressor_.isStarted() && this->blaze_compressed_pub_->get_subscription_count() > 0;
+}
+
+bool PylonROS2CameraNode::isEncodedImageSubscribed() const
+{
+  return this->image_encoder_pool_.isStarted() && this->img_encoded_pub_->get_subscription_count() > 0;
+}
+
+bool PylonROS2CameraNode::isVideoSubscribed() const
+{
+  return this->video_encoder_.isStarted() && this->video_pub_->get_subscription_count() > 0;
+}
+
+bool PylonROS2CameraNode::isZoneSubscribed() const
+{
+  for (const image_transport::CameraPublisher& zone_pub : this->zone_pubs_)
+  {
+    if (zone_pub.getNumSubscribers() > 0)
+    {
+      return true;
+    }
+  }
+  return false;
 }
 
 void PylonROS2CameraNode::getMaxNumBufferCallback(const std::shared_ptr<GetIntegerSrv::Request> request,
@@ -4192,6 +5266,22 @@ void PylonROS2CameraNode::triggerDeviceResetCallback(const std::shared_ptr<Trigg
   }
 }
 
+void PylonROS2CameraNode::dumpFrameTracesCallback(const std::shared_ptr<TriggerSrv::Request> request,
+                                                  std::shared_ptr<TriggerSrv::Response> response)
+{
+  (void)request;
+  if (!this->frame_tracer_.isEnabled())
+  {
+    response->success = false;
+    response->message = "Frame tracing is disabled, set the trace_buffer_size parameter to enable it";
+    return;
+  }
+
+  response->success = true;
+  response->message = this->frame_tracer_.dumpHistograms();
+  RCLCPP_INFO_STREAM(LOGGER, "Frame path latencies: " << response->message);
+}
+
 void PylonROS2CameraNode::startGrabbingCallback(const std::shared_ptr<TriggerSrv::Request> request,
                                                 std::shared_ptr<TriggerSrv::Response> response)
 {
@@ -4263,6 +5353,11 @@ void PylonROS2CameraNode::handleGrabRawImagesActionGoalAccepted(const std::share
 
 void PylonROS2CameraNode::executeGrabRawImagesAction(const std::shared_ptr<GrabImagesGoalHandle> goal_handle)
 {
+  applyThreadScheduling("worker",
+                        this->pylon_camera_parameter_set_.worker_cpus_,
+                        this->pylon_camera_parameter_set_.worker_priority_,
+                        this->pylon_camera_parameter_set_.worker_nice_);
+
   auto result = this->grabRawImages(goal_handle);
   goal_handle->succeed(result);
 }
@@ -4293,6 +5388,11 @@ void PylonROS2CameraNode::handleGrabRectImagesActionGoalAccepted(const std::shar
 
 void PylonROS2CameraNode::executeGrabRectImagesAction(const std::shared_ptr<GrabImagesGoalHandle> goal_handle)
 {
+  applyThreadScheduling("worker",
+                        this->pylon_camera_parameter_set_.worker_cpus_,
+                        this->pylon_camera_parameter_set_.worker_priority_,
+                        this->pylon_camera_parameter_set_.worker_nice_);
+
   const auto goal = goal_handle->get_goal();
   auto result = std::make_shared<GrabImagesAction::Result>();
   auto feedback = std::make_shared<GrabImagesAction::Feedback>();
@@ -4365,13 +5465,23 @@ void PylonROS2CameraNode::handleGrabBlazeDataActionGoalAccepted(const std::share
 
 void PylonROS2CameraNode::executeGrabBlazeDataAction(const std::shared_ptr<GrabBlazeDataGoalHandle> goal_handle)
 {
+  applyThreadScheduling("worker",
+                        this->pylon_camera_parameter_set_.worker_cpus_,
+                        this->pylon_camera_parameter_set_.worker_priority_,
+                        this->pylon_camera_parameter_set_.worker_nice_);
+
   const auto goal = goal_handle->get_goal();
   auto result = std::make_shared<GrabBlazeDataAction::Result>();
   auto feedback = std::make_shared<GrabBlazeDataAction::Feedback>();
 
   // stop it here if the connected cam is not a blaze
   // should not happen as the action server is setup if the connected cam is a blaze
-  if (!this->pylon_camera_->isBlaze())
+  bool is_blaze;
+  {
+    std::lock_guard<std::recursive_mutex> lock(this->grab_mutex_);
+    is_blaze = this->pylon_camera_ && this->pylon_camera_->isBlaze();
+  }
+  if (!is_blaze)
   {
     RCLCPP_WARN(LOGGER, "This action is not implemented for other camera models than the blaze.");
     result->success = false;
@@ -4395,92 +5505,147 @@ void PylonROS2CameraNode::executeGrabBlazeDataAction(const std::shared_ptr<GrabB
   size_t n_data = *std::max_element(candidates.begin(), candidates.end());
   // if new parameters are added, needs to be checked. See PylonROS2CameraNode::grabRawImages.
 
-  result->point_clouds.resize(n_data);
-  result->intensity_maps.resize(n_data);
-  result->depth_maps.resize(n_data);
-  result->depth_color_maps.resize(n_data);
-  result->confidence_maps.resize(n_data);
+  // 0 means all products, for compatibility with the clients not setting the field
+  const int products = goal->products == 0 ? BP_ALL : (goal->products & BP_ALL);
 
+  std::vector<BlazeRawData> raw_data(n_data);
+  std::vector<rclcpp::Time> grab_times(n_data);
   result->reached_exposure_times.resize(n_data);
   
   result->success = true;
 
-  std::lock_guard<std::recursive_mutex> lock(this->grab_mutex_);
-
+  // the data sets are only copied while grabbing, so that they are grabbed back-to-back at the camera frame rate
+  size_t n_grabbed = 0;
   float previous_exp;
-  if (goal->exposure_given)
+  // the conversion runs once the lock is released, when the camera may be reinitialized or deleted:
+  // it only uses this copy of the camera settings
+  BlazeConversionSettings conversion_settings;
   {
-    previous_exp = this->pylon_camera_->currentExposure();
-  }
+    std::lock_guard<std::recursive_mutex> lock(this->grab_mutex_);
 
-  RCLCPP_DEBUG_STREAM(LOGGER, "Number of grabbed data set: " << n_data);
-  for (std::size_t i = 0; i < n_data; ++i)
-  {
-    // user cancel request
-    if (goal_handle->is_canceling())
+    if (!this->pylon_camera_ || !this->pylon_camera_->blazeConversionSettings(conversion_settings))
     {
-      goal_handle->canceled(result);
-      RCLCPP_INFO_STREAM(LOGGER, "Acquisition is stopped (action is cancelled).");
+      result->success = false;
+      goal_handle->succeed(result);
       return;
     }
 
     if (goal->exposure_given)
     {
-      result->success = this->setExposure(goal->exposure_times[i], result->reached_exposure_times[i]);
+      previous_exp = this->pylon_camera_->currentExposure();
     }
 
-    if (!result->success)
+    RCLCPP_DEBUG_STREAM(LOGGER, "Number of grabbed data set: " << n_data);
+    for (; n_grabbed < n_data; ++n_grabbed)
     {
-      RCLCPP_ERROR_STREAM(LOGGER, "Error while setting one of the desired blaze features during acquisition (action). Aborting!");
-      break;
+      // user cancel request
+      if (goal_handle->is_canceling())
+      {
+        goal_handle->canceled(result);
+        RCLCPP_INFO_STREAM(LOGGER, "Acquisition is stopped (action is cancelled).");
+        return;
+      }
+
+      if (goal->exposure_given)
+      {
+        result->success = this->setExposure(goal->exposure_times[n_grabbed], result->reached_exposure_times[n_grabbed]);
+      }
+
+      if (!result->success)
+      {
+        RCLCPP_ERROR_STREAM(LOGGER, "Error while setting one of the desired blaze features during acquisition (action). Aborting!");
+        break;
+      }
+
+      grab_times[n_grabbed] = rclcpp::Node::now();
+      if (!this->pylon_camera_->grabBlazeRaw(raw_data[n_grabbed]))
+      {
+        result->success = false;
+        break;
+      }
+
+      feedback->curr_nr_data_acquired = n_grabbed + 1;
+      goal_handle->publish_feedback(feedback);
+    }
+
+    float reached_val;
+    if (goal->exposure_given)
+    {
+      this->setExposure(previous_exp, reached_val);
     }
+  }
 
-    sensor_msgs::msg::PointCloud2& point_cloud = result->point_clouds[i];
-    sensor_msgs::msg::Image& intensity_map = result->intensity_maps[i];
-    sensor_msgs::msg::Image& depth_map = result->depth_maps[i];
-    sensor_msgs::msg::Image& depth_color_map = result->depth_color_maps[i];
-    sensor_msgs::msg::Image& confidence_map = result->confidence_maps[i];
+  // only the data sets grabbed before a failure are returned
+  result->reached_exposure_times.resize(n_grabbed);
+  result->point_clouds.resize((products & BP_POINT_CLOUD) ? n_grabbed : 0);
+  result->intensity_maps.resize((products & BP_INTENSITY_MAP) ? n_grabbed : 0);
+  result->depth_maps.resize((products & BP_DEPTH_MAP) ? n_grabbed : 0);
+  result->depth_color_maps.resize((products & BP_DEPTH_COLOR_MAP) ? n_grabbed : 0);
+  result->confidence_maps.resize((products & BP_CONFIDENCE_MAP) ? n_grabbed : 0);
 
-    auto grab_time = rclcpp::Node::now();
-    if (!this->pylon_camera_->grabBlaze(point_cloud, 
-                                        intensity_map, 
-                                        depth_map, 
-                                        depth_color_map, 
-                                        confidence_map))
+  // the data sets are converted in parallel, the messages of the products that are not requested are scratch buffers
+  std::atomic<size_t> next_index(0);
+  std::atomic<bool> converted(true);
+  auto convert = [&]()
+  {
+    sensor_msgs::msg::PointCloud2 unused_cloud;
+    sensor_msgs::msg::Image unused_intensity_map, unused_depth_map, unused_depth_color_map, unused_confidence_map;
+    for (size_t i = next_index++; i < n_grabbed; i = next_index++)
     {
-      result->success = false;
-      break;
+      sensor_msgs::msg::PointCloud2& point_cloud = (products & BP_POINT_CLOUD) ? result->point_clouds[i] : unused_cloud;
+      sensor_msgs::msg::Image& intensity_map = (products & BP_INTENSITY_MAP) ? result->intensity_maps[i] : unused_intensity_map;
+      sensor_msgs::msg::Image& depth_map = (products & BP_DEPTH_MAP) ? result->depth_maps[i] : unused_depth_map;
+      sensor_msgs::msg::Image& depth_color_map = (products & BP_DEPTH_COLOR_MAP) ? result->depth_color_maps[i] : unused_depth_color_map;
+      sensor_msgs::msg::Image& confidence_map = (products & BP_CONFIDENCE_MAP) ? result->confidence_maps[i] : unused_confidence_map;
+
+      if (!PylonROS2Camera::convertBlazeRaw(conversion_settings, raw_data[i], products,
+                                            point_cloud, intensity_map, depth_map, depth_color_map, confidence_map))
+      {
+        converted = false;
+      }
+      // the copy is not needed anymore
+      raw_data[i] = BlazeRawData();
+
+      // acquisition time and frame id
+      point_cloud.header.stamp = grab_times[i];
+      point_cloud.header.frame_id = blazeCloudFrame();
+      for (sensor_msgs::msg::Image* map : {&intensity_map, &depth_map, &depth_color_map, &confidence_map})
+      {
+        map->header.stamp = grab_times[i];
+        map->header.frame_id = cameraFrame();
+      }
     }
+  };
 
-    // acquisition time
-    point_cloud.header.stamp = grab_time;
-    intensity_map.header.stamp = grab_time;
-    depth_map.header.stamp = grab_time;
-    depth_color_map.header.stamp = grab_time;
-    confidence_map.header.stamp = grab_time;
-
-    // frame id
-    point_cloud.header.frame_id = cameraFrame();
-    intensity_map.header.frame_id = cameraFrame();
-    depth_map.header.frame_id = cameraFrame();
-    depth_color_map.header.frame_id = cameraFrame();
-    confidence_map.header.frame_id = cameraFrame();
-
-    feedback->curr_nr_data_acquired = i + 1;
-    //RCLCPP_DEBUG_STREAM(LOGGER, "Publishing feedback...");
-    goal_handle->publish_feedback(feedback);
-    //RCLCPP_DEBUG_STREAM(LOGGER, "Feedback is published!");
+  const size_t n_workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), n_grabbed);
+  std::vector<std::thread> workers;
+  for (size_t w = 1; w < n_workers; ++w)
+  {
+    workers.emplace_back([this, &convert]()
+    {
+      applyThreadScheduling("worker",
+                            this->pylon_camera_parameter_set_.worker_cpus_,
+                            this->pylon_camera_parameter_set_.worker_priority_,
+                            this->pylon_camera_parameter_set_.worker_nice_);
+      convert();
+    });
+  }
+  // the action thread converts as well
+  convert();
+  for (std::thread& worker : workers)
+  {
+    worker.join();
   }
 
-  if (this->camera_info_manager_)
+  if (!converted)
   {
-    result->cam_info = this->camera_info_manager_->getCameraInfo();
+    RCLCPP_ERROR_STREAM(LOGGER, "Error while converting the blaze data sets (action)");
+    result->success = false;
   }
 
-  float reached_val;
-  if (goal->exposure_given)
+  if (this->camera_info_manager_)
   {
-    this->setExposure(previous_exp, reached_val);
+    result->cam_info = this->camera_info_manager_->getCameraInfo();
   }
 
   goal_handle->succeed(result);
@@ -4523,11 +5688,223 @@ void PylonROS2CameraNode::createCameraInfoDiagnostics(diagnostic_updater::Diagno
   }
 }
 
+void PylonROS2CameraNode::createFramePathDiagnostics(diagnostic_updater::DiagnosticStatusWrapper &stat)
+{
+  const uint64_t dropped_frames = this->pylon_camera_ ? this->pylon_camera_->droppedFrames() : 0;
+  // the counting restarts with a new camera instance
+  const uint64_t new_dropped_frames = dropped_frames >= this->diagnostics_dropped_frames_ ? dropped_frames - this->diagnostics_dropped_frames_ : dropped_frames;
+  this->diagnostics_dropped_frames_ = dropped_frames;
+
+  if (new_dropped_frames > 0)
+  {
+    stat.summaryf(diagnostic_msgs::msg::DiagnosticStatus::WARN, "%lu frame(s) dropped since the last update", new_dropped_frames);
+  }
+  else
+  {
+    stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "No frame dropped");
+  }
+
+  stat.add("Dropped frames (chunk frame counter)", dropped_frames);
+  stat.add("Dropped frames since last update", new_dropped_frames);
+
+  const std::vector<std::pair<std::string, StageStatistics*>> stages = {{"Grab", &this->grab_statistics_},
+                                                                        {"Rectification", &this->rectification_statistics_},
+                                                                        {"Publish", &this->publish_statistics_}};
+  for (const auto& stage : stages)
+  {
+    StageStatistics& statistics = *stage.second;
+    if (statistics.count > 0)
+    {
+      stat.add(stage.first + " mean time [ms]", statistics.sum_ms / statistics.count);
+      stat.add(stage.first + " max time [ms]", statistics.max_ms);
+    }
+    statistics = StageStatistics();
+  }
+}
+
 void PylonROS2CameraNode::diagnosticsTimerCallback()
 {
   this->diagnostics_updater_.force_update();
 }
 
+void PylonROS2CameraNode::cameraInfoTimerCallback()
+{
+  // the rectification maps and the zone infos are only recomputed if the camera info changed
+  if (this->camera_info_manager_->getCameraInfo() != this->managed_cam_info_msg_)
+  {
+    this->refreshCameraInfo();
+  }
+}
+
+void PylonROS2CameraNode::updateCameraInfo(const sensor_msgs::msg::CameraInfo& cam_info)
+{
+  this->camera_info_manager_->setCameraInfo(cam_info);
+  this->refreshCameraInfo();
+}
+
+void PylonROS2CameraNode::refreshCameraInfo()
+{
+  // the camera info is not fetched in every frame, only when it is written or changed by a service call
+  this->managed_cam_info_msg_ = this->camera_info_manager_->getCameraInfo();
+  this->cam_info_msg_ = this->managed_cam_info_msg_;
+  if (this->pinhole_model_)
+  {
+    // fromCameraInfo only recomputes the rectification maps if the camera info changed
+    this->pinhole_model_->fromCameraInfo(this->cam_info_msg_);
+  }
+
+  // the zones are crops of the sensor image: the principal point moves by the offsets of the zone
+  this->zone_infos_.resize(this->multi_roi_rows_.size() * this->multi_roi_columns_.size());
+  size_t zone_index = 0;
+  for (const ROIZone& row_zone : this->multi_roi_rows_)
+  {
+    for (const ROIZone& column_zone : this->multi_roi_columns_)
+    {
+      sensor_msgs::msg::CameraInfo& zone_info = this->zone_infos_[zone_index];
+      zone_info = this->cam_info_msg_;
+      zone_info.width = static_cast<uint32_t>(column_zone.second);
+      zone_info.height = static_cast<uint32_t>(row_zone.second);
+      zone_info.roi = sensor_msgs::msg::RegionOfInterest();
+      if (zone_info.k[0] != 0.0)
+      {
+        zone_info.k[2] -= static_cast<double>(column_zone.first);
+        zone_info.k[5] -= static_cast<double>(row_zone.first);
+        zone_info.p[2] -= static_cast<double>(column_zone.first);
+        zone_info.p[6] -= static_cast<double>(row_zone.first);
+      }
+      ++zone_index;
+    }
+  }
+
+  if (!this->zone_infos_.empty() && this->pylon_camera_)
+  {
+    // the compact frame of the zones is not a pinhole image, it is published as uncalibrated
+    this->cam_info_msg_.width = static_cast<uint32_t>(this->pylon_camera_->imageCols());
+    this->cam_info_msg_.height = static_cast<uint32_t>(this->pylon_camera_->imageRows());
+    this->cam_info_msg_.roi = sensor_msgs::msg::RegionOfInterest();
+    this->cam_info_msg_.d.clear();
+    this->cam_info_msg_.k.fill(0.0);
+    this->cam_info_msg_.p.fill(0.0);
+  }
+}
+
+void PylonROS2CameraNode::trackingROICallback(const sensor_msgs::msg::RegionOfInterest::SharedPtr msg)
+{
+  std::lock_guard<std::mutex> lock(this->tracking_roi_mutex_);
+  this->tracking_roi_target_ = *msg;
+  this->is_tracking_roi_target_pending_ = true;
+}
+
+void PylonROS2CameraNode::applyTrackingROI()
+{
+  sensor_msgs::msg::RegionOfInterest target;
+  {
+    std::lock_guard<std::mutex> lock(this->tracking_roi_mutex_);
+    if (!this->is_tracking_roi_target_pending_)
+    {
+      return;
+    }
+    target = this->tracking_roi_target_;
+    this->is_tracking_roi_target_pending_ = false;
+  }
+
+  // the window is centered on the target region, the camera keeps it inside the sensor
+  int64_t offset_x = target.x_offset;
+  int64_t offset_y = target.y_offset;
+  if (target.width > 0 && target.height > 0)
+  {
+    offset_x += (static_cast<int64_t>(target.width) - static_cast<int64_t>(this->img_raw_msg_.width)) / 2;
+    offset_y += (static_cast<int64_t>(target.height) - static_cast<int64_t>(this->img_raw_msg_.height)) / 2;
+  }
+
+  sensor_msgs::msg::RegionOfInterest reached_roi;
+  if (!this->pylon_camera_->moveROI(offset_x, offset_y, reached_roi))
+  {
+    RCLCPP_WARN_STREAM_THROTTLE(LOGGER, *this->get_clock(), 5000, "The tracking window can't be moved to (" << offset_x << ", " << offset_y << ")");
+  }
+}
+
+void PylonROS2CameraNode::publishZones()
+{
+  if (this->img_raw_msg_.width == 0 || this->multi_roi_rows_.size() * this->multi_roi_columns_.size() != this->zone_pubs_.size() ||
+      this->zone_infos_.size() != this->zone_pubs_.size())
+  {
+    return;
+  }
+
+  // the compact frame is made of the zones, row zone after row zone, column zone after column zone
+  const size_t pixel_bytes = this->img_raw_msg_.step / this->img_raw_msg_.width;
+  size_t zone_index = 0;
+  size_t frame_y = 0;
+  for (const ROIZone& row_zone : this->multi_roi_rows_)
+  {
+    size_t frame_x = 0;
+    for (const ROIZone& column_zone : this->multi_roi_columns_)
+    {
+      const bool is_inside = frame_y + row_zone.second <= this->img_raw_msg_.height && frame_x + column_zone.second <= this->img_raw_msg_.width;
+      if (is_inside && this->zone_pubs_[zone_index].getNumSubscribers() > 0)
+      {
+        sensor_msgs::msg::Image& zone_msg = this->zone_msgs_[zone_index];
+        zone_msg.header = this->img_raw_msg_.header;
+        zone_msg.encoding = this->img_raw_msg_.encoding;
+        zone_msg.is_bigendian = this->img_raw_msg_.is_bigendian;
+        zone_msg.width = static_cast<uint32_t>(column_zone.second);
+        zone_msg.height = static_cast<uint32_t>(row_zone.second);
+        zone_msg.step = static_cast<uint32_t>(column_zone.second * pixel_bytes);
+        // the message keeps its capacity from frame to frame
+        zone_msg.data.resize(zone_msg.step * zone_msg.height);
+        for (size_t y = 0; y < zone_msg.height; ++y)
+        {
+          std::memcpy(&zone_msg.data[y * zone_msg.step],
+                      &this->img_raw_msg_.data[(frame_y + y) * this->img_raw_msg_.step + frame_x * pixel_bytes],
+                      zone_msg.step);
+        }
+
+        // the camera info of the zone is computed when the camera info changes, only its stamp is set here
+        sensor_msgs::msg::CameraInfo& zone_info = this->zone_infos_[zone_index];
+        zone_info.header.stamp = this->img_raw_msg_.header.stamp;
+        this->zone_pubs_[zone_index].publish(zone_msg, zone_info);
+      }
+      frame_x += column_zone.second;
+      ++zone_index;
+    }
+    frame_y += row_zone.second;
+  }
+}
+
+bool PylonROS2CameraNode::updateRectificationCache()
+{
+  if (this->img_raw_msg_.encoding == this->rect_source_encoding_)
+  {
+    return this->rect_source_cv_type_ >= 0;
+  }
+
+  this->rect_source_encoding_ = this->img_raw_msg_.encoding;
+  this->rect_bayer_code_ = -1;
+
+  std::string rect_encoding = this->img_raw_msg_.encoding;
+  if (sensor_msgs::image_encodings::isBayer(rect_encoding))
+  {
+    const int bit_depth = sensor_msgs::image_encodings::bitDepth(rect_encoding);
+    this->rect_bayer_code_ = encodingconversions::bayer2OpenCVCode(rect_encoding);
+    rect_encoding = (bit_depth == 16) ? "bgr16" : "bgr8";
+  }
+
+  try
+  {
+    this->rect_source_cv_type_ = cv_bridge::getCvType(this->img_raw_msg_.encoding);
+  }
+  catch (const cv_bridge::Exception& e)
+  {
+    RCLCPP_ERROR_STREAM(LOGGER, "Raw image encoding " << this->img_raw_msg_.encoding << " can't be rectified: " << e.what());
+    this->rect_source_cv_type_ = -1;
+    return false;
+  }
+
+  this->cv_bridge_img_rect_->encoding = rect_encoding;
+  return true;
+}
+
 bool PylonROS2CameraNode::serviceExists(const std::string& service_name)
 {
   std::map<std::string, std::vector<std::string>> results = rclcpp::Node::get_service_names_and_types();
@@ -4657,7 +6034,14 @@ void PylonROS2CameraNode::setupRectification()
 {
   using namespace std::placeholders;
 
-  if (!this->img_rect_pub_)
+  if (this->pylon_camera_parameter_set_.intra_process_images_)
+  {
+    if (!this->img_rect_cv_pub_)
+    {
+      this->img_rect_cv_pub_ = this->create_publisher<CvMatImage>("~/image_rect", 10);
+    }
+  }
+  else if (!this->img_rect_pub_)
   {
     this->img_rect_pub_ = new image_transport::Publisher(image_transport::create_publisher(this, "~/image_rect"));
   }
@@ -4684,6 +6068,8 @@ void PylonROS2CameraNode::setupRectification()
   }
   this->cv_bridge_img_rect_->header = img_raw_msg_.header;
   this->cv_bridge_img_rect_->encoding = img_raw_msg_.encoding;
+  // forces the rectification settings to be recomputed with the next frame
+  this->rect_source_encoding_.clear();
 }
 
 std::shared_ptr<GrabImagesAction::Result> PylonROS2CameraNode::grabRawImages(const std::shared_ptr<GrabImagesGoalHandle> goal_handle)
@@ -4864,12 +6250,12 @@ std::shared_ptr<GrabImagesAction::Result> PylonROS2CameraNode::grabRawImages(con
     }
 
     sensor_msgs::msg::Image& img = result->images[i];
-    img.encoding = this->pylon_camera_->currentROSEncoding();
+    img.encoding = this->pylon_camera_->outputROSEncoding();
     img.height = this->pylon_camera_->imageRows();
     img.width = this->pylon_camera_->imageCols();
-    // step = full row length in bytes, img_size = (step * rows), imagePixelDepth
+    // step = full row length in bytes, img_size = (step * rows), outputPixelDepth
     // already contains the number of channels
-    img.step = img.width * this->pylon_camera_->imagePixelDepth();
+    img.step = img.width * this->pylon_camera_->outputPixelDepth();
 
     // Store current time before the image is transmitted for a more accurate grab time estimation.
     // If chunk timestamp is enabled, grab will overwrite it with the acquisition timestamp.
@@ -27,8 +27,15 @@
  *****************************************************************************/
 
 #include "pylon_ros2_camera_parameter.hpp"
+#include <rclcpp_lifecycle/lifecycle_node.hpp>
 #include <sensor_msgs/image_encodings.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
 
 namespace pylon_ros2_camera
 {
@@ -63,6 +70,63 @@ PylonROS2CameraParameter::PylonROS2CameraParameter() :
     startup_user_set_(""),
     inter_pkg_delay_(1000),
     frame_transmission_delay_(0),
+    heartbeat_timeout_(0),
+    reconnect_poll_interval_(100),
+    reconnect_timeout_(30000),
+    watchdog_max_failures_(0),
+    watchdog_timeout_(0),
+    acquisition_cpus_(),
+    acquisition_priority_(0),
+    acquisition_nice_(0),
+    worker_cpus_(),
+    worker_priority_(0),
+    worker_nice_(0),
+    pylon_thread_priority_(0),
+    lock_memory_(false),
+    trace_buffer_size_(0),
+    diagnostics_frequency_tolerance_(0.1),
+    diagnostics_max_frame_age_(0.5),
+    blaze_range_only_(false),
+    blaze_depth_image_encoding_("32FC1"),
+    blaze_depth_image_content_("z"),
+    blaze_cloud_frame_(""),
+    blaze_cloud_transform_({0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0}),
+    blaze_compute_normals_(false),
+    blaze_normals_min_confidence_(0),
+    registration_channel_(""),
+    blaze_registration_transform_({0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0}),
+    blaze_registration_max_time_offset_(10.0),
+    blaze_compression_(""),
+    blaze_compression_level_(1),
+    blaze_compression_quantization_(1.0),
+    blaze_compression_threads_(2),
+    compressed_format_(""),
+    compressed_jpeg_quality_(90),
+    compressed_png_level_(1),
+    compressed_threads_(2),
+    video_codec_(""),
+    video_bitrate_(1000),
+    video_gop_(30),
+    video_preset_("ultrafast"),
+    video_scale_(1.0),
+    shm_name_(""),
+    shm_slots_(4),
+    intra_process_images_(false),
+    sensor_correction_dir_(""),
+    tone_mapping_curve_(""),
+    tone_mapping_gamma_(0.45),
+    tone_mapping_lut_file_(""),
+    tone_mapping_on_camera_(false),
+    tracking_roi_width_(0),
+    tracking_roi_height_(0),
+    multi_roi_rows_(),
+    multi_roi_columns_(),
+    device_serial_number_(""),
+    device_ip_address_(""),
+    device_full_name_(""),
+    shutdown_on_init_failure_(true),
+    fast_startup_(false),
+    startup_snapshot_dir_(""),
     shutter_mode_(SM_DEFAULT),
     auto_flash_(false),
     auto_flash_line_2_(true),
@@ -92,7 +156,8 @@ PylonROS2CameraParameter::PylonROS2CameraParameter() :
 PylonROS2CameraParameter::~PylonROS2CameraParameter()
 {}
 
-void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
+template <typename NodeT>
+void PylonROS2CameraParameter::readFromRosParameterServer(NodeT& nh)
 {
     RCLCPP_DEBUG(LOGGER, "-> Reading parameters from ROS2 server");
 
@@ -101,7 +166,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("camera_frame"))
     {
-        nh.declare_parameter<std::string>("camera_frame", "pylon_camera");
+        nh.template declare_parameter<std::string>("camera_frame", "pylon_camera");
     }
 
     nh.get_parameter("camera_frame", this->camera_frame_);
@@ -111,17 +176,57 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("device_user_id"))
     {
-        nh.declare_parameter<std::string>("device_user_id", "");
+        nh.template declare_parameter<std::string>("device_user_id", "");
     }
     
     nh.get_parameter("device_user_id", this->device_user_id_);
 
+    // device serial number
+    RCLCPP_DEBUG(LOGGER, "---> device_serial_number");
+    
+    if (!nh.has_parameter("device_serial_number"))
+    {
+        nh.template declare_parameter<std::string>("device_serial_number", "");
+    }
+    
+    nh.get_parameter("device_serial_number", this->device_serial_number_);
+
+    // device ip address
+    RCLCPP_DEBUG(LOGGER, "---> device_ip_address");
+    
+    if (!nh.has_parameter("device_ip_address"))
+    {
+        nh.template declare_parameter<std::string>("device_ip_address", "");
+    }
+    
+    nh.get_parameter("device_ip_address", this->device_ip_address_);
+
+    // device full name
+    RCLCPP_DEBUG(LOGGER, "---> device_full_name");
+    
+    if (!nh.has_parameter("device_full_name"))
+    {
+        nh.template declare_parameter<std::string>("device_full_name", "");
+    }
+    
+    nh.get_parameter("device_full_name", this->device_full_name_);
+
+    // shutdown on init failure
+    RCLCPP_DEBUG(LOGGER, "---> shutdown_on_init_failure");
+    
+    if (!nh.has_parameter("shutdown_on_init_failure"))
+    {
+        nh.template declare_parameter<bool>("shutdown_on_init_failure", true);
+    }
+    
+    nh.get_parameter("shutdown_on_init_failure", this->shutdown_on_init_failure_);
+
     // frame rate
     RCLCPP_DEBUG(LOGGER, "---> frame_rate");
     
     if (!nh.has_parameter("frame_rate"))
     {
-        nh.declare_parameter<double>("frame_rate", 5.0);
+        nh.template declare_parameter<double>("frame_rate", 5.0);
     }
 
     nh.get_parameter("frame_rate", this->frame_rate_);
@@ -131,7 +236,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("camera_info_url"))
     {
-        nh.declare_parameter<std::string>("camera_info_url", "");
+        nh.template declare_parameter<std::string>("camera_info_url", "");
     }
     
     nh.get_parameter("camera_info_url", this->camera_info_url_);
@@ -147,7 +252,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     }
     else
     {
-        nh.declare_parameter<int>("binning_x", 1);
+        nh.template declare_parameter<int>("binning_x", 1);
         binning_x = 1;
     }
 
@@ -174,7 +279,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     }
     else
     {
-        nh.declare_parameter<int>("binning_y", 1);
+        nh.template declare_parameter<int>("binning_y", 1);
         binning_y = 1;
     }
 
@@ -195,7 +300,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("downsampling_factor_exposure_search"))
     {
-        nh.declare_parameter<int>("downsampling_factor_exposure_search", 20);
+        nh.template declare_parameter<int>("downsampling_factor_exposure_search", 20);
     }
     
     nh.get_parameter("downsampling_factor_exposure_search", this->downsampling_factor_exposure_search_);
@@ -205,7 +310,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("image_encoding"))
     {
-        nh.declare_parameter<std::string>("image_encoding", "");
+        nh.template declare_parameter<std::string>("image_encoding", "");
     }
 
     std::string encoding;
@@ -236,7 +341,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     this->exposure_given_ = nh.has_parameter("exposure");
     if (!this->exposure_given_)
     {
-        nh.declare_parameter<double>("exposure", 10000.0);
+        nh.template declare_parameter<double>("exposure", 10000.0);
     }
     
     nh.get_parameter("exposure", this->exposure_);
@@ -247,7 +352,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     this->gain_given_ = nh.has_parameter("gain");
     if (!this->gain_given_)
     {
-        nh.declare_parameter<double>("gain", 0.5);
+        nh.template declare_parameter<double>("gain", 0.5);
     }
 
     nh.get_parameter("gain", this->gain_);
@@ -258,7 +363,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     this->gamma_given_ = nh.has_parameter("gamma");
     if (!this->gamma_given_)
     {
-        nh.declare_parameter<double>("gamma", 1.0);
+        nh.template declare_parameter<double>("gamma", 1.0);
     }
 
     nh.get_parameter("gamma", this->gamma_);
@@ -268,7 +373,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
 
     if (!nh.has_parameter("brightness_continuous"))
     {
-        nh.declare_parameter<bool>("brightness_continuous", false);
+        nh.template declare_parameter<bool>("brightness_continuous", false);
     }
     
     nh.get_parameter("brightness_continuous", this->brightness_continuous_);
@@ -278,7 +383,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
 
     if (!nh.has_parameter("exposure_auto"))
     {
-        nh.declare_parameter<bool>("exposure_auto", true);
+        nh.template declare_parameter<bool>("exposure_auto", true);
     }
     
     nh.get_parameter("exposure_auto", this->exposure_auto_);
@@ -288,7 +393,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
 
     if (!nh.has_parameter("gain_auto"))
     {
-        nh.declare_parameter<bool>("gain_auto", true);
+        nh.template declare_parameter<bool>("gain_auto", true);
     }
     
     nh.get_parameter("gain_auto", this->gain_auto_);
@@ -300,7 +405,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
 
     if (!this->brightness_given_)
     {
-        nh.declare_parameter<int>("brightness", 100);
+        nh.template declare_parameter<int>("brightness", 100);
     }
     
     nh.get_parameter("brightness", this->brightness_);
@@ -331,7 +436,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("exposure_search_timeout"))
     {
-        nh.declare_parameter<double>("exposure_search_timeout", 5.);
+        nh.template declare_parameter<double>("exposure_search_timeout", 5.);
     }
 
     nh.get_parameter("exposure_search_timeout", this->exposure_search_timeout_);
@@ -341,7 +446,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("auto_exposure_upper_limit"))
     {
-        nh.declare_parameter<double>("auto_exposure_upper_limit", 10000000.);
+        nh.template declare_parameter<double>("auto_exposure_upper_limit", 10000000.);
     }
     
     nh.get_parameter("auto_exposure_upper_limit", this->auto_exposure_upper_limit_);
@@ -351,7 +456,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("gige/mtu_size"))
     {
-        nh.declare_parameter<int>("gige/mtu_size", 3000);
+        nh.template declare_parameter<int>("gige/mtu_size", 3000);
     }
     
     nh.get_parameter("gige/mtu_size", this->mtu_size_);
@@ -361,7 +466,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("enable_status_publisher"))
     {
-        nh.declare_parameter<bool>("enable_status_publisher", false);
+        nh.template declare_parameter<bool>("enable_status_publisher", false);
     }
     
     nh.get_parameter("enable_status_publisher", this->enable_status_publisher_);
@@ -371,7 +476,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("enable_current_params_publisher"))
     {
-        nh.declare_parameter<bool>("enable_current_params_publisher", false);
+        nh.template declare_parameter<bool>("enable_current_params_publisher", false);
     }
     
     nh.get_parameter("enable_current_params_publisher", this->enable_current_params_publisher_);
@@ -381,7 +486,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("startup_user_set"))
     {
-        nh.declare_parameter<std::string>("startup_user_set", "");
+        nh.template declare_parameter<std::string>("startup_user_set", "");
     }
     
     nh.get_parameter("startup_user_set", this->startup_user_set_);
@@ -391,7 +496,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("gige/inter_pkg_delay"))
     {
-        nh.declare_parameter<int>("gige/inter_pkg_delay", 1000);
+        nh.template declare_parameter<int>("gige/inter_pkg_delay", 1000);
     }
     
     nh.get_parameter("gige/inter_pkg_delay", this->inter_pkg_delay_);
@@ -401,17 +506,547 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("gige/frame_transmission_delay"))
     {
-        nh.declare_parameter<int>("gige/frame_transmission_delay", 0);
+        nh.template declare_parameter<int>("gige/frame_transmission_delay", 0);
     }
     
     nh.get_parameter("gige/frame_transmission_delay", this->frame_transmission_delay_);
 
+    // heartbeat_timeout
+    RCLCPP_DEBUG(LOGGER, "---> gige/heartbeat_timeout");
+    
+    if (!nh.has_parameter("gige/heartbeat_timeout"))
+    {
+        nh.template declare_parameter<int>("gige/heartbeat_timeout", 0);
+    }
+    
+    nh.get_parameter("gige/heartbeat_timeout", this->heartbeat_timeout_);
+
+    // reconnect_poll_interval
+    RCLCPP_DEBUG(LOGGER, "---> reconnect_poll_interval");
+    
+    if (!nh.has_parameter("reconnect_poll_interval"))
+    {
+        nh.template declare_parameter<int>("reconnect_poll_interval", 100);
+    }
+    
+    nh.get_parameter("reconnect_poll_interval", this->reconnect_poll_interval_);
+
+    // reconnect_timeout
+    RCLCPP_DEBUG(LOGGER, "---> reconnect_timeout");
+    
+    if (!nh.has_parameter("reconnect_timeout"))
+    {
+        nh.template declare_parameter<int>("reconnect_timeout", 30000);
+    }
+    
+    nh.get_parameter("reconnect_timeout", this->reconnect_timeout_);
+
+    // watchdog_max_failures
+    RCLCPP_DEBUG(LOGGER, "---> watchdog_max_failures");
+    
+    if (!nh.has_parameter("watchdog_max_failures"))
+    {
+        nh.template declare_parameter<int>("watchdog_max_failures", 0);
+    }
+    
+    nh.get_parameter("watchdog_max_failures", this->watchdog_max_failures_);
+
+    // watchdog_timeout
+    RCLCPP_DEBUG(LOGGER, "---> watchdog_timeout");
+    
+    if (!nh.has_parameter("watchdog_timeout"))
+    {
+        nh.template declare_parameter<int>("watchdog_timeout", 0);
+    }
+    
+    nh.get_parameter("watchdog_timeout", this->watchdog_timeout_);
+
+    // realtime/acquisition_cpus
+    RCLCPP_DEBUG(LOGGER, "---> realtime/acquisition_cpus");
+    
+    if (!nh.has_parameter("realtime/acquisition_cpus"))
+    {
+        nh.template declare_parameter<std::vector<int64_t>>("realtime/acquisition_cpus", std::vector<int64_t>{});
+    }
+    
+    nh.get_parameter("realtime/acquisition_cpus", this->acquisition_cpus_);
+
+    // realtime/acquisition_priority
+    RCLCPP_DEBUG(LOGGER, "---> realtime/acquisition_priority");
+    
+    if (!nh.has_parameter("realtime/acquisition_priority"))
+    {
+        nh.template declare_parameter<int>("realtime/acquisition_priority", 0);
+    }
+    
+    nh.get_parameter("realtime/acquisition_priority", this->acquisition_priority_);
+
+    // realtime/acquisition_nice
+    RCLCPP_DEBUG(LOGGER, "---> realtime/acquisition_nice");
+    
+    if (!nh.has_parameter("realtime/acquisition_nice"))
+    {
+        nh.template declare_parameter<int>("realtime/acquisition_nice", 0);
+    }
+    
+    nh.get_parameter("realtime/acquisition_nice", this->acquisition_nice_);
+
+    // realtime/worker_cpus
+    RCLCPP_DEBUG(LOGGER, "---> realtime/worker_cpus");
+    
+    if (!nh.has_parameter("realtime/worker_cpus"))
+    {
+        nh.template declare_parameter<std::vector<int64_t>>("realtime/worker_cpus", std::vector<int64_t>{});
+    }
+    
+    nh.get_parameter("realtime/worker_cpus", this->worker_cpus_);
+
+    // realtime/worker_priority
+    RCLCPP_DEBUG(LOGGER, "---> realtime/worker_priority");
+    
+    if (!nh.has_parameter("realtime/worker_priority"))
+    {
+        nh.template declare_parameter<int>("realtime/worker_priority", 0);
+    }
+    
+    nh.get_parameter("realtime/worker_priority", this->worker_priority_);
+
+    // realtime/worker_nice
+    RCLCPP_DEBUG(LOGGER, "---> realtime/worker_nice");
+    
+    if (!nh.has_parameter("realtime/worker_nice"))
+    {
+        nh.template declare_parameter<int>("realtime/worker_nice", 0);
+    }
+    
+    nh.get_parameter("realtime/worker_nice", this->worker_nice_);
+
+    // realtime/pylon_thread_priority
+    RCLCPP_DEBUG(LOGGER, "---> realtime/pylon_thread_priority");
+    
+    if (!nh.has_parameter("realtime/pylon_thread_priority"))
+    {
+        nh.template declare_parameter<int>("realtime/pylon_thread_priority", 0);
+    }
+    
+    nh.get_parameter("realtime/pylon_thread_priority", this->pylon_thread_priority_);
+
+    // realtime/lock_memory
+    RCLCPP_DEBUG(LOGGER, "---> realtime/lock_memory");
+    
+    if (!nh.has_parameter("realtime/lock_memory"))
+    {
+        nh.template declare_parameter<bool>("realtime/lock_memory", false);
+    }
+    
+    nh.get_parameter("realtime/lock_memory", this->lock_memory_);
+
+    // trace_buffer_size
+    RCLCPP_DEBUG(LOGGER, "---> trace_buffer_size");
+    
+    if (!nh.has_parameter("trace_buffer_size"))
+    {
+        nh.template declare_parameter<int>("trace_buffer_size", 0);
+    }
+    
+    nh.get_parameter("trace_buffer_size", this->trace_buffer_size_);
+
+    // diagnostics/frequency_tolerance
+    RCLCPP_DEBUG(LOGGER, "---> diagnostics/frequency_tolerance");
+    
+    if (!nh.has_parameter("diagnostics/frequency_tolerance"))
+    {
+        nh.template declare_parameter<double>("diagnostics/frequency_tolerance", 0.1);
+    }
+    
+    nh.get_parameter("diagnostics/frequency_tolerance", this->diagnostics_frequency_tolerance_);
+
+    // diagnostics/max_frame_age
+    RCLCPP_DEBUG(LOGGER, "---> diagnostics/max_frame_age");
+    
+    if (!nh.has_parameter("diagnostics/max_frame_age"))
+    {
+        nh.template declare_parameter<double>("diagnostics/max_frame_age", 0.5);
+    }
+    
+    nh.get_parameter("diagnostics/max_frame_age", this->diagnostics_max_frame_age_);
+
+    // blaze/range_only
+    RCLCPP_DEBUG(LOGGER, "---> blaze/range_only");
+    
+    if (!nh.has_parameter("blaze/range_only"))
+    {
+        nh.template declare_parameter<bool>("blaze/range_only", false);
+    }
+    
+    nh.get_parameter("blaze/range_only", this->blaze_range_only_);
+
+    // blaze/depth_image_encoding
+    RCLCPP_DEBUG(LOGGER, "---> blaze/depth_image_encoding");
+    
+    if (!nh.has_parameter("blaze/depth_image_encoding"))
+    {
+        nh.template declare_parameter<std::string>("blaze/depth_image_encoding", "32FC1");
+    }
+    
+    nh.get_parameter("blaze/depth_image_encoding", this->blaze_depth_image_encoding_);
+
+    // blaze/depth_image_content
+    RCLCPP_DEBUG(LOGGER, "---> blaze/depth_image_content");
+    
+    if (!nh.has_parameter("blaze/depth_image_content"))
+    {
+        nh.template declare_parameter<std::string>("blaze/depth_image_content", "z");
+    }
+    
+    nh.get_parameter("blaze/depth_image_content", this->blaze_depth_image_content_);
+
+    // blaze/cloud_frame
+    RCLCPP_DEBUG(LOGGER, "---> blaze/cloud_frame");
+    
+    if (!nh.has_parameter("blaze/cloud_frame"))
+    {
+        nh.template declare_parameter<std::string>("blaze/cloud_frame", "");
+    }
+    
+    nh.get_parameter("blaze/cloud_frame", this->blaze_cloud_frame_);
+
+    // blaze/cloud_transform
+    RCLCPP_DEBUG(LOGGER, "---> blaze/cloud_transform");
+    
+    if (!nh.has_parameter("blaze/cloud_transform"))
+    {
+        nh.template declare_parameter<std::vector<double>>("blaze/cloud_transform", std::vector<double>{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0});
+    }
+    
+    nh.get_parameter("blaze/cloud_transform", this->blaze_cloud_transform_);
+
+    // blaze/compute_normals
+    RCLCPP_DEBUG(LOGGER, "---> blaze/compute_normals");
+    
+    if (!nh.has_parameter("blaze/compute_normals"))
+    {
+        nh.template declare_parameter<bool>("blaze/compute_normals", false);
+    }
+    
+    nh.get_parameter("blaze/compute_normals", this->blaze_compute_normals_);
+
+    // blaze/normals_min_confidence
+    RCLCPP_DEBUG(LOGGER, "---> blaze/normals_min_confidence");
+    
+    if (!nh.has_parameter("blaze/normals_min_confidence"))
+    {
+        nh.template declare_parameter<int>("blaze/normals_min_confidence", 0);
+    }
+    
+    nh.get_parameter("blaze/normals_min_confidence", this->blaze_normals_min_confidence_);
+
+    // registration_channel
+    RCLCPP_DEBUG(LOGGER, "---> registration_channel");
+    
+    if (!nh.has_parameter("registration_channel"))
+    {
+        nh.template declare_parameter<std::string>("registration_channel", "");
+    }
+    
+    nh.get_parameter("registration_channel", this->registration_channel_);
+
+    // blaze/registration_transform
+    RCLCPP_DEBUG(LOGGER, "---> blaze/registration_transform");
+    
+    if (!nh.has_parameter("blaze/registration_transform"))
+    {
+        nh.template declare_parameter<std::vector<double>>("blaze/registration_transform", std::vector<double>{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0});
+    }
+    
+    nh.get_parameter("blaze/registration_transform", this->blaze_registration_transform_);
+
+    // blaze/registration_max_time_offset
+    RCLCPP_DEBUG(LOGGER, "---> blaze/registration_max_time_offset");
+    
+    if (!nh.has_parameter("blaze/registration_max_time_offset"))
+    {
+        nh.template declare_parameter<double>("blaze/registration_max_time_offset", 10.0);
+    }
+    
+    nh.get_parameter("blaze/registration_max_time_offset", this->blaze_registration_max_time_offset_);
+
+    // blaze/compression
+    RCLCPP_DEBUG(LOGGER, "---> blaze/compression");
+    
+    if (!nh.has_parameter("blaze/compression"))
+    {
+        nh.template declare_parameter<std::string>("blaze/compression", "");
+    }
+    
+    nh.get_parameter("blaze/compression", this->blaze_compression_);
+
+    // blaze/compression_level
+    RCLCPP_DEBUG(LOGGER, "---> blaze/compression_level");
+    
+    if (!nh.has_parameter("blaze/compression_level"))
+    {
+        nh.template declare_parameter<int>("blaze/compression_level", 1);
+    }
+    
+    nh.get_parameter("blaze/compression_level", this->blaze_compression_level_);
+
+    // blaze/compression_quantization
+    RCLCPP_DEBUG(LOGGER, "---> blaze/compression_quantization");
+    
+    if (!nh.has_parameter("blaze/compression_quantization"))
+    {
+        nh.template declare_parameter<double>("blaze/compression_quantization", 1.0);
+    }
+    
+    nh.get_parameter("blaze/compression_quantization", this->blaze_compression_quantization_);
+
+    // blaze/compression_threads
+    RCLCPP_DEBUG(LOGGER, "---> blaze/compression_threads");
+    
+    if (!nh.has_parameter("blaze/compression_threads"))
+    {
+        nh.template declare_parameter<int>("blaze/compression_threads", 2);
+    }
+    
+    nh.get_parameter("blaze/compression_threads", this->blaze_compression_threads_);
+
+    // compressed_format
+    RCLCPP_DEBUG(LOGGER, "---> compressed_format");
+    
+    if (!nh.has_parameter("compressed_format"))
+    {
+        nh.template declare_parameter<std::string>("compressed_format", "");
+    }
+    
+    nh.get_parameter("compressed_format", this->compressed_format_);
+
+    // compressed_jpeg_quality
+    RCLCPP_DEBUG(LOGGER, "---> compressed_jpeg_quality");
+    
+    if (!nh.has_parameter("compressed_jpeg_quality"))
+    {
+        nh.template declare_parameter<int>("compressed_jpeg_quality", 90);
+    }
+    
+    nh.get_parameter("compressed_jpeg_quality", this->compressed_jpeg_quality_);
+
+    // compressed_png_level
+    RCLCPP_DEBUG(LOGGER, "---> compressed_png_level");
+    
+    if (!nh.has_parameter("compressed_png_level"))
+    {
+        nh.template declare_parameter<int>("compressed_png_level", 1);
+    }
+    
+    nh.get_parameter("compressed_png_level", this->compressed_png_level_);
+
+    // compressed_threads
+    RCLCPP_DEBUG(LOGGER, "---> compressed_threads");
+    
+    if (!nh.has_parameter("compressed_threads"))
+    {
+        nh.template declare_parameter<int>("compressed_threads", 2);
+    }
+    
+    nh.get_parameter("compressed_threads", this->compressed_threads_);
+
+    // video/codec
+    RCLCPP_DEBUG(LOGGER, "---> video/codec");
+    
+    if (!nh.has_parameter("video/codec"))
+    {
+        nh.template declare_parameter<std::string>("video/codec", "");
+    }
+    
+    nh.get_parameter("video/codec", this->video_codec_);
+
+    // video/bitrate
+    RCLCPP_DEBUG(LOGGER, "---> video/bitrate");
+    
+    if (!nh.has_parameter("video/bitrate"))
+    {
+        nh.template declare_parameter<int>("video/bitrate", 1000);
+    }
+    
+    nh.get_parameter("video/bitrate", this->video_bitrate_);
+
+    // video/gop
+    RCLCPP_DEBUG(LOGGER, "---> video/gop");
+    
+    if (!nh.has_parameter("video/gop"))
+    {
+        nh.template declare_parameter<int>("video/gop", 30);
+    }
+    
+    nh.get_parameter("video/gop", this->video_gop_);
+
+    // video/preset
+    RCLCPP_DEBUG(LOGGER, "---> video/preset");
+    
+    if (!nh.has_parameter("video/preset"))
+    {
+        nh.template declare_parameter<std::string>("video/preset", "ultrafast");
+    }
+    
+    nh.get_parameter("video/preset", this->video_preset_);
+
+    // video/scale
+    RCLCPP_DEBUG(LOGGER, "---> video/scale");
+    
+    if (!nh.has_parameter("video/scale"))
+    {
+        nh.template declare_parameter<double>("video/scale", 1.0);
+    }
+    
+    nh.get_parameter("video/scale", this->video_scale_);
+
+    // shm/name
+    RCLCPP_DEBUG(LOGGER, "---> shm/name");
+    
+    if (!nh.has_parameter("shm/name"))
+    {
+        nh.template declare_parameter<std::string>("shm/name", "");
+    }
+    
+    nh.get_parameter("shm/name", this->shm_name_);
+
+    // shm/slots
+    RCLCPP_DEBUG(LOGGER, "---> shm/slots");
+    
+    if (!nh.has_parameter("shm/slots"))
+    {
+        nh.template declare_parameter<int>("shm/slots", 4);
+    }
+    
+    nh.get_parameter("shm/slots", this->shm_slots_);
+
+    // intra_process_images
+    RCLCPP_DEBUG(LOGGER, "---> intra_process_images");
+    
+    if (!nh.has_parameter("intra_process_images"))
+    {
+        nh.template declare_parameter<bool>("intra_process_images", false);
+    }
+    
+    nh.get_parameter("intra_process_images", this->intra_process_images_);
+
+    // sensor_correction_dir
+    RCLCPP_DEBUG(LOGGER, "---> sensor_correction_dir");
+    
+    if (!nh.has_parameter("sensor_correction_dir"))
+    {
+        nh.template declare_parameter<std::string>("sensor_correction_dir", "");
+    }
+    
+    nh.get_parameter("sensor_correction_dir", this->sensor_correction_dir_);
+
+    // tone_mapping/curve
+    RCLCPP_DEBUG(LOGGER, "---> tone_mapping/curve");
+    
+    if (!nh.has_parameter("tone_mapping/curve"))
+    {
+        nh.template declare_parameter<std::string>("tone_mapping/curve", "");
+    }
+    
+    nh.get_parameter("tone_mapping/curve", this->tone_mapping_curve_);
+
+    // tone_mapping/gamma
+    RCLCPP_DEBUG(LOGGER, "---> tone_mapping/gamma");
+    
+    if (!nh.has_parameter("tone_mapping/gamma"))
+    {
+        nh.template declare_parameter<double>("tone_mapping/gamma", 0.45);
+    }
+    
+    nh.get_parameter("tone_mapping/gamma", this->tone_mapping_gamma_);
+
+    // tone_mapping/lut_file
+    RCLCPP_DEBUG(LOGGER, "---> tone_mapping/lut_file");
+    
+    if (!nh.has_parameter("tone_mapping/lut_file"))
+    {
+        nh.template declare_parameter<std::string>("tone_mapping/lut_file", "");
+    }
+    
+    nh.get_parameter("tone_mapping/lut_file", this->tone_mapping_lut_file_);
+
+    // tone_mapping/on_camera
+    RCLCPP_DEBUG(LOGGER, "---> tone_mapping/on_camera");
+    
+    if (!nh.has_parameter("tone_mapping/on_camera"))
+    {
+        nh.template declare_parameter<bool>("tone_mapping/on_camera", false);
+    }
+    
+    nh.get_parameter("tone_mapping/on_camera", this->tone_mapping_on_camera_);
+
+    // tracking_roi/width
+    RCLCPP_DEBUG(LOGGER, "---> tracking_roi/width");
+    
+    if (!nh.has_parameter("tracking_roi/width"))
+    {
+        nh.template declare_parameter<int>("tracking_roi/width", 0);
+    }
+    
+    nh.get_parameter("tracking_roi/width", this->tracking_roi_width_);
+
+    // tracking_roi/height
+    RCLCPP_DEBUG(LOGGER, "---> tracking_roi/height");
+    
+    if (!nh.has_parameter("tracking_roi/height"))
+    {
+        nh.template declare_parameter<int>("tracking_roi/height", 0);
+    }
+    
+    nh.get_parameter("tracking_roi/height", this->tracking_roi_height_);
+
+    // multi_roi/rows
+    RCLCPP_DEBUG(LOGGER, "---> multi_roi/rows");
+    
+    if (!nh.has_parameter("multi_roi/rows"))
+    {
+        nh.template declare_parameter<std::vector<int64_t>>("multi_roi/rows", std::vector<int64_t>{});
+    }
+    
+    nh.get_parameter("multi_roi/rows", this->multi_roi_rows_);
+
+    // multi_roi/columns
+    RCLCPP_DEBUG(LOGGER, "---> multi_roi/columns");
+    
+    if (!nh.has_parameter("multi_roi/columns"))
+    {
+        nh.template declare_parameter<std::vector<int64_t>>("multi_roi/columns", std::vector<int64_t>{});
+    }
+    
+    nh.get_parameter("multi_roi/columns", this->multi_roi_columns_);
+
+    // fast_startup
+    RCLCPP_DEBUG(LOGGER, "---> fast_startup");
+    
+    if (!nh.has_parameter("fast_startup"))
+    {
+        nh.template declare_parameter<bool>("fast_startup", false);
+    }
+    
+    nh.get_parameter("fast_startup", this->fast_startup_);
+
+    // startup_snapshot_dir
+    RCLCPP_DEBUG(LOGGER, "---> startup_snapshot_dir");
+    
+    if (!nh.has_parameter("startup_snapshot_dir"))
+    {
+        nh.template declare_parameter<std::string>("startup_snapshot_dir", "");
+    }
+    
+    nh.get_parameter("startup_snapshot_dir", this->startup_snapshot_dir_);
+
     // shutter mode
     RCLCPP_DEBUG(LOGGER, "---> shutter_mode");
     
     if (!nh.has_parameter("shutter_mode"))
     {
-        nh.declare_parameter<std::string>("shutter_mode", "");
+        nh.template declare_parameter<std::string>("shutter_mode", "");
     }
     
     std::string shutter_param_string;
@@ -439,7 +1074,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
 
     if (!nh.has_parameter("auto_flash"))
     {
-        nh.declare_parameter<bool>("auto_flash", false);
+        nh.template declare_parameter<bool>("auto_flash", false);
     }
     
     nh.get_parameter("auto_flash", this->auto_flash_);
@@ -448,7 +1083,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("auto_flash_line_2"))
     {
-        nh.declare_parameter<bool>("auto_flash_line_2", true);
+        nh.template declare_parameter<bool>("auto_flash_line_2", true);
     }
     
     nh.get_parameter("auto_flash_line_2", this->auto_flash_line_2_);
@@ -457,7 +1092,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("auto_flash_line_3"))
     {
-        nh.declare_parameter<bool>("auto_flash_line_3", true);
+        nh.template declare_parameter<bool>("auto_flash_line_3", true);
     }
     
     nh.get_parameter("auto_flash_line_3", this->auto_flash_line_3_);
@@ -469,7 +1104,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
 
     if (!nh.has_parameter("grab_timeout"))
     {
-        nh.declare_parameter<int>("grab_timeout", 500);
+        nh.template declare_parameter<int>("grab_timeout", 500);
     }
     
     nh.get_parameter("grab_timeout", this->grab_timeout_);
@@ -479,7 +1114,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("trigger_timeout"))
     {
-        nh.declare_parameter<int>("trigger_timeout", 5000);
+        nh.template declare_parameter<int>("trigger_timeout", 5000);
     }
     
     nh.get_parameter("trigger_timeout", this->trigger_timeout_);
@@ -489,7 +1124,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("white_balance_auto"))
     {
-        nh.declare_parameter<int>("white_balance_auto", 0);
+        nh.template declare_parameter<int>("white_balance_auto", 0);
     }
     
     nh.get_parameter("white_balance_auto", this->white_balance_auto_);
@@ -499,7 +1134,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("white_balance_ratio_red"))
     {
-        nh.declare_parameter<float>("white_balance_ratio_red", 1.0);
+        nh.template declare_parameter<float>("white_balance_ratio_red", 1.0);
     }
     
     nh.get_parameter("white_balance_ratio_red", this->white_balance_ratio_red_);
@@ -509,7 +1144,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("white_balance_ratio_green"))
     {
-        nh.declare_parameter<float>("white_balance_ratio_green", 1.0);
+        nh.template declare_parameter<float>("white_balance_ratio_green", 1.0);
     }
     
     nh.get_parameter("white_balance_ratio_green", this->white_balance_ratio_green_);
@@ -519,7 +1154,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("white_balance_ratio_blue"))
     {
-        nh.declare_parameter<float>("white_balance_ratio_blue", 1.0);
+        nh.template declare_parameter<float>("white_balance_ratio_blue", 1.0);
     }
     
     nh.get_parameter("white_balance_ratio_blue", this->white_balance_ratio_blue_);
@@ -529,7 +1164,7 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     
     if (!nh.has_parameter("grab_strategy"))
     {
-        nh.declare_parameter<int>("grab_strategy", 0);
+        nh.template declare_parameter<int>("grab_strategy", 0);
     }
     
     nh.get_parameter("grab_strategy", this->grab_strategy_);
@@ -538,11 +1173,12 @@ void PylonROS2CameraParameter::readFromRosParameterServer(rclcpp::Node& nh)
     this->validateParameterSet(nh);
 }
 
-void PylonROS2CameraParameter::setDeviceUserId(rclcpp::Node& nh, const std::string& device_user_id)
+template <typename NodeT>
+void PylonROS2CameraParameter::setDeviceUserId(NodeT& nh, const std::string& device_user_id)
 {
     if (!nh.has_parameter("device_user_id"))
     {
-        nh.declare_parameter<std::string>("device_user_id", "");
+        nh.template declare_parameter<std::string>("device_user_id", "");
     }
 
     this->device_user_id_ = device_user_id;
@@ -550,7 +1186,8 @@ void PylonROS2CameraParameter::setDeviceUserId(rclcpp::Node& nh, const std::stri
     nh.set_parameter(rclcpp::Parameter("device_user_id", this->device_user_id_));
 }
 
-void PylonROS2CameraParameter::validateParameterSet(rclcpp::Node& nh)
+template <typename NodeT>
+void PylonROS2CameraParameter::validateParameterSet(NodeT& nh)
 {
     if (!this->device_user_id_.empty())
     {
@@ -594,6 +1231,228 @@ void PylonROS2CameraParameter::validateParameterSet(rclcpp::Node& nh)
         RCLCPP_WARN_STREAM(LOGGER, "The specified exposure search timeout value - " << this->exposure_search_timeout_ << " - is too low!"
                                 << "-> Exposure search may fail.");
     }
+
+    if (!this->blaze_cloud_frame_.empty())
+    {
+        const std::vector<double>& tf = this->blaze_cloud_transform_;
+        if (tf.size() != 7 || (tf[3] * tf[3] + tf[4] * tf[4] + tf[5] * tf[5] + tf[6] * tf[6]) < 1e-12)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified blaze cloud transform is not valid, [x, y, z, qx, qy, qz, qw] with a non-zero quaternion is expected!"
+                                    << "-> The point cloud will be published in the camera frame.");
+            this->blaze_cloud_frame_ = "";
+        }
+    }
+
+    if (!this->registration_channel_.empty())
+    {
+        const std::vector<double>& tf = this->blaze_registration_transform_;
+        if (tf.size() != 7 || (tf[3] * tf[3] + tf[4] * tf[4] + tf[5] * tf[5] + tf[6] * tf[6]) < 1e-12)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified blaze registration transform is not valid, [x, y, z, qx, qy, qz, qw] with a non-zero quaternion is expected!"
+                                    << "-> The identity is used.");
+            this->blaze_registration_transform_ = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0};
+        }
+
+        if (this->blaze_registration_max_time_offset_ < 0.0)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified blaze registration max time offset - " << this->blaze_registration_max_time_offset_
+                                    << " - is negative! -> Setting it to default value (10.0 ms).");
+            this->blaze_registration_max_time_offset_ = 10.0;
+        }
+    }
+
+    if (!this->blaze_compression_.empty())
+    {
+        if (this->blaze_compression_ != "lz4" && this->blaze_compression_ != "zstd")
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified blaze compression - " << this->blaze_compression_ << " - is not supported (lz4 or zstd)!"
+                                    << "-> There will be no compressed output.");
+            this->blaze_compression_ = "";
+        }
+
+        if (this->blaze_compression_quantization_ < 0.0)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified blaze compression quantization - " << this->blaze_compression_quantization_
+                                    << " - is negative! -> Setting it to default value (1.0 mm).");
+            this->blaze_compression_quantization_ = 1.0;
+        }
+
+        if (this->blaze_compression_threads_ < 1)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified number of blaze compression threads - " << this->blaze_compression_threads_
+                                    << " - is too low! -> Setting it to 1.");
+            this->blaze_compression_threads_ = 1;
+        }
+    }
+
+    if (!this->compressed_format_.empty())
+    {
+        if (this->compressed_format_ != "jpeg" && this->compressed_format_ != "png")
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified compressed image format - " << this->compressed_format_ << " - is not supported (jpeg or png)!"
+                                    << "-> There will be no compressed output.");
+            this->compressed_format_ = "";
+        }
+
+        if (this->compressed_jpeg_quality_ < 1 || this->compressed_jpeg_quality_ > 100)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified compressed jpeg quality - " << this->compressed_jpeg_quality_
+                                    << " - is out of range (1 - 100)! -> Setting it to default value (90).");
+            this->compressed_jpeg_quality_ = 90;
+        }
+
+        if (this->compressed_png_level_ < 0 || this->compressed_png_level_ > 9)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified compressed png level - " << this->compressed_png_level_
+                                    << " - is out of range (0 - 9)! -> Setting it to default value (1).");
+            this->compressed_png_level_ = 1;
+        }
+
+        if (this->compressed_threads_ < 1)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified number of compressed image threads - " << this->compressed_threads_
+                                    << " - is too low! -> Setting it to 1.");
+            this->compressed_threads_ = 1;
+        }
+    }
+
+    if (!this->video_codec_.empty())
+    {
+        if (this->video_codec_ != "h264" && this->video_codec_ != "h265")
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified video codec - " << this->video_codec_ << " - is not supported (h264 or h265)!"
+                                    << "-> There will be no video output.");
+            this->video_codec_ = "";
+        }
+
+        if (this->video_bitrate_ < 1)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified video bitrate - " << this->video_bitrate_
+                                    << " - is too low! -> Setting it to default value (1000 kbit/s).");
+            this->video_bitrate_ = 1000;
+        }
+
+        if (this->video_gop_ < 1)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified video gop - " << this->video_gop_
+                                    << " - is too low! -> Setting it to default value (30).");
+            this->video_gop_ = 30;
+        }
+
+        if (this->video_scale_ <= 0.0 || this->video_scale_ > 1.0)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified video scale - " << this->video_scale_
+                                    << " - is out of range (0 - 1]! -> Setting it to default value (1.0).");
+            this->video_scale_ = 1.0;
+        }
+    }
+
+    if (!this->shm_name_.empty())
+    {
+        if (this->shm_name_[0] != '/' || this->shm_name_.size() < 2 || this->shm_name_.find('/', 1) != std::string::npos)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified shared-memory name - " << this->shm_name_ << " - is not valid ('/name' expected)!"
+                                    << "-> There will be no shared-memory output.");
+            this->shm_name_ = "";
+        }
+
+        if (this->shm_slots_ < 2)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified number of shared-memory slots - " << this->shm_slots_
+                                    << " - is too low! -> Setting it to 2.");
+            this->shm_slots_ = 2;
+        }
+    }
+
+    if (!this->tone_mapping_curve_.empty())
+    {
+        if (this->tone_mapping_curve_ != "gamma" && this->tone_mapping_curve_ != "log" && this->tone_mapping_curve_ != "file")
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified tone mapping curve - " << this->tone_mapping_curve_ << " - is not supported (gamma, log or file)!"
+                                    << "-> There will be no tone mapping.");
+            this->tone_mapping_curve_ = "";
+        }
+        else if (this->tone_mapping_curve_ == "file" && this->tone_mapping_lut_file_.empty())
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The tone mapping curve is read from a file, but no tone_mapping/lut_file is specified!"
+                                    << "-> There will be no tone mapping.");
+            this->tone_mapping_curve_ = "";
+        }
+
+        if (this->tone_mapping_gamma_ <= 0.0)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified tone mapping gamma - " << this->tone_mapping_gamma_
+                                    << " - is too low! -> Setting it to default value (0.45).");
+            this->tone_mapping_gamma_ = 0.45;
+        }
+    }
+
+    if (this->tracking_roi_width_ > 0 || this->tracking_roi_height_ > 0)
+    {
+        if (this->tracking_roi_width_ <= 0 || this->tracking_roi_height_ <= 0)
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified tracking window - " << this->tracking_roi_width_ << "x" << this->tracking_roi_height_
+                                    << " - is not valid! -> There will be no tracking.");
+            this->tracking_roi_width_ = 0;
+            this->tracking_roi_height_ = 0;
+        }
+        else if (!this->sensor_correction_dir_.empty())
+        {
+            // the correction maps are selected per sensor geometry, not per frame
+            RCLCPP_WARN_STREAM(LOGGER, "The sensor correction can't follow the tracking window! -> There will be no sensor correction.");
+            this->sensor_correction_dir_ = "";
+        }
+    }
+
+    // the zones are (offset, size) pairs, in increasing order and without overlap
+    const auto are_zones_valid = [](const std::vector<int64_t>& zones)
+    {
+        if (zones.size() % 2 != 0)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < zones.size(); i += 2)
+        {
+            if (zones[i] < 0 || zones[i + 1] <= 0 || (i >= 2 && zones[i] < zones[i - 2] + zones[i - 1]))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (!this->multi_roi_rows_.empty() || !this->multi_roi_columns_.empty())
+    {
+        if (!are_zones_valid(this->multi_roi_rows_) || !are_zones_valid(this->multi_roi_columns_))
+        {
+            RCLCPP_WARN_STREAM(LOGGER, "The specified multiple ROI zones are not valid ([offset, size, ...] in increasing order, without overlap expected)!"
+                                    << "-> There will be no multiple ROI.");
+            this->multi_roi_rows_.clear();
+            this->multi_roi_columns_.clear();
+        }
+        else
+        {
+            if (this->tracking_roi_width_ > 0)
+            {
+                RCLCPP_WARN_STREAM(LOGGER, "The tracking window can't be combined with the multiple ROI! -> There will be no tracking.");
+                this->tracking_roi_width_ = 0;
+                this->tracking_roi_height_ = 0;
+            }
+            if (!this->sensor_correction_dir_.empty())
+            {
+                // the compact frame of the zones has no sensor geometry of its own
+                RCLCPP_WARN_STREAM(LOGGER, "The sensor correction can't be combined with the multiple ROI! -> There will be no sensor correction.");
+                this->sensor_correction_dir_ = "";
+            }
+        }
+    }
+
+    if (this->tone_mapping_on_camera_ && !this->tone_mapping_curve_.empty() && !this->sensor_correction_dir_.empty())
+    {
+        // the dark and flat frames are applied to the linear pixel values, before the curve
+        RCLCPP_WARN_STREAM(LOGGER, "The tone mapping curve can't be loaded into the camera with the sensor correction! -> It is applied by the host.");
+        this->tone_mapping_on_camera_ = false;
+    }
 }
 
 const std::string& PylonROS2CameraParameter::deviceUserID() const
@@ -621,16 +1480,54 @@ std::string PylonROS2CameraParameter::shutterModeString() const
     }
 }
 
+template <typename NodeT>
+std::string PylonROS2CameraParameter::startupSettingsHash(NodeT& nh) const
+{
+    // every parameter of the node is part of the key: the snapshot is taken once the complete
+    // startup configuration is applied, so any of them may have left its trace in the camera.
+    // The parameters the node itself rewrites while running (frame rate clamped to the camera limit,
+    // encoding and device user id read back from the camera, camera info url set by a service) are
+    // left out, otherwise the key would differ from one start to the next.
+    static const std::set<std::string> runtime_written = {"frame_rate", "image_encoding", "device_user_id", "camera_info_url"};
+    std::vector<std::string> names = nh.list_parameters({}, 0).names;
+    std::sort(names.begin(), names.end());
+
+    std::ostringstream settings;
+    for (const std::string& name : names)
+    {
+        if (runtime_written.count(name) > 0)
+        {
+            continue;
+        }
+        const rclcpp::Parameter parameter = nh.get_parameter(name);
+        settings << name << "=" << parameter.get_type_name() << ":" << parameter.value_to_string() << ";";
+    }
+
+    // 64 bit FNV-1a, unlike std::hash stable across builds and standard libraries
+    const std::string serialized = settings.str();
+    uint64_t hash_value = 14695981039346656037ULL;
+    for (const char c : serialized)
+    {
+        hash_value ^= static_cast<uint8_t>(c);
+        hash_value *= 1099511628211ULL;
+    }
+
+    std::ostringstream hash;
+    hash << std::hex << std::setw(16) << std::setfill('0') << hash_value;
+    return hash.str();
+}
+
 const std::string& PylonROS2CameraParameter::imageEncoding() const
 {
     return this->image_encoding_;
 }
 
-void PylonROS2CameraParameter::setimageEncodingParam(rclcpp::Node& nh, const std::string& format) 
+template <typename NodeT>
+void PylonROS2CameraParameter::setimageEncodingParam(NodeT& nh, const std::string& format) 
 {
     if (!nh.has_parameter("image_encoding"))
     {
-        nh.declare_parameter<std::string>("image_encoding", "");
+        nh.template declare_parameter<std::string>("image_encoding", "");
     }
 
     this->image_encoding_ = format;
@@ -648,11 +1545,12 @@ const double& PylonROS2CameraParameter::frameRate() const
     return this->frame_rate_;
 }
 
-void PylonROS2CameraParameter::setFrameRate(rclcpp::Node& nh, const double& frame_rate)
+template <typename NodeT>
+void PylonROS2CameraParameter::setFrameRate(NodeT& nh, const double& frame_rate)
 {
     if (!nh.has_parameter("frame_rate"))
     {
-        nh.declare_parameter<double>("frame_rate", 5.0);
+        nh.template declare_parameter<double>("frame_rate", 5.0);
     }
 
     this->frame_rate_ = frame_rate;
@@ -665,11 +1563,12 @@ const std::string& PylonROS2CameraParameter::cameraInfoURL() const
     return this->camera_info_url_;
 }
 
-void PylonROS2CameraParameter::setCameraInfoURL(rclcpp::Node& nh, const std::string& camera_info_url)
+template <typename NodeT>
+void PylonROS2CameraParameter::setCameraInfoURL(NodeT& nh, const std::string& camera_info_url)
 {
     if (!nh.has_parameter("camera_info_url"))
     {
-        nh.declare_parameter<std::string>("camera_info_url", "");
+        nh.template declare_parameter<std::string>("camera_info_url", "");
     }
 
     this->camera_info_url_ = camera_info_url;
@@ -677,4 +1576,21 @@ void PylonROS2CameraParameter::setCameraInfoURL(rclcpp::Node& nh, const std::str
     nh.set_parameter(rclcpp::Parameter("camera_info_url", this->camera_info_url_));
 }
 
+// explicit instantiations for the supported node types
+template void PylonROS2CameraParameter::readFromRosParameterServer<rclcpp::Node>(rclcpp::Node& nh);
+template void PylonROS2CameraParameter::setDeviceUserId<rclcpp::Node>(rclcpp::Node& nh, const std::string& device_user_id);
+template void PylonROS2CameraParameter::validateParameterSet<rclcpp::Node>(rclcpp::Node& nh);
+template void PylonROS2CameraParameter::setimageEncodingParam<rclcpp::Node>(rclcpp::Node& nh, const std::string& format);
+template void PylonROS2CameraParameter::setFrameRate<rclcpp::Node>(rclcpp::Node& nh, const double& frame_rate);
+template void PylonROS2CameraParameter::setCameraInfoURL<rclcpp::Node>(rclcpp::Node& nh, const std::string& camera_info_url);
+template std::string PylonROS2CameraParameter::startupSettingsHash<rclcpp::Node>(rclcpp::Node& nh) const;
+
+template void PylonROS2CameraParameter::readFromRosParameterServer<rclcpp_lifecycle::LifecycleNode>(rclcpp_lifecycle::LifecycleNode& nh);
+template void PylonROS2CameraParameter::setDeviceUserId<rclcpp_lifecycle::LifecycleNode>(rclcpp_lifecycle::LifecycleNode& nh, const std::string& device_user_id);
+template void PylonROS2CameraParameter::validateParameterSet<rclcpp_lifecycle::LifecycleNode>(rclcpp_lifecycle::LifecycleNode& nh);
+template void PylonROS2CameraParameter::setimageEncodingParam<rclcpp_lifecycle::LifecycleNode>(rclcpp_lifecycle::LifecycleNode& nh, const std::string& format);
+template void PylonROS2CameraParameter::setFrameRate<rclcpp_lifecycle::LifecycleNode>(rclcpp_lifecycle::LifecycleNode& nh, const double& frame_rate);
+template void PylonROS2CameraParameter::setCameraInfoURL<rclcpp_lifecycle::LifecycleNode>(rclcpp_lifecycle::LifecycleNode& nh, const std::string& camera_info_url);
+template std::string PylonROS2CameraParameter::startupSettingsHash<rclcpp_lifecycle::LifecycleNode>(rclcpp_lifecycle::LifecycleNode& nh) const;
+
 }  // namespace pylon_ros2_camera
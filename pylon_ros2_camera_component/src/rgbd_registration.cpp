@@ -0,0 +1,323 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "rgbd_registration.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include <rclcpp/logging.hpp>
+#include <rclcpp/time.hpp>
+#include <sensor_msgs/image_encodings.hpp>
+
+
+namespace pylon_ros2_camera
+{
+
+namespace
+{
+    static const rclcpp::Logger LOGGER_REGISTRATION = rclcpp::get_logger("basler.pylon.ros2.rgbd_registration");
+
+    // byte offsets of the red, the two green and the blue samples in the color cell of a pixel,
+    // relative to the cell origin; a bayer cell is 2x2 pixels, the other cells are a single pixel
+    struct CellLayout
+    {
+        int64_t r, g1, g2, b;
+        size_t bytes_per_pixel;
+        bool is_bayer;
+    };
+
+    bool cellLayout(const std::string& encoding, const int64_t& step, CellLayout& layout)
+    {
+        namespace enc = sensor_msgs::image_encodings;
+
+        if (encoding == enc::RGB8)           layout = {0, 1, 1, 2, 3, false};
+        else if (encoding == enc::BGR8)      layout = {2, 1, 1, 0, 3, false};
+        else if (encoding == enc::MONO8)     layout = {0, 0, 0, 0, 1, false};
+        else if (encoding == enc::BAYER_RGGB8) layout = {0, 1, step, step + 1, 1, true};
+        else if (encoding == enc::BAYER_BGGR8) layout = {step + 1, 1, step, 0, 1, true};
+        else if (encoding == enc::BAYER_GBRG8) layout = {step, 0, step + 1, 1, 1, true};
+        else if (encoding == enc::BAYER_GRBG8) layout = {1, 0, step + 1, step, 1, true};
+        else return false;
+
+        return true;
+    }
+}
+
+std::shared_ptr<ColorFrameChannel> ColorFrameChannel::get(const std::string& name)
+{
+    // channels shared by all camera nodes of the process
+    static std::mutex channels_mutex;
+    static std::map<std::string, std::shared_ptr<ColorFrameChannel>> channels;
+
+    std::lock_guard<std::mutex> lock(channels_mutex);
+    std::shared_ptr<ColorFrameChannel>& channel = channels[name];
+    if (!channel)
+    {
+        channel = std::make_shared<ColorFrameChannel>();
+    }
+    return channel;
+}
+
+ColorFrameChannel::ColorFrameChannel(const size_t& capacity)
+    : slots_(std::max<size_t>(capacity, 2))
+    , next_(0)
+    , consumers_(0)
+{}
+
+ColorFrameChannel::~ColorFrameChannel()
+{}
+
+void ColorFrameChannel::addConsumer()
+{
+    consumers_++;
+}
+
+void ColorFrameChannel::removeConsumer()
+{
+    consumers_--;
+}
+
+bool ColorFrameChannel::hasConsumers() const
+{
+    return consumers_.load() > 0;
+}
+
+bool ColorFrameChannel::post(const sensor_msgs::msg::Image& image, const sensor_msgs::msg::CameraInfo& cam_info)
+{
+    // only one node posts to a channel, the slot index is not contended
+    for (size_t attempt = 0; attempt < slots_.size(); ++attempt)
+    {
+        const size_t index = next_.load();
+        next_.store((index + 1) % slots_.size());
+
+        Slot& slot = slots_[index];
+        std::unique_lock<std::mutex> lock(slot.mutex, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            // being read by the registration, the next slot is used
+            continue;
+        }
+
+        ColorFrame& frame = slot.frame;
+        frame.stamp_ns = rclcpp::Time(image.header.stamp).nanoseconds();
+        frame.width = image.width;
+        frame.height = image.height;
+        frame.step = image.step;
+        frame.encoding = image.encoding;
+        frame.data.assign(image.data.begin(), image.data.end());
+        std::copy(cam_info.k.begin(), cam_info.k.end(), frame.k.begin());
+        frame.d.fill(0.0);
+        if (cam_info.distortion_model == "plumb_bob" || cam_info.distortion_model == "rational_polynomial")
+        {
+            // the rational polynomial coefficients beyond k3 are ignored
+            std::copy(cam_info.d.begin(), cam_info.d.begin() + std::min<size_t>(cam_info.d.size(), 5), frame.d.begin());
+        }
+        frame.calibration_width = cam_info.width;
+        frame.calibration_height = cam_info.height;
+        slot.stamp_ns.store(frame.stamp_ns);
+
+        return true;
+    }
+
+    return false;
+}
+
+RGBDRegistration::RGBDRegistration()
+    : channel_(nullptr)
+    , rotation_{0.001f, 0.0f, 0.0f, 0.0f, 0.001f, 0.0f, 0.0f, 0.0f, 0.001f}
+    , translation_{0.0f, 0.0f, 0.0f}
+    , max_time_offset_ns_(0)
+    , pixel_offsets_()
+    , clock_(RCL_STEADY_TIME)
+{}
+
+RGBDRegistration::~RGBDRegistration()
+{
+    disable();
+}
+
+void RGBDRegistration::enable(const std::string& channel_name, const std::vector<double>& transform, const double& max_time_offset_ms)
+{
+    disable();
+
+    // validated while reading the parameters
+    const std::vector<double>& tf = transform;
+    const double norm = std::sqrt(tf[3] * tf[3] + tf[4] * tf[4] + tf[5] * tf[5] + tf[6] * tf[6]);
+    const double x = tf[3] / norm, y = tf[4] / norm, z = tf[5] / norm, w = tf[6] / norm;
+    // rotation matrix of the quaternion, scaled from mm to m
+    const double rotation[9] = {1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y - z * w), 2.0 * (x * z + y * w),
+                                2.0 * (x * y + z * w), 1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z - x * w),
+                                2.0 * (x * z - y * w), 2.0 * (y * z + x * w), 1.0 - 2.0 * (x * x + y * y)};
+    for (size_t i = 0; i < 9; ++i)
+    {
+        rotation_[i] = static_cast<float>(rotation[i] * 0.001);
+    }
+    for (size_t i = 0; i < 3; ++i)
+    {
+        translation_[i] = static_cast<float>(tf[i]);
+    }
+    max_time_offset_ns_ = static_cast<int64_t>(max_time_offset_ms * 1e6);
+
+    channel_ = ColorFrameChannel::get(channel_name);
+    channel_->addConsumer();
+}
+
+void RGBDRegistration::disable()
+{
+    if (channel_)
+    {
+        channel_->removeConsumer();
+        channel_.reset();
+    }
+}
+
+bool RGBDRegistration::isEnabled() const
+{
+    return channel_ != nullptr;
+}
+
+bool RGBDRegistration::colorize(const float* xyz, const size_t& size, const int64_t& stamp_ns, uint8_t* prgba, const size_t& point_step)
+{
+    if (!channel_)
+    {
+        return false;
+    }
+
+    bool is_gathered = false;
+    const bool is_found = channel_->visitClosest(stamp_ns, max_time_offset_ns_, [&](const ColorFrame& frame)
+    {
+        is_gathered = gather(frame, xyz, size, prgba, point_step);
+    });
+
+    if (!is_found)
+    {
+        RCLCPP_WARN_STREAM_THROTTLE(LOGGER_REGISTRATION, clock_, 5000, "No color frame within " << max_time_offset_ns_ / 1000000.0
+                                     << " ms of the blaze frame, the point cloud is not colored. Are both cameras synchronized (PTP) and "
+                                     << "are the chunk timestamps of the color camera enabled?");
+    }
+
+    return is_gathered;
+}
+
+bool RGBDRegistration::gather(const ColorFrame& frame, const float* xyz, const size_t& size, uint8_t* prgba, const size_t& point_step)
+{
+    CellLayout layout;
+    if (!cellLayout(frame.encoding, frame.step, layout))
+    {
+        RCLCPP_WARN_STREAM_ONCE(LOGGER_REGISTRATION, "The color image encoding " << frame.encoding << " is not supported by the registration, "
+                                << "rgb8, bgr8, mono8 or an 8 bit bayer encoding is expected");
+        return false;
+    }
+
+    if (frame.k[0] <= 0.0 || frame.k[4] <= 0.0)
+    {
+        RCLCPP_WARN_ONCE(LOGGER_REGISTRATION, "The color camera is not calibrated, the point cloud cannot be registered");
+        return false;
+    }
+
+    if ((frame.calibration_width != 0 && frame.calibration_width != frame.width) ||
+        (frame.calibration_height != 0 && frame.calibration_height != frame.height))
+    {
+        RCLCPP_WARN_STREAM_ONCE(LOGGER_REGISTRATION, "The color image size (" << frame.width << "x" << frame.height
+                                << ") does not match its calibration (" << frame.calibration_width << "x" << frame.calibration_height
+                                << "), the point cloud cannot be registered");
+        return false;
+    }
+
+    // the offsets keep their capacity from frame to frame
+    pixel_offsets_.resize(size);
+
+    // first pass: projection of the points into the color image, branch-free so that the
+    // compiler vectorizes it; invalid (NaN) points, points behind the color camera and
+    // points outside the image end up with a negative offset
+    {
+        const float* __restrict__ src = xyz;
+        int64_t* __restrict__ dst = pixel_offsets_.data();
+        const float* r = rotation_;
+        const float* t = translation_;
+        const float fx = frame.k[0], cx = frame.k[2], fy = frame.k[4], cy = frame.k[5];
+        const float k1 = frame.d[0], k2 = frame.d[1], p1 = frame.d[2], p2 = frame.d[3], k3 = frame.d[4];
+        // a bayer pixel is looked up in the cell it belongs to
+        const float cell = layout.is_bayer ? 2.0f : 1.0f;
+        const float max_u = static_cast<float>(frame.width / static_cast<uint32_t>(cell)) * cell;
+        const float max_v = static_cast<float>(frame.height / static_cast<uint32_t>(cell)) * cell;
+        const int64_t step = frame.step;
+        const int64_t bytes_per_pixel = layout.bytes_per_pixel;
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            const float x = src[3 * i], y = src[3 * i + 1], z = src[3 * i + 2];
+            const float xc = r[0] * x + r[1] * y + r[2] * z + t[0];
+            const float yc = r[3] * x + r[4] * y + r[5] * z + t[1];
+            const float zc = r[6] * x + r[7] * y + r[8] * z + t[2];
+
+            const float xn = xc / zc, yn = yc / zc;
+            const float r2 = xn * xn + yn * yn;
+            const float radial = 1.0f + r2 * (k1 + r2 * (k2 + r2 * k3));
+            const float xd = xn * radial + 2.0f * p1 * xn * yn + p2 * (r2 + 2.0f * xn * xn);
+            const float yd = yn * radial + p1 * (r2 + 2.0f * yn * yn) + 2.0f * p2 * xn * yn;
+            // the pixel centers are at integer coordinates
+            const float u = fx * xd + cx + 0.5f;
+            const float v = fy * yd + cy + 0.5f;
+
+            // comparisons with NaN are false
+            const bool is_visible = zc > 0.0f && u >= 0.0f && u < max_u && v >= 0.0f && v < max_v;
+            const int64_t ui = is_visible ? static_cast<int64_t>(u / cell) : 0;
+            const int64_t vi = is_visible ? static_cast<int64_t>(v / cell) : 0;
+            const int64_t offset = vi * static_cast<int64_t>(cell) * step + ui * static_cast<int64_t>(cell) * bytes_per_pixel;
+            dst[i] = is_visible ? offset : -1;
+        }
+    }
+
+    // second pass: gather of the colors
+    {
+        const uint8_t* color = frame.data.data();
+        const int64_t* offsets = pixel_offsets_.data();
+        for (size_t i = 0; i < size; ++i, prgba += point_step)
+        {
+            const int64_t offset = offsets[i];
+            if (offset < 0)
+            {
+                continue;
+            }
+
+            const uint8_t* pcell = color + offset;
+            // pcl stores the color as b, g, r, a
+            prgba[0] = pcell[layout.b];
+            prgba[1] = static_cast<uint8_t>((pcell[layout.g1] + pcell[layout.g2]) >> 1);
+            prgba[2] = pcell[layout.r];
+            prgba[3] = 255;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace pylon_ros2_camera
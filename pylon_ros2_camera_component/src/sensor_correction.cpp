@@ -0,0 +1,287 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "sensor_correction.hpp"
+
+#include <cstring>
+#include <sstream>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <rclcpp/logging.hpp>
+
+
+namespace pylon_ros2_camera
+{
+
+namespace
+{
+    static const rclcpp::Logger LOGGER_CORRECTION = rclcpp::get_logger("basler.pylon.ros2.sensor_correction");
+
+    // fixed point flat-field gains, up to 16
+    static const int GAIN_BITS = 12;
+    static const uint32_t GAIN_ONE = 1 << GAIN_BITS;
+
+    // one pass over the frame, the variants without dark frame or gains don't read the missing map,
+    // the variant with a tone mapping table writes the 8 bit value of the corrected pixel
+    template <typename T, typename D, bool HAS_DARK, bool HAS_GAIN, bool HAS_LUT>
+    void correctPixels(const T* __restrict__ src, const T* __restrict__ dark, const uint16_t* __restrict__ gain,
+                       const uint8_t* __restrict__ lut, D* __restrict__ dst, const size_t& pixels,
+                       const uint32_t& max_value, const int& shift)
+    {
+        for (size_t i = 0; i < pixels; ++i)
+        {
+            int32_t value = src[i];
+            if (HAS_DARK)
+            {
+                value -= dark[i];
+                value = (value < 0) ? 0 : value;
+            }
+            uint32_t corrected = static_cast<uint32_t>(value);
+            if (HAS_GAIN)
+            {
+                corrected = (corrected * gain[i] + GAIN_ONE / 2) >> GAIN_BITS;
+                corrected = (corrected > max_value) ? max_value : corrected;
+            }
+            if (HAS_LUT)
+            {
+                // the table has max_value + 1 entries
+                corrected = (corrected > max_value) ? max_value : corrected;
+                dst[i] = static_cast<D>(lut[corrected]);
+            }
+            else
+            {
+                dst[i] = static_cast<D>(corrected << shift);
+            }
+        }
+    }
+
+    template <typename T, typename D, bool HAS_LUT>
+    void correctFrame(const T* src, const std::vector<T>& dark, const std::vector<uint16_t>& gain, const uint8_t* lut,
+                      D* dst, const size_t& pixels, const uint32_t& max_value, const int& shift)
+    {
+        const bool has_dark = !dark.empty();
+        const bool has_gain = !gain.empty();
+        if (has_dark && has_gain)
+        {
+            correctPixels<T, D, true, true, HAS_LUT>(src, dark.data(), gain.data(), lut, dst, pixels, max_value, shift);
+        }
+        else if (has_dark)
+        {
+            correctPixels<T, D, true, false, HAS_LUT>(src, dark.data(), nullptr, lut, dst, pixels, max_value, shift);
+        }
+        else if (has_gain)
+        {
+            correctPixels<T, D, false, true, HAS_LUT>(src, nullptr, gain.data(), lut, dst, pixels, max_value, shift);
+        }
+        else
+        {
+            correctPixels<T, D, false, false, HAS_LUT>(src, nullptr, nullptr, lut, dst, pixels, max_value, shift);
+        }
+    }
+
+    // the defective pixels are sparse, they are replaced after the pass over the frame
+    template <typename T>
+    void replaceDefects(const std::vector<uint32_t>& defects, const size_t& width, const size_t& step, T* dst)
+    {
+        for (const uint32_t index : defects)
+        {
+            const size_t x = index % width;
+            const bool has_left = x >= step;
+            const bool has_right = x + step < width;
+            if (has_left && has_right)
+            {
+                dst[index] = static_cast<T>((static_cast<uint32_t>(dst[index - step]) + dst[index + step] + 1) / 2);
+            }
+            else if (has_left)
+            {
+                dst[index] = dst[index - step];
+            }
+            else if (has_right)
+            {
+                dst[index] = dst[index + step];
+            }
+        }
+    }
+}
+
+SensorCorrection::SensorCorrection() :
+    directory_(""),
+    geometry_(""),
+    width_(0),
+    height_(0),
+    dark8_(),
+    dark16_(),
+    gain_(),
+    defects_()
+{
+}
+
+void SensorCorrection::setDirectory(const std::string& directory)
+{
+    if (directory != directory_)
+    {
+        directory_ = directory;
+        this->clear();
+    }
+}
+
+bool SensorCorrection::isEnabled() const
+{
+    return !directory_.empty();
+}
+
+void SensorCorrection::clear()
+{
+    geometry_ = "";
+    width_ = 0;
+    height_ = 0;
+    dark8_.clear();
+    dark16_.clear();
+    gain_.clear();
+    defects_.clear();
+}
+
+bool SensorCorrection::select(const std::string& serial_number, const size_t& width, const size_t& height,
+                              const size_t& offset_x, const size_t& offset_y, const size_t& binning_x, const size_t& binning_y)
+{
+    if (directory_.empty())
+    {
+        return false;
+    }
+
+    std::ostringstream geometry;
+    geometry << serial_number << "/" << width << "x" << height << "+" << offset_x << "+" << offset_y
+             << "_" << binning_x << "x" << binning_y;
+    if (geometry.str() == geometry_)
+    {
+        return this->isActive();
+    }
+
+    this->clear();
+    geometry_ = geometry.str();
+    width_ = width;
+    height_ = height;
+
+    const std::string path = directory_ + "/" + geometry_ + "/";
+    const auto has_geometry = [&](const cv::Mat& map, const std::string& name)
+    {
+        if (map.empty())
+        {
+            return false;
+        }
+        if (static_cast<size_t>(map.cols) != width || static_cast<size_t>(map.rows) != height || map.channels() != 1)
+        {
+            RCLCPP_WARN_STREAM(LOGGER_CORRECTION, "The sensor correction map " << path << name << " is ignored, "
+                               << width << "x" << height << " single channel expected");
+            return false;
+        }
+        return true;
+    };
+
+    const cv::Mat dark = cv::imread(path + "dark.png", cv::IMREAD_UNCHANGED);
+    if (has_geometry(dark, "dark.png"))
+    {
+        // both depths are kept, the pixel format may change while the geometry stays
+        cv::Mat dark8;
+        cv::Mat dark16;
+        dark.convertTo(dark8, CV_8U);
+        dark.convertTo(dark16, CV_16U);
+        dark8_.assign(dark8.ptr<uint8_t>(), dark8.ptr<uint8_t>() + width * height);
+        dark16_.assign(dark16.ptr<uint16_t>(), dark16.ptr<uint16_t>() + width * height);
+    }
+
+    const cv::Mat flat = cv::imread(path + "flat.tiff", cv::IMREAD_UNCHANGED);
+    if (has_geometry(flat, "flat.tiff"))
+    {
+        cv::Mat gain;
+        flat.convertTo(gain, CV_16U, GAIN_ONE);
+        gain_.assign(gain.ptr<uint16_t>(), gain.ptr<uint16_t>() + width * height);
+    }
+
+    const cv::Mat defects = cv::imread(path + "defects.png", cv::IMREAD_GRAYSCALE);
+    if (has_geometry(defects, "defects.png"))
+    {
+        for (int y = 0; y < defects.rows; ++y)
+        {
+            const uint8_t* row = defects.ptr<uint8_t>(y);
+            for (int x = 0; x < defects.cols; ++x)
+            {
+                if (row[x] != 0)
+                {
+                    defects_.push_back(static_cast<uint32_t>(y * width + x));
+                }
+            }
+        }
+    }
+
+    if (this->isActive())
+    {
+        RCLCPP_INFO_STREAM(LOGGER_CORRECTION, "Sensor correction of " << geometry_ << ": "
+                           << (dark16_.empty() ? "no" : "a") << " dark frame, "
+                           << (gain_.empty() ? "no" : "a") << " flat field, "
+                           << defects_.size() << " defective pixel(s)");
+    }
+    else
+    {
+        RCLCPP_WARN_STREAM(LOGGER_CORRECTION, "No sensor correction map in " << path << ", the frames are not corrected");
+    }
+
+    return this->isActive();
+}
+
+bool SensorCorrection::isActive() const
+{
+    return !dark16_.empty() || !gain_.empty() || !defects_.empty();
+}
+
+size_t SensorCorrection::pixels() const
+{
+    return width_ * height_;
+}
+
+void SensorCorrection::apply(const uint8_t* src, uint8_t* dst, const bool& is_bayer) const
+{
+    correctFrame<uint8_t, uint8_t, false>(src, dark8_, gain_, nullptr, dst, this->pixels(), 0xFF, 0);
+    replaceDefects(defects_, width_, is_bayer ? 2 : 1, dst);
+}
+
+void SensorCorrection::apply(const uint16_t* src, uint16_t* dst, const uint32_t& max_value, const int& shift, const bool& is_bayer) const
+{
+    correctFrame<uint16_t, uint16_t, false>(src, dark16_, gain_, nullptr, dst, this->pixels(), max_value, shift);
+    replaceDefects(defects_, width_, is_bayer ? 2 : 1, dst);
+}
+
+void SensorCorrection::apply(const uint16_t* src, uint8_t* dst, const uint32_t& max_value, const uint8_t* lut, const bool& is_bayer) const
+{
+    correctFrame<uint16_t, uint8_t, true>(src, dark16_, gain_, lut, dst, this->pixels(), max_value, 0);
+    // the defective pixels are replaced by the mean of their mapped neighbours
+    replaceDefects(defects_, width_, is_bayer ? 2 : 1, dst);
+}
+
+}  // namespace pylon_ros2_camera
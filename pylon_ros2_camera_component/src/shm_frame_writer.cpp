@@ -0,0 +1,211 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "shm_frame_writer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <rclcpp/logging.hpp>
+
+
+namespace pylon_ros2_camera
+{
+
+namespace
+{
+    static const rclcpp::Logger LOGGER_SHM = rclcpp::get_logger("basler.pylon.ros2.shm_frame_ring");
+
+    void copyString(const std::string& src, char* dst, const size_t& size)
+    {
+        const size_t length = std::min(src.size(), size - 1);
+        std::memcpy(dst, src.data(), length);
+        std::memset(dst + length, 0, size - length);
+    }
+}
+
+ShmFrameWriter::ShmFrameWriter() :
+    name_(""),
+    slot_count_(0),
+    header_(nullptr),
+    ring_(nullptr),
+    ring_size_(0),
+    frame_count_(0)
+{
+}
+
+ShmFrameWriter::~ShmFrameWriter()
+{
+    this->stop();
+}
+
+bool ShmFrameWriter::start(const std::string& name, const int& slots)
+{
+    this->stop();
+
+    // POSIX shared-memory names start with a slash and have no other
+    if (name.size() < 2 || name[0] != '/' || name.find('/', 1) != std::string::npos)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_SHM, "Invalid shared-memory name: " << name << " ('/name' expected)");
+        return false;
+    }
+
+    name_ = name;
+    slot_count_ = std::max(slots, 2);
+    return true;
+}
+
+void ShmFrameWriter::stop()
+{
+    this->close();
+    name_ = "";
+}
+
+bool ShmFrameWriter::isStarted() const
+{
+    return !name_.empty();
+}
+
+bool ShmFrameWriter::create(const size_t& slot_size)
+{
+    this->close();
+
+    // readers still mapping a previous ring keep it until they reopen
+    shm_unlink(name_.c_str());
+    const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd < 0)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_SHM, "Failed to create the shared-memory object " << name_ << ": " << std::strerror(errno));
+        return false;
+    }
+
+    const size_t ring_size = shm_frame_ring::ringSize(slot_count_, slot_size);
+    if (ftruncate(fd, static_cast<off_t>(ring_size)) != 0)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_SHM, "Failed to size the shared-memory object " << name_ << ": " << std::strerror(errno));
+        ::close(fd);
+        shm_unlink(name_.c_str());
+        return false;
+    }
+
+    void* ring = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (ring == MAP_FAILED)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_SHM, "Failed to map the shared-memory object " << name_ << ": " << std::strerror(errno));
+        shm_unlink(name_.c_str());
+        return false;
+    }
+
+    // the new object is zero filled, i.e., all slots are empty
+    ring_ = static_cast<uint8_t*>(ring);
+    ring_size_ = ring_size;
+    header_ = reinterpret_cast<shm_frame_ring::RingHeader*>(ring_);
+    header_->version = shm_frame_ring::VERSION;
+    header_->slot_count = static_cast<uint32_t>(slot_count_);
+    header_->slot_size = slot_size;
+    header_->slot_stride = shm_frame_ring::slotStride(slot_size);
+    // the readers check the magic number last
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = shm_frame_ring::MAGIC;
+    frame_count_ = 0;
+
+    RCLCPP_INFO_STREAM(LOGGER_SHM, "Frames written to the shared-memory ring " << name_ << " ("
+                                   << slot_count_ << " slots of " << slot_size << " bytes)");
+    return true;
+}
+
+void ShmFrameWriter::close()
+{
+    if (header_ == nullptr)
+    {
+        return;
+    }
+
+    header_->is_closed.store(1, std::memory_order_release);
+    header_->notification.fetch_add(1, std::memory_order_seq_cst);
+    shm_frame_ring::futexWake(&header_->notification);
+
+    munmap(ring_, ring_size_);
+    shm_unlink(name_.c_str());
+    header_ = nullptr;
+    ring_ = nullptr;
+    ring_size_ = 0;
+}
+
+bool ShmFrameWriter::write(const sensor_msgs::msg::Image& image, const int64_t& frame_counter)
+{
+    if (!this->isStarted())
+    {
+        return false;
+    }
+
+    // a larger frame (ROI, binning or pixel format change) needs a new ring
+    if (header_ == nullptr || image.data.size() > header_->slot_size)
+    {
+        if (!this->create(image.data.size()))
+        {
+            // not retried before the next start
+            name_ = "";
+            return false;
+        }
+    }
+
+    const uint64_t index = frame_count_++;
+    shm_frame_ring::SlotHeader* slot = reinterpret_cast<shm_frame_ring::SlotHeader*>(
+        ring_ + shm_frame_ring::HEADER_SIZE + (index % header_->slot_count) * header_->slot_stride);
+
+    // odd sequence while the slot is written, the readers of the previous frame see it changed
+    slot->sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->stamp_ns = static_cast<int64_t>(image.header.stamp.sec) * 1000000000LL + image.header.stamp.nanosec;
+    slot->frame_counter = frame_counter;
+    slot->width = image.width;
+    slot->height = image.height;
+    slot->step = image.step;
+    slot->data_size = static_cast<uint32_t>(image.data.size());
+    slot->is_bigendian = image.is_bigendian;
+    copyString(image.encoding, slot->encoding, sizeof(slot->encoding));
+    copyString(image.header.frame_id, slot->frame_id, sizeof(slot->frame_id));
+    std::memcpy(reinterpret_cast<uint8_t*>(slot + 1), image.data.data(), image.data.size());
+
+    slot->sequence.store(2 * index + 2, std::memory_order_release);
+    header_->frame_count.store(index + 1, std::memory_order_release);
+
+    // no system call as long as no reader is waiting
+    header_->notification.fetch_add(1, std::memory_order_seq_cst);
+    if (header_->waiters.load(std::memory_order_seq_cst) > 0)
+    {
+        shm_frame_ring::futexWake(&header_->notification);
+    }
+
+    return true;
+}
+
+}  // namespace pylon_ros2_camera
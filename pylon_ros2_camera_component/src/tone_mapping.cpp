@@ -0,0 +1,190 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "tone_mapping.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+#include <rclcpp/logging.hpp>
+
+
+namespace pylon_ros2_camera
+{
+
+namespace
+{
+    static const rclcpp::Logger LOGGER_TONE_MAPPING = rclcpp::get_logger("basler.pylon.ros2.tone_mapping");
+
+    static const double MAX_VALUE = ToneMapping::TABLE_SIZE - 1;
+
+    bool readCurve(const std::string& lut_file, std::vector<double>& curve)
+    {
+        std::ifstream file(lut_file);
+        if (!file.is_open())
+        {
+            RCLCPP_ERROR_STREAM(LOGGER_TONE_MAPPING, "The tone mapping file " << lut_file << " can't be opened");
+            return false;
+        }
+
+        curve.clear();
+        std::string token;
+        while (file >> token)
+        {
+            // the values may be separated by commas as well
+            size_t begin = 0;
+            while (begin < token.size())
+            {
+                size_t end = token.find(',', begin);
+                end = (end == std::string::npos) ? token.size() : end;
+                if (end > begin)
+                {
+                    char* parsed_end = nullptr;
+                    const std::string value_str = token.substr(begin, end - begin);
+                    const long value = std::strtol(value_str.c_str(), &parsed_end, 10);
+                    if (*parsed_end != '\0' || value < 0 || value > 255)
+                    {
+                        RCLCPP_ERROR_STREAM(LOGGER_TONE_MAPPING, "The tone mapping file " << lut_file << " contains an invalid value ("
+                                            << value_str << "), 0 - 255 expected");
+                        return false;
+                    }
+                    curve.push_back(value / 255.0);
+                }
+                begin = end + 1;
+            }
+        }
+
+        if (curve.size() != ToneMapping::TABLE_SIZE)
+        {
+            RCLCPP_ERROR_STREAM(LOGGER_TONE_MAPPING, "The tone mapping file " << lut_file << " contains " << curve.size()
+                                << " values, " << ToneMapping::TABLE_SIZE << " expected");
+            return false;
+        }
+        return true;
+    }
+}
+
+const size_t ToneMapping::TABLE_SIZE;
+
+ToneMapping::ToneMapping() :
+    curve_(),
+    table_()
+{
+}
+
+bool ToneMapping::configure(const std::string& curve, const double& gamma, const std::string& lut_file)
+{
+    curve_.clear();
+    table_.clear();
+    if (curve.empty())
+    {
+        return true;
+    }
+
+    std::vector<double> values(TABLE_SIZE);
+    if (curve == "gamma")
+    {
+        for (size_t i = 0; i < TABLE_SIZE; ++i)
+        {
+            values[i] = std::pow(i / MAX_VALUE, gamma);
+        }
+    }
+    else if (curve == "log")
+    {
+        for (size_t i = 0; i < TABLE_SIZE; ++i)
+        {
+            values[i] = std::log1p(static_cast<double>(i)) / std::log1p(MAX_VALUE);
+        }
+    }
+    else if (curve == "file")
+    {
+        if (!readCurve(lut_file, values))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_TONE_MAPPING, "Unknown tone mapping curve: " << curve);
+        return false;
+    }
+
+    curve_ = values;
+    this->setAppliedOnCamera(false);
+    RCLCPP_INFO_STREAM(LOGGER_TONE_MAPPING, "The 12 bit formats are tone mapped to 8 bit with the " << curve << " curve");
+    return true;
+}
+
+bool ToneMapping::isEnabled() const
+{
+    return !table_.empty();
+}
+
+std::vector<uint16_t> ToneMapping::cameraTable() const
+{
+    std::vector<uint16_t> camera_table(curve_.size());
+    for (size_t i = 0; i < curve_.size(); ++i)
+    {
+        camera_table[i] = static_cast<uint16_t>(std::lround(curve_[i] * MAX_VALUE));
+    }
+    return camera_table;
+}
+
+void ToneMapping::setAppliedOnCamera(const bool& on_camera)
+{
+    if (curve_.empty())
+    {
+        return;
+    }
+
+    table_.resize(TABLE_SIZE);
+    for (size_t i = 0; i < TABLE_SIZE; ++i)
+    {
+        // the camera delivers the mapped values, they are only reduced to 8 bit
+        const double value = on_camera ? i / MAX_VALUE : curve_[i];
+        table_[i] = static_cast<uint8_t>(std::lround(value * 255.0));
+    }
+}
+
+const uint8_t* ToneMapping::table() const
+{
+    return table_.data();
+}
+
+void ToneMapping::apply(const uint16_t* src, uint8_t* dst, const size_t& pixels) const
+{
+    const uint8_t* lut = table_.data();
+    for (size_t i = 0; i < pixels; ++i)
+    {
+        // the 12 bit formats don't use the upper bits, they are masked to stay in the table
+        dst[i] = lut[src[i] & (TABLE_SIZE - 1)];
+    }
+}
+
+}  // namespace pylon_ros2_camera
@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+// decodes the video output of a camera node and republishes it as raw images:
+// ros2 run pylon_ros2_camera_component decode_video --ros-args -r video:=/my_camera/pylon_ros2_camera_node/video -r image:=/my_camera/video_decoded
+// parameter encoding: bgr8 (default), rgb8 or mono8
+
+#include <memory>
+#include <string>
+
+#include <rclcpp/rclcpp.hpp>
+#include <sensor_msgs/msg/image.hpp>
+
+#include "video_decoder.hpp"
+
+int main(int argc, char** argv)
+{
+    rclcpp::init(argc, argv);
+
+    auto node = std::make_shared<rclcpp::Node>("decode_video");
+    const std::string encoding = node->declare_parameter<std::string>("encoding", "bgr8");
+
+    auto image_pub = node->create_publisher<sensor_msgs::msg::Image>("image", 10);
+
+    pylon_ros2_camera::VideoDecoder decoder;
+    sensor_msgs::msg::Image image;
+    auto packet_sub = node->create_subscription<pylon_ros2_camera::VideoDecoder::VideoPacket>("video", 10,
+        [&](const pylon_ros2_camera::VideoDecoder::VideoPacket::ConstSharedPtr packet)
+        {
+            if (decoder.decode(*packet, image, encoding))
+            {
+                image_pub->publish(image);
+            }
+        });
+
+    rclcpp::spin(node);
+    rclcpp::shutdown();
+
+    return 0;
+}
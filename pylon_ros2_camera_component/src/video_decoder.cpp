@@ -0,0 +1,170 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "video_decoder.hpp"
+
+#include <cstring>
+
+#include <sensor_msgs/image_encodings.hpp>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+
+namespace pylon_ros2_camera
+{
+
+VideoDecoder::VideoDecoder() :
+    context_(nullptr),
+    frame_(nullptr),
+    packet_(nullptr),
+    scaler_(nullptr),
+    codec_(""),
+    width_(0),
+    height_(0),
+    buffer_()
+{
+}
+
+VideoDecoder::~VideoDecoder()
+{
+    this->close();
+}
+
+bool VideoDecoder::open(const VideoPacket& packet)
+{
+    this->close();
+
+    const AVCodec* codec = avcodec_find_decoder((packet.codec == "h265") ? AV_CODEC_ID_HEVC : AV_CODEC_ID_H264);
+    if (codec == nullptr || (packet.codec != "h264" && packet.codec != "h265"))
+    {
+        return false;
+    }
+
+    context_ = avcodec_alloc_context3(codec);
+    frame_ = av_frame_alloc();
+    packet_ = av_packet_alloc();
+    if (context_ == nullptr || frame_ == nullptr || packet_ == nullptr || avcodec_open2(context_, codec, nullptr) < 0)
+    {
+        this->close();
+        return false;
+    }
+
+    codec_ = packet.codec;
+    width_ = packet.width;
+    height_ = packet.height;
+    return true;
+}
+
+void VideoDecoder::close()
+{
+    sws_freeContext(scaler_);
+    scaler_ = nullptr;
+    av_packet_free(&packet_);
+    av_frame_free(&frame_);
+    avcodec_free_context(&context_);
+    codec_ = "";
+}
+
+bool VideoDecoder::decode(const VideoPacket& packet, sensor_msgs::msg::Image& image, const std::string& encoding)
+{
+    namespace enc = sensor_msgs::image_encodings;
+
+    AVPixelFormat output_format = AV_PIX_FMT_BGR24;
+    int channels = 3;
+    if (encoding == enc::RGB8)
+    {
+        output_format = AV_PIX_FMT_RGB24;
+    }
+    else if (encoding == enc::MONO8)
+    {
+        output_format = AV_PIX_FMT_GRAY8;
+        channels = 1;
+    }
+    else if (encoding != enc::BGR8)
+    {
+        return false;
+    }
+
+    // a new stream is joined at a key frame, which carries the parameter sets
+    if (context_ == nullptr || packet.codec != codec_ || packet.width != width_ || packet.height != height_)
+    {
+        if (!packet.is_keyframe || !this->open(packet))
+        {
+            return false;
+        }
+    }
+
+    buffer_.resize(packet.data.size() + AV_INPUT_BUFFER_PADDING_SIZE);
+    std::memcpy(buffer_.data(), packet.data.data(), packet.data.size());
+    std::memset(buffer_.data() + packet.data.size(), 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    packet_->data = buffer_.data();
+    packet_->size = static_cast<int>(packet.data.size());
+
+    const int sent = avcodec_send_packet(context_, packet_);
+    packet_->data = nullptr;
+    packet_->size = 0;
+    if (sent < 0)
+    {
+        return false;
+    }
+
+    // the encoder does not reorder the frames, a packet gives at most one frame
+    if (avcodec_receive_frame(context_, frame_) < 0)
+    {
+        return false;
+    }
+
+    scaler_ = sws_getCachedContext(scaler_, frame_->width, frame_->height, static_cast<AVPixelFormat>(frame_->format),
+                                   frame_->width, frame_->height, output_format, SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+    if (scaler_ == nullptr)
+    {
+        av_frame_unref(frame_);
+        return false;
+    }
+
+    image.header = packet.header;
+    image.height = frame_->height;
+    image.width = frame_->width;
+    image.encoding = (output_format == AV_PIX_FMT_BGR24) ? enc::BGR8 : encoding;
+    image.is_bigendian = false;
+    image.step = frame_->width * channels;
+    image.data.resize(static_cast<size_t>(image.step) * image.height);
+
+    uint8_t* const dst_data[4] = {image.data.data(), nullptr, nullptr, nullptr};
+    const int dst_stride[4] = {static_cast<int>(image.step), 0, 0, 0};
+    sws_scale(scaler_, frame_->data, frame_->linesize, 0, frame_->height, dst_data, dst_stride);
+    av_frame_unref(frame_);
+
+    return true;
+}
+
+}  // namespace pylon_ros2_camera
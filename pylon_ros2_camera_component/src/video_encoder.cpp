@@ -0,0 +1,363 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "video_encoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <rclcpp/logging.hpp>
+#include <sensor_msgs/image_encodings.hpp>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
+
+
+namespace pylon_ros2_camera
+{
+
+namespace
+{
+    static const rclcpp::Logger LOGGER_VIDEO = rclcpp::get_logger("basler.pylon.ros2.video_encoder");
+
+    AVPixelFormat pixelFormat(const std::string& encoding, const bool& is_bigendian)
+    {
+        namespace enc = sensor_msgs::image_encodings;
+
+        if (encoding == enc::MONO8)         return AV_PIX_FMT_GRAY8;
+        if (encoding == enc::MONO16)        return is_bigendian ? AV_PIX_FMT_GRAY16BE : AV_PIX_FMT_GRAY16LE;
+        if (encoding == enc::RGB8)          return AV_PIX_FMT_RGB24;
+        if (encoding == enc::BGR8)          return AV_PIX_FMT_BGR24;
+        if (encoding == enc::RGB16)         return is_bigendian ? AV_PIX_FMT_RGB48BE : AV_PIX_FMT_RGB48LE;
+        if (encoding == enc::BGR16)         return is_bigendian ? AV_PIX_FMT_BGR48BE : AV_PIX_FMT_BGR48LE;
+        if (encoding == enc::YUV422)        return AV_PIX_FMT_UYVY422;
+        if (encoding == enc::BAYER_RGGB8)   return AV_PIX_FMT_BAYER_RGGB8;
+        if (encoding == enc::BAYER_BGGR8)   return AV_PIX_FMT_BAYER_BGGR8;
+        if (encoding == enc::BAYER_GBRG8)   return AV_PIX_FMT_BAYER_GBRG8;
+        if (encoding == enc::BAYER_GRBG8)   return AV_PIX_FMT_BAYER_GRBG8;
+        if (encoding == enc::BAYER_RGGB16)  return is_bigendian ? AV_PIX_FMT_BAYER_RGGB16BE : AV_PIX_FMT_BAYER_RGGB16LE;
+        if (encoding == enc::BAYER_BGGR16)  return is_bigendian ? AV_PIX_FMT_BAYER_BGGR16BE : AV_PIX_FMT_BAYER_BGGR16LE;
+        if (encoding == enc::BAYER_GBRG16)  return is_bigendian ? AV_PIX_FMT_BAYER_GBRG16BE : AV_PIX_FMT_BAYER_GBRG16LE;
+        if (encoding == enc::BAYER_GRBG16)  return is_bigendian ? AV_PIX_FMT_BAYER_GRBG16BE : AV_PIX_FMT_BAYER_GRBG16LE;
+        return AV_PIX_FMT_NONE;
+    }
+
+    // the 4:2:0 chroma subsampling needs an even size
+    int scaledSize(const uint32_t& size, const double& scale)
+    {
+        return std::max(2, static_cast<int>(size * scale) & ~1);
+    }
+}
+
+VideoEncoder::VideoEncoder() :
+    codec_(""),
+    bitrate_(0),
+    gop_(0),
+    preset_(""),
+    scale_(1.0),
+    frame_rate_(0.0),
+    thread_setup_(),
+    publish_(),
+    pending_image_(),
+    has_pending_image_(false),
+    is_stopping_(false),
+    thread_(),
+    image_(),
+    context_(nullptr),
+    frame_(nullptr),
+    packet_(nullptr),
+    scaler_(nullptr),
+    input_encoding_(""),
+    input_width_(0),
+    input_height_(0),
+    pts_(0),
+    headers_(),
+    msg_(),
+    clock_(RCL_STEADY_TIME)
+{
+}
+
+VideoEncoder::~VideoEncoder()
+{
+    this->stop();
+}
+
+bool VideoEncoder::start(const std::string& codec, const int& bitrate, const int& gop, const std::string& preset,
+                         const double& scale, const double& frame_rate,
+                         const std::function<void()>& thread_setup, const PublishFunction& publish)
+{
+    this->stop();
+
+    if (codec != "h264" && codec != "h265")
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_VIDEO, "Unknown video codec: " << codec << " (h264 or h265 expected)");
+        return false;
+    }
+
+    codec_ = codec;
+    bitrate_ = std::max(bitrate, 1);
+    gop_ = std::max(gop, 1);
+    preset_ = preset;
+    scale_ = (scale > 0.0 && scale <= 1.0) ? scale : 1.0;
+    frame_rate_ = (frame_rate > 0.0) ? frame_rate : 10.0;
+    thread_setup_ = thread_setup;
+    publish_ = publish;
+
+    thread_ = std::thread(&VideoEncoder::work, this);
+
+    RCLCPP_INFO_STREAM(LOGGER_VIDEO, "Video encoded as " << codec_ << " at " << bitrate_ << " kbit/s, scale " << scale_);
+    return true;
+}
+
+void VideoEncoder::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_stopping_ = true;
+    }
+    condition_.notify_all();
+
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    has_pending_image_ = false;
+    is_stopping_ = false;
+}
+
+bool VideoEncoder::isStarted() const
+{
+    return thread_.joinable();
+}
+
+bool VideoEncoder::post(const sensor_msgs::msg::Image& image)
+{
+    if (!this->isStarted())
+    {
+        return false;
+    }
+
+    bool is_dropped = false;
+    {
+        // the encoder thread only swaps the frame out, the copy keeps the capacity of the buffer
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_dropped = has_pending_image_;
+        pending_image_.header = image.header;
+        pending_image_.height = image.height;
+        pending_image_.width = image.width;
+        pending_image_.encoding = image.encoding;
+        pending_image_.is_bigendian = image.is_bigendian;
+        pending_image_.step = image.step;
+        pending_image_.data.resize(image.data.size());
+        std::memcpy(pending_image_.data.data(), image.data.data(), image.data.size());
+        has_pending_image_ = true;
+    }
+    condition_.notify_one();
+
+    if (is_dropped)
+    {
+        RCLCPP_WARN_STREAM_THROTTLE(LOGGER_VIDEO, clock_, 5000, "The video encoding is too slow, frames are dropped");
+    }
+
+    return !is_dropped;
+}
+
+void VideoEncoder::work()
+{
+    if (thread_setup_)
+    {
+        thread_setup_();
+    }
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return is_stopping_ || has_pending_image_; });
+            if (is_stopping_)
+            {
+                break;
+            }
+            std::swap(image_, pending_image_);
+            has_pending_image_ = false;
+        }
+
+        this->encode(image_);
+    }
+
+    this->close();
+}
+
+bool VideoEncoder::open(const sensor_msgs::msg::Image& image)
+{
+    this->close();
+
+    // failures are only reported once per input format
+    input_encoding_ = image.encoding;
+    input_width_ = image.width;
+    input_height_ = image.height;
+
+    const AVPixelFormat input_format = pixelFormat(image.encoding, image.is_bigendian);
+    if (input_format == AV_PIX_FMT_NONE)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_VIDEO, "Images of encoding " << image.encoding << " can't be encoded as video");
+        return false;
+    }
+
+    const AVCodec* codec = avcodec_find_encoder_by_name((codec_ == "h265") ? "libx265" : "libx264");
+    if (codec == nullptr)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_VIDEO, "The libavcodec library has no " << codec_ << " software encoder");
+        return false;
+    }
+
+    const int width = scaledSize(image.width, scale_);
+    const int height = scaledSize(image.height, scale_);
+
+    context_ = avcodec_alloc_context3(codec);
+    context_->width = width;
+    context_->height = height;
+    context_->pix_fmt = AV_PIX_FMT_YUV420P;
+    context_->framerate = av_d2q(frame_rate_, 1000);
+    context_->time_base = av_inv_q(context_->framerate);
+    context_->bit_rate = static_cast<int64_t>(bitrate_) * 1000;
+    context_->gop_size = gop_;
+    // no frame reordering, the packets come out in the order of the frames
+    context_->max_b_frames = 0;
+    // the encoder runs on this thread only, besides the acquisition
+    context_->thread_count = 1;
+    av_opt_set(context_->priv_data, "preset", preset_.c_str(), 0);
+    av_opt_set(context_->priv_data, "tune", "zerolatency", 0);
+
+    // without global header, the parameter sets are repeated with each key frame
+    if (avcodec_open2(context_, codec, nullptr) < 0)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_VIDEO, "Failed to open the " << codec_ << " encoder (preset " << preset_ << ")");
+        this->close();
+        return false;
+    }
+
+    frame_ = av_frame_alloc();
+    frame_->format = context_->pix_fmt;
+    frame_->width = width;
+    frame_->height = height;
+    packet_ = av_packet_alloc();
+
+    // downscale and color conversion (including the debayering) in one pass
+    scaler_ = sws_getContext(image.width, image.height, input_format, width, height, AV_PIX_FMT_YUV420P,
+                             SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+
+    if (av_frame_get_buffer(frame_, 0) < 0 || packet_ == nullptr || scaler_ == nullptr)
+    {
+        RCLCPP_ERROR_STREAM(LOGGER_VIDEO, "Failed to allocate the " << codec_ << " encoder buffers");
+        this->close();
+        return false;
+    }
+
+    msg_.codec = codec_;
+    msg_.width = width;
+    msg_.height = height;
+
+    RCLCPP_INFO_STREAM(LOGGER_VIDEO, "Video encoder opened for " << image.width << "x" << image.height << " " << image.encoding
+                                     << " frames, encoded at " << width << "x" << height);
+    return true;
+}
+
+void VideoEncoder::close()
+{
+    sws_freeContext(scaler_);
+    scaler_ = nullptr;
+    av_packet_free(&packet_);
+    av_frame_free(&frame_);
+    avcodec_free_context(&context_);
+    headers_.clear();
+    pts_ = 0;
+}
+
+bool VideoEncoder::encode(const sensor_msgs::msg::Image& image)
+{
+    // a changed ROI, binning or pixel format needs a new encoder, starting with a key frame
+    if (image.encoding != input_encoding_ || image.width != input_width_ || image.height != input_height_)
+    {
+        this->open(image);
+    }
+
+    if (context_ == nullptr || image.data.size() < static_cast<size_t>(image.step) * image.height)
+    {
+        return false;
+    }
+
+    if (av_frame_make_writable(frame_) < 0)
+    {
+        return false;
+    }
+
+    const uint8_t* const src_data[4] = {image.data.data(), nullptr, nullptr, nullptr};
+    const int src_stride[4] = {static_cast<int>(image.step), 0, 0, 0};
+    sws_scale(scaler_, src_data, src_stride, 0, image.height, frame_->data, frame_->linesize);
+
+    frame_->pts = pts_++;
+    headers_.emplace_back(frame_->pts, image.header);
+
+    if (avcodec_send_frame(context_, frame_) < 0)
+    {
+        RCLCPP_WARN_STREAM_THROTTLE(LOGGER_VIDEO, clock_, 5000, "Failed to encode a video frame");
+        headers_.pop_back();
+        return false;
+    }
+
+    while (avcodec_receive_packet(context_, packet_) == 0)
+    {
+        // the packet gets the stamp of its frame
+        while (headers_.size() > 1 && headers_.front().first < packet_->pts)
+        {
+            headers_.pop_front();
+        }
+        if (!headers_.empty())
+        {
+            msg_.header = headers_.front().second;
+            headers_.pop_front();
+        }
+
+        msg_.is_keyframe = (packet_->flags & AV_PKT_FLAG_KEY) != 0;
+        msg_.data.assign(packet_->data, packet_->data + packet_->size);
+        av_packet_unref(packet_);
+
+        publish_(msg_);
+    }
+
+    return true;
+}
+
+}  // namespace pylon_ros2_camera
@@ -0,0 +1,1072 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pylon_ros2_camera.hpp"
+
+
+namespace pylon_ros2_camera
+{
+
+/**
+ * Simulated mono8 camera without any device: each grab fills the image with the frame
+ * counter, all the settings succeed. Used to run the node without pylon devices.
+ */
+class FakeCamera : public PylonROS2Camera
+{
+
+public:
+    /**
+     * @param rows number of image rows
+     * @param cols number of image columns
+     */
+    FakeCamera(const size_t& rows, const size_t& cols)
+    {
+        img_rows_ = rows;
+        img_cols_ = cols;
+        img_size_byte_ = rows * cols;
+        device_user_id_ = "fake_camera";
+    }
+
+    virtual ~FakeCamera()
+    {
+    }
+
+    bool openCamera() override
+    {
+        is_ready_ = true;
+        return true;
+    }
+
+    void getInitialCameraInfo(sensor_msgs::msg::CameraInfo& cam_info_msg) override
+    {
+        cam_info_msg.height = static_cast<uint32_t>(img_rows_);
+        cam_info_msg.width = static_cast<uint32_t>(img_cols_);
+    }
+
+    bool grab(std::vector<uint8_t>& image, rclcpp::Time&) override
+    {
+        // the buffer keeps its capacity, a grab of the same size does not allocate
+        image.resize(img_size_byte_);
+        ++last_frame_counter_;
+        std::fill(image.begin(), image.end(), static_cast<uint8_t>(last_frame_counter_));
+        return true;
+    }
+
+    bool grab(uint8_t* image) override
+    {
+        ++last_frame_counter_;
+        std::fill(image, image + img_size_byte_, static_cast<uint8_t>(last_frame_counter_));
+        return true;
+    }
+
+    sensor_msgs::msg::RegionOfInterest currentROI() override
+    {
+        sensor_msgs::msg::RegionOfInterest roi;
+        roi.width = static_cast<uint32_t>(img_cols_);
+        roi.height = static_cast<uint32_t>(img_rows_);
+        return roi;
+    }
+
+    bool registerCameraConfiguration() override
+    {
+        return true;
+    }
+
+    bool isCamRemoved() override
+    {
+        return false;
+    }
+
+    void releaseDevice() override
+    {
+    }
+
+    bool restartStream(const STREAM_RECOVERY_STEP&) override
+    {
+        return true;
+    }
+
+    bool setInternalThreadPriority(const int&) override
+    {
+        return true;
+    }
+
+    bool setHeartbeatTimeout(const int&) override
+    {
+        return true;
+    }
+
+    bool setupSequencer(const std::vector<float>&) override
+    {
+        return true;
+    }
+
+    bool applyCamSpecificStartupSettings(const PylonROS2CameraParameter&) override
+    {
+        return true;
+    }
+
+    bool startGrabbing(const PylonROS2CameraParameter&) override
+    {
+        return true;
+    }
+
+    bool isBlaze() override
+    {
+        return false;
+    }
+
+    bool grabBlaze(sensor_msgs::msg::PointCloud2&, sensor_msgs::msg::Image&, sensor_msgs::msg::Image&, sensor_msgs::msg::Image&, sensor_msgs::msg::Image&) override
+    {
+        return false;
+    }
+
+    bool grabBlaze(sensor_msgs::msg::PointCloud2&, sensor_msgs::msg::Image&, sensor_msgs::msg::Image&, sensor_msgs::msg::Image&, sensor_msgs::msg::Image&, sensor_msgs::msg::Image&) override
+    {
+        return false;
+    }
+
+    bool grabBlazeRaw(BlazeRawData&) override
+    {
+        return false;
+    }
+
+    bool blazeConversionSettings(BlazeConversionSettings&) override
+    {
+        return false;
+    }
+
+    bool setShutterMode(const pylon_ros2_camera::SHUTTER_MODE&) override
+    {
+        return true;
+    }
+
+    bool setROI(const sensor_msgs::msg::RegionOfInterest, sensor_msgs::msg::RegionOfInterest&) override
+    {
+        return true;
+    }
+
+    bool moveROI(const int64_t&, const int64_t&, sensor_msgs::msg::RegionOfInterest&) override
+    {
+        return true;
+    }
+
+    bool setMultipleROI(const std::vector<ROIZone>&, const std::vector<ROIZone>&, std::vector<ROIZone>&, std::vector<ROIZone>&) override
+    {
+        return true;
+    }
+
+    bool setBinningX(const size_t&, size_t&) override
+    {
+        return true;
+    }
+
+    bool setBinningY(const size_t&, size_t&) override
+    {
+        return true;
+    }
+
+    std::vector<std::string> detectAvailableImageEncodings(const bool&) override
+    {
+        return std::vector<std::string>(1, "Mono8");
+    }
+
+    std::string setImageEncoding(const std::string&) const override
+    {
+        return "done";
+    }
+
+    bool setExposure(const float&, float&) override
+    {
+        return true;
+    }
+
+    bool setAutoflash(const std::map<int, bool>) override
+    {
+        return true;
+    }
+
+    bool setGain(const float&, float&) override
+    {
+        return true;
+    }
+
+    bool setGamma(const float&, float&) override
+    {
+        return true;
+    }
+
+    bool setBrightness(const int&, const float&, const bool&, const bool&) override
+    {
+        return true;
+    }
+
+    std::vector<int> detectAndCountNumUserOutputs() override
+    {
+        return std::vector<int>();
+    }
+
+    bool setUserOutput(const int&, const bool&) override
+    {
+        return true;
+    }
+
+    size_t currentOffsetX() override
+    {
+        return 0;
+    }
+
+    size_t currentOffsetY() override
+    {
+        return 0;
+    }
+
+    size_t currentBinningX() override
+    {
+        return 1;
+    }
+
+    size_t currentBinningY() override
+    {
+        return 1;
+    }
+
+    std::string currentROSEncoding() const override
+    {
+        return "mono8";
+    }
+
+    std::string currentBaslerEncoding() const override
+    {
+        return "Mono8";
+    }
+
+    int imagePixelDepth() const override
+    {
+        return 1;
+    }
+
+    std::string outputROSEncoding() const override
+    {
+        return "mono8";
+    }
+
+    int outputPixelDepth() const override
+    {
+        return 1;
+    }
+
+    float currentExposure() override
+    {
+        return 0.0;
+    }
+
+    float currentAutoExposureTimeLowerLimit() override
+    {
+        return 0.0;
+    }
+
+    float currentAutoExposureTimeUpperLimit() override
+    {
+        return 0.0;
+    }
+
+    float currentGain() override
+    {
+        return 0.0;
+    }
+
+    float currentAutoGainLowerLimit() override
+    {
+        return 0.0;
+    }
+
+    float currentAutoGainUpperLimit() override
+    {
+        return 0.0;
+    }
+
+    float currentGamma() override
+    {
+        return 0.0;
+    }
+
+    bool isBrightnessSearchRunning() override
+    {
+        return false;
+    }
+
+    bool isPylonAutoBrightnessFunctionRunning() override
+    {
+        return false;
+    }
+
+    void disableAllRunningAutoBrightessFunctions() override
+    {
+    }
+
+    void enableContinuousAutoExposure() override
+    {
+    }
+
+    void enableContinuousAutoGain() override
+    {
+    }
+
+    std::string typeName() const override
+    {
+        return "Fake";
+    }
+
+    float exposureStep() override
+    {
+        return 0.0;
+    }
+
+    float maxPossibleFramerate() override
+    {
+        return 100.0;
+    }
+
+    std::string setOffsetXY(const int&, bool) override
+    {
+        return "done";
+    }
+
+    std::string reverseXY(const bool&, bool) override
+    {
+        return "done";
+    }
+
+    bool getReverseXY(const bool&) override
+    {
+        return false;
+    }
+
+    std::string setBlackLevel(const int&) override
+    {
+        return "done";
+    }
+
+    int getBlackLevel() override
+    {
+        return 0;
+    }
+
+    std::string setPGIMode(const bool&) override
+    {
+        return "done";
+    }
+
+    int getPGIMode() override
+    {
+        return 0;
+    }
+
+    std::string setDemosaicingMode(const int&) override
+    {
+        return "done";
+    }
+
+    int getDemosaicingMode() override
+    {
+        return 0;
+    }
+
+    std::string setNoiseReduction(const float&) override
+    {
+        return "done";
+    }
+
+    float getNoiseReduction() override
+    {
+        return 0.0;
+    }
+
+    std::string setSharpnessEnhancement(const float&) override
+    {
+        return "done";
+    }
+
+    float getSharpnessEnhancement() override
+    {
+        return 0.0;
+    }
+
+    std::string setLightSourcePreset(const int&) override
+    {
+        return "done";
+    }
+
+    int getLightSourcePreset() override
+    {
+        return 0;
+    }
+
+    std::string setBalanceWhiteAuto(const int&) override
+    {
+        return "done";
+    }
+
+    int getBalanceWhiteAuto() override
+    {
+        return 0;
+    }
+
+    std::string setSensorReadoutMode(const int&) override
+    {
+        return "done";
+    }
+
+    int getSensorReadoutMode() override
+    {
+        return 0;
+    }
+
+    std::string setAcquisitionFrameCount(const int&) override
+    {
+        return "done";
+    }
+
+    int getAcquisitionFrameCount() override
+    {
+        return 0;
+    }
+
+    std::string setTriggerSelector(const int&) override
+    {
+        return "done";
+    }
+
+    int getTriggerSelector() override
+    {
+        return 0;
+    }
+
+    std::string setTriggerMode(const bool&) override
+    {
+        return "done";
+    }
+
+    int getTriggerMode() override
+    {
+        return 0;
+    }
+
+    std::string executeSoftwareTrigger() override
+    {
+        return "done";
+    }
+
+    std::string setTriggerSource(const int&) override
+    {
+        return "done";
+    }
+
+    int getTriggerSource() override
+    {
+        return 0;
+    }
+
+    std::string setTriggerActivation(const int&) override
+    {
+        return "done";
+    }
+
+    int getTriggerActivation() override
+    {
+        return 0;
+    }
+
+    std::string setTriggerDelay(const float&) override
+    {
+        return "done";
+    }
+
+    float getTriggerDelay() override
+    {
+        return 0.0;
+    }
+
+    std::string setLineSelector(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setLineMode(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setLineSource(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setLineInverter(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string setLineDebouncerTime(const float&) override
+    {
+        return "done";
+    }
+
+    std::string setUserSetSelector(const int&) override
+    {
+        return "done";
+    }
+
+    int getUserSetSelector() override
+    {
+        return 0;
+    }
+
+    std::string saveUserSet() override
+    {
+        return "done";
+    }
+
+    std::string loadUserSet() override
+    {
+        return "done";
+    }
+
+    std::pair<std::string, std::string> getPfs() override
+    {
+        return std::make_pair(std::string(), std::string());
+    }
+
+    std::string savePfs(const std::string&) override
+    {
+        return "done";
+    }
+
+    std::string loadPfs(const std::string&) override
+    {
+        return "done";
+    }
+
+    bool applyStartupSnapshot(const std::string&) override
+    {
+        return false;
+    }
+
+    std::string setUserSetDefaultSelector(const int&) override
+    {
+        return "done";
+    }
+
+    int getUserSetDefaultSelector() override
+    {
+        return 0;
+    }
+
+    std::string setDeviceLinkThroughputLimitMode(const bool&) override
+    {
+        return "done";
+    }
+
+    int getDeviceLinkThroughputLimitMode() override
+    {
+        return 0;
+    }
+
+    std::string setDeviceLinkThroughputLimit(const int&) override
+    {
+        return "done";
+    }
+
+    std::string triggerDeviceReset() override
+    {
+        return "done";
+    }
+
+    std::string grabbingStarting() const override
+    {
+        return "done";
+    }
+
+    std::string grabbingStopping() override
+    {
+        return "done";
+    }
+
+    std::string setMaxTransferSize(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setGammaSelector(const int&) override
+    {
+        return "done";
+    }
+
+    std::string gammaEnable(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string setLookupTable(const std::vector<uint16_t>&) override
+    {
+        return "done";
+    }
+
+    float getTemperature() override
+    {
+        return 0.0;
+    }
+
+    std::string setWhiteBalance(const double&, const double&, const double&) override
+    {
+        return "done";
+    }
+
+    bool setGrabbingStrategy(const int&) override
+    {
+        return true;
+    }
+
+    std::string setOutputQueueSize(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setMaxNumBuffer(const int&) override
+    {
+        return "done";
+    }
+
+    int getMaxNumBuffer() override
+    {
+        return 0;
+    }
+
+    int getStatisticTotalBufferCount() override
+    {
+        return 0;
+    }
+
+    int getStatisticFailedBufferCount() override
+    {
+        return 0;
+    }
+
+    int getStatisticBufferUnderrunCount() override
+    {
+        return 0;
+    }
+
+    int getStatisticFailedPacketCount() override
+    {
+        return 0;
+    }
+
+    int getStatisticResendRequestCount() override
+    {
+        return 0;
+    }
+
+    int getStatisticMissedFrameCount() override
+    {
+        return 0;
+    }
+
+    int getStatisticResynchronizationCount() override
+    {
+        return 0;
+    }
+
+    std::string setChunkModeActive(const bool&) override
+    {
+        return "done";
+    }
+
+    int getChunkModeActive() override
+    {
+        return 0;
+    }
+
+    std::string setChunkSelector(const int&) override
+    {
+        return "done";
+    }
+
+    int getChunkSelector() override
+    {
+        return 0;
+    }
+
+    std::string setChunkEnable(const bool&) override
+    {
+        return "done";
+    }
+
+    int getChunkEnable() override
+    {
+        return 0;
+    }
+
+    int64_t getChunkTimestamp() override
+    {
+        return 0;
+    }
+
+    float getChunkExposureTime() override
+    {
+        return 0.0;
+    }
+
+    std::string setChunkExposureTime(const float&) override
+    {
+        return "done";
+    }
+
+    int64_t getChunkLineStatusAll() override
+    {
+        return 0;
+    }
+
+    int64_t getChunkFramecounter() override
+    {
+        return 0;
+    }
+
+    int64_t getChunkCounterValue() override
+    {
+        return 0;
+    }
+
+    std::string setTimerSelector(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setTimerTriggerSource(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setTimerDuration(const float&) override
+    {
+        return "done";
+    }
+
+    std::string setPTPPriority(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setPTPProfile(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setPTPNetworkMode(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setPTPUCPortAddressIndex(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setPTPUCPortAddress(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setPeriodicSignalPeriod(const float&) override
+    {
+        return "done";
+    }
+
+    std::string setPeriodicSignalDelay(const float&) override
+    {
+        return "done";
+    }
+
+    std::string setSyncFreeRunTimerStartTimeLow(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setSyncFreeRunTimerStartTimeHigh(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setSyncFreeRunTimerTriggerRateAbs(const float&) override
+    {
+        return "done";
+    }
+
+    std::string enablePTPManagementProtocol(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string enablePTPTwoStepOperation(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string enablePTP(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string enableSyncFreeRunTimer(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string updateSyncFreeRunTimer() override
+    {
+        return "done";
+    }
+
+    std::string setActionTriggerConfiguration(const int&, const int&, const unsigned int&, const int&, const int&) override
+    {
+        return "done";
+    }
+
+    std::string issueActionCommand(const int&, const int&, const unsigned int&, const std::string&) override
+    {
+        return "done";
+    }
+
+    std::string issueScheduledActionCommand(const int&, const int&, const unsigned int&, const int64_t&, const std::string&) override
+    {
+        return "done";
+    }
+
+    std::string setDepthMin(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setDepthMax(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setTemporalFilterStrength(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setOutlierRemovalThreshold(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setOutlierRemovalTolerance(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setAmbiguityFilterThreshold(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setConfidenceThreshold(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setIntensityCalculation(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setExposureTimeSelector(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setOperatingMode(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setMultiCameraChannel(const int&) override
+    {
+        return "done";
+    }
+
+    std::string setAcquisitionFrameRate(const float&) override
+    {
+        return "done";
+    }
+
+    std::string setScan3dCalibrationOffset(const float&) override
+    {
+        return "done";
+    }
+
+    std::string enableSpatialFilter(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string enableTemporalFilter(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string enableOutlierRemoval(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string enableAmbiguityFilter(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string enableThermalDriftCorrection(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string enableDistortionCorrection(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string enableAcquisitionFrameRate(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string enableHDRMode(const bool&) override
+    {
+        return "done";
+    }
+
+    std::string enableFastMode(const bool&) override
+    {
+        return "done";
+    }
+
+    bool setExtendedBrightness(const int&, const float&) override
+    {
+        return true;
+    }
+};
+
+/**
+ * Simulated blaze without any device: each grab fills the point cloud and the maps, of the
+ * size of the camera, with the frame counter. Used to run the blaze path of the node.
+ */
+class FakeBlazeCamera : public FakeCamera
+{
+
+public:
+    /**
+     * @param rows number of image rows
+     * @param cols number of image columns
+     */
+    FakeBlazeCamera(const size_t& rows, const size_t& cols)
+      : FakeCamera(rows, cols)
+    {
+    }
+
+    virtual ~FakeBlazeCamera()
+    {
+    }
+
+    bool isBlaze() override
+    {
+        return true;
+    }
+
+    bool grabBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
+                   sensor_msgs::msg::Image& intensity_map_msg,
+                   sensor_msgs::msg::Image& depth_map_msg,
+                   sensor_msgs::msg::Image& depth_map_color_msg,
+                   sensor_msgs::msg::Image& confidence_map_msg) override
+    {
+        ++last_frame_counter_;
+        const uint8_t value = static_cast<uint8_t>(last_frame_counter_);
+
+        // x, y, z and rgb as float, the buffers keep their capacity from frame to frame
+        cloud_msg.height = static_cast<uint32_t>(img_rows_);
+        cloud_msg.width = static_cast<uint32_t>(img_cols_);
+        cloud_msg.point_step = 4 * sizeof(float);
+        cloud_msg.row_step = cloud_msg.point_step * cloud_msg.width;
+        cloud_msg.data.resize(static_cast<size_t>(cloud_msg.row_step) * cloud_msg.height);
+        std::fill(cloud_msg.data.begin(), cloud_msg.data.end(), value);
+
+        fillMap(intensity_map_msg, "mono16", sizeof(uint16_t), value);
+        fillMap(depth_map_msg, "mono16", sizeof(uint16_t), value);
+        fillMap(depth_map_color_msg, "bgr8", 3, value);
+        fillMap(confidence_map_msg, "mono16", sizeof(uint16_t), value);
+        return true;
+    }
+
+    bool grabBlaze(sensor_msgs::msg::PointCloud2& cloud_msg,
+                   sensor_msgs::msg::Image& intensity_map_msg,
+                   sensor_msgs::msg::Image& depth_map_msg,
+                   sensor_msgs::msg::Image& depth_map_color_msg,
+                   sensor_msgs::msg::Image& confidence_map_msg,
+                   sensor_msgs::msg::Image& depth_image_msg) override
+    {
+        if (!this->grabBlaze(cloud_msg, intensity_map_msg, depth_map_msg, depth_map_color_msg, confidence_map_msg))
+        {
+            return false;
+        }
+        fillMap(depth_image_msg, "32FC1", sizeof(float), static_cast<uint8_t>(last_frame_counter_));
+        return true;
+    }
+
+private:
+    void fillMap(sensor_msgs::msg::Image& msg, const char* encoding, const size_t& pixel_size, const uint8_t& value)
+    {
+        msg.height = static_cast<uint32_t>(img_rows_);
+        msg.width = static_cast<uint32_t>(img_cols_);
+        msg.encoding = encoding;
+        msg.step = static_cast<uint32_t>(img_cols_ * pixel_size);
+        msg.data.resize(static_cast<size_t>(msg.step) * msg.height);
+        std::fill(msg.data.begin(), msg.data.end(), value);
+    }
+};
+
+}  // namespace pylon_ros2_camera
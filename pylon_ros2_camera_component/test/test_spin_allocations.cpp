@@ -0,0 +1,279 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include "pylon_ros2_camera_node.hpp"
+#include "cv_mat_type_adapter.hpp"
+#include "fake_camera.hpp"
+
+
+namespace
+{
+  // only the allocations of the thread running the frame loop are counted, the
+  // middleware threads keep allocating in the background
+  thread_local bool is_counting_allocations = false;
+  std::atomic<size_t> allocation_count(0);
+
+  const std::string NODE_PREFIX = "/pylon_ros2_camera_node/";
+
+  // node grabbing from a simulated camera, with the frame loop run by the test
+  class SpinTestNode : public pylon_ros2_camera::PylonROS2CameraNode
+  {
+  public:
+    SpinTestNode(const rclcpp::NodeOptions& options, const std::function<pylon_ros2_camera::PylonROS2Camera*()>& camera_factory)
+      : PylonROS2CameraNode(options, camera_factory)
+    {}
+
+    using PylonROS2CameraNode::spin;
+
+    int64_t frameCounter() const
+    {
+      return this->pylon_camera_->frameCounter();
+    }
+  };
+
+  std::shared_ptr<SpinTestNode> createAreaScanNode(const rclcpp::NodeOptions& options)
+  {
+    return std::make_shared<SpinTestNode>(options, []() { return new pylon_ros2_camera::FakeCamera(480, 640); });
+  }
+
+  std::vector<rclcpp::Parameter> defaultParameters()
+  {
+    return {rclcpp::Parameter("enable_status_publisher", false),
+            rclcpp::Parameter("enable_current_params_publisher", false)};
+  }
+
+  // calibration of the simulated camera, with a distortion so that the image is actually remapped
+  std::string writeCalibration()
+  {
+    const std::string path = "/tmp/pylon_ros2_camera_test_" + std::to_string(getpid()) + ".yaml";
+    FILE* file = std::fopen(path.c_str(), "w");
+    std::fputs("image_width: 640\n"
+               "image_height: 480\n"
+               "camera_name: fake_camera\n"
+               "camera_matrix: {rows: 3, cols: 3, data: [500, 0, 320, 0, 500, 240, 0, 0, 1]}\n"
+               "distortion_model: plumb_bob\n"
+               "distortion_coefficients: {rows: 1, cols: 5, data: [-0.1, 0.01, 0, 0, 0]}\n"
+               "rectification_matrix: {rows: 3, cols: 3, data: [1, 0, 0, 0, 1, 0, 0, 0, 1]}\n"
+               "projection_matrix: {rows: 3, cols: 4, data: [500, 0, 320, 0, 0, 500, 240, 0, 0, 0, 1, 0]}\n",
+               file);
+    std::fclose(file);
+    return "file://" + path;
+  }
+
+  // waits for the discovery of the subscriptions of the given topics
+  bool waitForSubscriptions(const rclcpp::Node::SharedPtr& node, const std::vector<std::string>& topics)
+  {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (const std::string& topic : topics)
+    {
+      while (node->count_subscribers(topic) == 0)
+      {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+          return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
+    return true;
+  }
+
+  // runs the frame loop and returns the number of allocations of the counted frames; the subscribers,
+  // if any, receive and release the frames between two loops, their allocations are not counted
+  size_t countSpinAllocations(SpinTestNode& node, const rclcpp::Node::SharedPtr& subscriber_node,
+                              const int& warm_up_frames, const int& frames)
+  {
+    rclcpp::executors::SingleThreadedExecutor executor;
+    if (subscriber_node)
+    {
+      executor.add_node(subscriber_node);
+    }
+
+    // the first frames size the buffers and fill the pools
+    for (int i = 0; i < warm_up_frames; ++i)
+    {
+      node.spin();
+      executor.spin_some();
+    }
+
+    allocation_count = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+      is_counting_allocations = true;
+      node.spin();
+      is_counting_allocations = false;
+      executor.spin_some();
+    }
+    return allocation_count.load();
+  }
+}
+
+void* operator new(std::size_t size)
+{
+  if (is_counting_allocations)
+  {
+    ++allocation_count;
+  }
+
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+TEST(SpinAllocations, NoAllocationAfterWarmUp)
+{
+  // the shared-memory output is grabbed for without any subscriber
+  std::vector<rclcpp::Parameter> parameters = defaultParameters();
+  parameters.emplace_back("shm/name", "/pylon_ros2_camera_test_" + std::to_string(getpid()));
+  rclcpp::NodeOptions options;
+  options.parameter_overrides(parameters);
+
+  auto node = createAreaScanNode(options);
+  ASSERT_TRUE(node->isInitialized());
+
+  const int warm_up_frames = 10;
+  const int frames = 100;
+  EXPECT_EQ(0u, countSpinAllocations(*node, nullptr, warm_up_frames, frames));
+  EXPECT_EQ(warm_up_frames + frames, node->frameCounter() + 1);
+}
+
+TEST(SpinAllocations, SubscribedImages)
+{
+  // raw and rectified images published through image_transport to another node
+  std::vector<rclcpp::Parameter> parameters = defaultParameters();
+  parameters.emplace_back("camera_info_url", writeCalibration());
+  rclcpp::NodeOptions options;
+  options.parameter_overrides(parameters);
+
+  auto node = createAreaScanNode(options);
+  ASSERT_TRUE(node->isInitialized());
+
+  size_t received = 0;
+  auto subscriber_node = std::make_shared<rclcpp::Node>("image_subscriber");
+  auto on_image = [&received](const sensor_msgs::msg::Image::ConstSharedPtr&) { ++received; };
+  auto raw_sub = subscriber_node->create_subscription<sensor_msgs::msg::Image>(NODE_PREFIX + "image_raw", 10, on_image);
+  auto rect_sub = subscriber_node->create_subscription<sensor_msgs::msg::Image>(NODE_PREFIX + "image_rect", 10, on_image);
+  ASSERT_TRUE(waitForSubscriptions(node, {NODE_PREFIX + "image_raw", NODE_PREFIX + "image_rect"}));
+
+  // the OpenCV thread pool allocates a job per parallel call, the rectification runs in the frame loop thread
+  const int threads = cv::getNumThreads();
+  cv::setNumThreads(0);
+  EXPECT_EQ(0u, countSpinAllocations(*node, subscriber_node, 10, 100));
+  cv::setNumThreads(threads);
+  EXPECT_GT(received, 0u);
+}
+
+TEST(SpinAllocations, TypeAdaptedImages)
+{
+  // raw and rectified images handed over as cv::Mat to a subscriber of the same process
+  std::vector<rclcpp::Parameter> parameters = defaultParameters();
+  parameters.emplace_back("camera_info_url", writeCalibration());
+  parameters.emplace_back("intra_process_images", true);
+  rclcpp::NodeOptions options;
+  options.parameter_overrides(parameters);
+  options.use_intra_process_comms(true);
+
+  auto node = createAreaScanNode(options);
+  ASSERT_TRUE(node->isInitialized());
+
+  size_t received = 0;
+  auto subscriber_node = std::make_shared<rclcpp::Node>("image_subscriber", rclcpp::NodeOptions().use_intra_process_comms(true));
+  auto on_image = [&received](std::unique_ptr<pylon_ros2_camera::CvMatImage>) { ++received; };
+  auto raw_sub = subscriber_node->create_subscription<pylon_ros2_camera::CvMatImage>(NODE_PREFIX + "image_raw", 10, on_image);
+  auto rect_sub = subscriber_node->create_subscription<pylon_ros2_camera::CvMatImage>(NODE_PREFIX + "image_rect", 10, on_image);
+  ASSERT_TRUE(waitForSubscriptions(node, {NODE_PREFIX + "image_raw", NODE_PREFIX + "image_rect"}));
+
+  const int threads = cv::getNumThreads();
+  cv::setNumThreads(0);
+  EXPECT_EQ(0u, countSpinAllocations(*node, subscriber_node, 10, 100));
+  cv::setNumThreads(threads);
+  EXPECT_GT(received, 0u);
+}
+
+TEST(SpinAllocations, SubscribedBlaze)
+{
+  // point cloud, maps and metric depth image published to another node
+  rclcpp::NodeOptions options;
+  options.parameter_overrides(defaultParameters());
+
+  auto node = std::make_shared<SpinTestNode>(options, []() { return new pylon_ros2_camera::FakeBlazeCamera(480, 640); });
+  ASSERT_TRUE(node->isInitialized());
+
+  size_t received = 0;
+  auto subscriber_node = std::make_shared<rclcpp::Node>("blaze_subscriber");
+  auto cloud_sub = subscriber_node->create_subscription<sensor_msgs::msg::PointCloud2>(NODE_PREFIX + "blaze_cloud", 10,
+    [&received](const sensor_msgs::msg::PointCloud2::ConstSharedPtr&) { ++received; });
+  auto depth_sub = subscriber_node->create_subscription<sensor_msgs::msg::Image>(NODE_PREFIX + "depth/image_raw", 10,
+    [&received](const sensor_msgs::msg::Image::ConstSharedPtr&) { ++received; });
+  ASSERT_TRUE(waitForSubscriptions(node, {NODE_PREFIX + "blaze_cloud", NODE_PREFIX + "depth/image_raw"}));
+
+  const int warm_up_frames = 10;
+  const int frames = 100;
+  EXPECT_EQ(0u, countSpinAllocations(*node, subscriber_node, warm_up_frames, frames));
+  EXPECT_EQ(warm_up_frames + frames, node->frameCounter() + 1);
+  EXPECT_GT(received, 0u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  rclcpp::init(argc, argv);
+  const int result = RUN_ALL_TESTS();
+  rclcpp::shutdown();
+  return result;
+}
@@ -0,0 +1,134 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#include <sensor_msgs/image_encodings.hpp>
+#include <sensor_msgs/msg/image.hpp>
+
+#include "video_decoder.hpp"
+#include "video_encoder.hpp"
+
+
+namespace
+{
+    const uint32_t WIDTH = 320;
+    const uint32_t HEIGHT = 240;
+
+    // smooth pattern moving from frame to frame, so that the encoder keeps it at a high bitrate
+    uint8_t pixel(const uint32_t& x, const uint32_t& y, const int& index)
+    {
+        return static_cast<uint8_t>((x * 160 / WIDTH) + (y * 80 / HEIGHT) + index);
+    }
+
+    sensor_msgs::msg::Image syntheticFrame(const int& index)
+    {
+        sensor_msgs::msg::Image image;
+        image.header.stamp.sec = index;
+        image.header.frame_id = "camera";
+        image.encoding = sensor_msgs::image_encodings::MONO8;
+        image.width = WIDTH;
+        image.height = HEIGHT;
+        image.step = WIDTH;
+        image.data.resize(WIDTH * HEIGHT);
+        for (uint32_t y = 0; y < HEIGHT; ++y)
+        {
+            for (uint32_t x = 0; x < WIDTH; ++x)
+            {
+                image.data[y * WIDTH + x] = pixel(x, y, index);
+            }
+        }
+        return image;
+    }
+}
+
+TEST(VideoRoundTrip, H264FramesDecodeToTheirSizeAndContent)
+{
+    using pylon_ros2_camera::VideoEncoder;
+
+    std::vector<VideoEncoder::VideoPacket> packets;
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    VideoEncoder encoder;
+    ASSERT_TRUE(encoder.start("h264", 20000, 10, "ultrafast", 1.0, 30.0, nullptr,
+                              [&](const VideoEncoder::VideoPacket& packet)
+                              {
+                                  std::lock_guard<std::mutex> lock(mutex);
+                                  packets.push_back(packet);
+                                  condition.notify_all();
+                              }));
+
+    // a frame waiting for the encoder is replaced by the next one: each frame is waited for,
+    // the zero latency tuning returns one packet per frame
+    const int nr_frames = 15;
+    for (int i = 0; i < nr_frames; ++i)
+    {
+        ASSERT_TRUE(encoder.post(syntheticFrame(i)));
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(condition.wait_for(lock, std::chrono::seconds(5),
+                                       [&]() { return packets.size() == static_cast<size_t>(i + 1); }));
+    }
+    encoder.stop();
+
+    ASSERT_TRUE(packets.front().is_keyframe);
+
+    pylon_ros2_camera::VideoDecoder decoder;
+    sensor_msgs::msg::Image decoded;
+    for (int i = 0; i < nr_frames; ++i)
+    {
+        const VideoEncoder::VideoPacket& packet = packets[i];
+        EXPECT_EQ("h264", packet.codec);
+        EXPECT_EQ(i, packet.header.stamp.sec);
+        ASSERT_TRUE(decoder.decode(packet, decoded, sensor_msgs::image_encodings::MONO8));
+
+        ASSERT_EQ(WIDTH, decoded.width);
+        ASSERT_EQ(HEIGHT, decoded.height);
+        ASSERT_EQ(sensor_msgs::image_encodings::MONO8, decoded.encoding);
+        ASSERT_GE(decoded.step, WIDTH);
+        ASSERT_GE(decoded.data.size(), static_cast<size_t>(decoded.step) * HEIGHT);
+
+        // lossy, but close to the synthetic frame
+        uint64_t difference = 0;
+        for (uint32_t y = 0; y < HEIGHT; ++y)
+        {
+            for (uint32_t x = 0; x < WIDTH; ++x)
+            {
+                difference += std::abs(static_cast<int>(decoded.data[y * decoded.step + x]) - static_cast<int>(pixel(x, y, i)));
+            }
+        }
+        EXPECT_LT(static_cast<double>(difference) / (WIDTH * HEIGHT), 3.0) << "frame " << i;
+    }
+}
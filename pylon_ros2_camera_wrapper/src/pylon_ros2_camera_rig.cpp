@@ -0,0 +1,154 @@
+/******************************************************************************
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (C) 2022, Basler AG. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * No contributors' name may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include <rclcpp/rclcpp.hpp>
+#include <rcutils/logging_macros.h>
+
+#include <pylon_ros2_camera_component/pylon_ros2_camera_node.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Brings up several cameras in a single process. Each camera node is created in its own
+// worker thread, so that opening, configuring and starting the cameras happen in parallel
+// and share the same device enumeration. A camera failing to start does not affect the others.
+//
+// Usage: pylon_ros2_camera_rig camera_id_1 [camera_id_2 ...] [--ros-args --params-file rig.yaml]
+// The camera ids are used as node namespaces: /camera_id/pylon_ros2_camera_node
+int main(int argc, char * argv[])
+{
+  // Force flush of the stdout buffer.
+  setvbuf(stdout, NULL, _IONBF, BUFSIZ);
+
+  std::vector<std::string> camera_ids = rclcpp::init_and_remove_ros_arguments(argc, argv);
+  camera_ids.erase(camera_ids.begin());
+
+  const rclcpp::Logger logger = rclcpp::get_logger("basler.pylon.ros2.pylon_ros2_camera_rig");
+
+  if (camera_ids.empty())
+  {
+    RCLCPP_ERROR(logger, "No camera id given. Usage: pylon_ros2_camera_rig camera_id_1 [camera_id_2 ...] [--ros-args ...]");
+    rclcpp::shutdown();
+    return EXIT_FAILURE;
+  }
+
+  // executor responsible for execution of callbacks for all camera nodes
+  rclcpp::executors::MultiThreadedExecutor exec;
+  std::mutex nodes_mutex;
+  std::vector<std::shared_ptr<pylon_ros2_camera::PylonROS2CameraNode>> nodes;
+
+  const auto rig_start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> workers;
+  for (const auto& camera_id : camera_ids)
+  {
+    workers.emplace_back([&, camera_id]()
+    {
+      const auto camera_start = std::chrono::steady_clock::now();
+
+      rclcpp::NodeOptions options;
+      options.automatically_declare_parameters_from_overrides(true);
+      options.arguments({"--ros-args", "-r", "__ns:=/" + camera_id});
+      // a failing camera must not shut down the other ones
+      options.parameter_overrides({rclcpp::Parameter("shutdown_on_init_failure", false)});
+
+      try
+      {
+        auto node = std::make_shared<pylon_ros2_camera::PylonROS2CameraNode>(options);
+        const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - camera_start);
+
+        if (!node->isInitialized())
+        {
+          RCLCPP_ERROR_STREAM(logger, "Camera " << camera_id << " could not be started");
+          return;
+        }
+
+        RCLCPP_INFO_STREAM(logger, "Camera " << camera_id << " started in " << duration.count() << " ms");
+
+        std::lock_guard<std::mutex> lock(nodes_mutex);
+        nodes.push_back(node);
+        exec.add_node(node);
+      }
+      catch (const std::exception& e)
+      {
+        RCLCPP_ERROR_STREAM(logger, "Camera " << camera_id << " could not be started: " << e.what());
+      }
+    });
+  }
+
+  // the cameras already started are spun while the other ones are still starting
+  std::atomic<bool> is_any_camera_started(true);
+  std::thread startup_monitor([&]()
+  {
+    for (auto& worker : workers)
+    {
+      worker.join();
+    }
+
+    std::lock_guard<std::mutex> lock(nodes_mutex);
+    RCLCPP_INFO_STREAM(logger, nodes.size() << " of " << camera_ids.size() << " cameras started in "
+                               << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - rig_start).count()
+                               << " ms");
+
+    // nothing left to spin: the executor is stopped through the context, which also covers
+    // an executor that did not enter spin() yet
+    if (nodes.empty())
+    {
+      RCLCPP_FATAL(logger, "None of the cameras could be started");
+      is_any_camera_started = false;
+      rclcpp::shutdown();
+    }
+  });
+
+  int result = EXIT_SUCCESS;
+  try
+  {
+    exec.spin();
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "Impossible to spin" << std::endl;
+    std::cerr << e.what() << std::endl;
+    result = EXIT_FAILURE;
+  }
+
+  rclcpp::shutdown();
+  startup_monitor.join();
+
+  if (!is_any_camera_started)
+  {
+    result = EXIT_FAILURE;
+  }
+
+  return result;
+}